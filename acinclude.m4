@@ -680,5 +680,38 @@ AC_DEFUN([AC_C_LONG_LONG],
      HAVE_LONG_LONG=0
    fi
 ])
-
-
+dnl --------------------------------------------------------------------------
+dnl @synopsis AC_USE_THREADS
+dnl
+dnl See whether the compiler has std::thread, and what flags it needs
+dnl
+dnl @author Richard Smith <richard@ex-parrot.com>
+dnl
+AC_DEFUN([AC_USE_THREADS],
+ [AC_CACHE_CHECK(
+    [for std::thread],
+    [ac_cv_use_threads],
+    [AC_LANG_PUSH(C++)
+     ac_use_threads_save_CXXFLAGS="$CXXFLAGS"
+     for flags in -pthread ""; do
+       if test -z "$ac_cv_use_threads"; then
+         CXXFLAGS="$ac_use_threads_save_CXXFLAGS $flags"
+         AC_LINK_IFELSE(
+           [AC_LANG_PROGRAM(
+             [#include <thread>
+             ], [std::thread t([]{}); t.join();])],
+           ac_cv_use_threads="yes $flags")
+       fi
+     done
+     CXXFLAGS="$ac_use_threads_save_CXXFLAGS"
+     test -z "$ac_cv_use_threads" && ac_cv_use_threads=no
+     AC_LANG_POP(C++)
+  ])
+  if test "$ac_cv_use_threads" != no ; then
+    THREAD_FLAGS=[`echo "$ac_cv_use_threads" | sed 's/^yes *//'`]
+    USE_THREADS=1
+  else
+    THREAD_FLAGS=[]
+    USE_THREADS=0
+  fi
+])
@@ -1,5 +1,5 @@
 // -*- C++ -*- extent.cpp - utility print an extent 
-// Copyright (C) 2007, 2011 Richard Smith <richard@ex-parrot.com>
+// Copyright (C) 2007, 2011, 2026 Richard Smith <richard@ex-parrot.com>
 
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -24,14 +24,28 @@
 
 #if RINGING_HAVE_OLD_IOSTREAMS
 #include <iostream.h>
+#include <sstream.h>
 #else
 #include <iostream>
+#include <sstream>
 #endif
 
 #if RINGING_OLD_INCLUDES
 #include <iterator.h>
+#include <vector.h>
+#include <stdexcept.h>
 #else
 #include <iterator>
+#include <vector>
+#include <stdexcept>
+#endif
+
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#include <string.h>
+#else
+#include <cstdio>
+#include <cstring>
 #endif
 
 #include "args.h"
@@ -48,6 +62,12 @@ struct arguments
 
   init_val<bool,false> in_course;
 
+  string order;
+  string start_str, count_str;
+
+  bool plain_changes;
+  RINGING_ULLONG start, count;
+
   void bind( arg_parser& p );
   bool validate( arg_parser& p );
 };
@@ -76,6 +96,34 @@ void arguments::bind( arg_parser& p )
          ( 'i', "in-course",
 	   "Only list in-course rows",
            in_course ) );
+
+  p.add( new string_opt
+         ( 'o', "order",
+           "List the rows in lexicographical order (ORDER = 'lex', the "
+           "default) or as plain changes (ORDER = 'plain'), where each "
+           "row differs from the last by swapping one adjacent pair",
+           "ORDER", order ) );
+
+  p.add( new string_opt
+         ( 's', "start",
+           "Start with the row at position NUM in the order, counting "
+           "from 0", "NUM", start_str ) );
+
+  p.add( new string_opt
+         ( 'n', "count",
+           "List at most NUM rows", "NUM", count_str ) );
+}
+
+static bool parse_count( arg_parser& ap, string const& opt, 
+                         string const& str, RINGING_ULLONG& val )
+{
+  istringstream in( str );
+  if ( !( in >> val ) || in.peek() != EOF || str[0] == '-' ) 
+    {
+      ap.error( "The argument to --" + opt + " must be a number" );
+      return false;
+    }
+  return true;
 }
 
 bool arguments::validate( arg_parser& ap )
@@ -94,9 +142,192 @@ bool arguments::validate( arg_parser& ap )
       return false;
     }
 
+  if ( order.empty() || order == "lex" )
+    plain_changes = false;
+  else if ( order == "plain" )
+    plain_changes = true;
+  else
+    {
+      ap.error( "Unknown order: " + order );
+      return false;
+    }
+
+  start = 0; count = (RINGING_ULLONG) -1;
+  if ( ( start_str.size() 
+         && !parse_count( ap, "start", start_str, start ) ) ||
+       ( count_str.size() 
+         && !parse_count( ap, "count", count_str, count ) ) )
+    return false;
+
   return true;
 }
 
+// Writes rows to stdout through a large buffer, which is much quicker
+// than formatting each row on an ostream
+class row_writer
+{
+public:
+  explicit row_writer( size_t len ) : buf( 1u << 20 ), pos(0), len(len) {}
+  ~row_writer() { if ( pos ) fwrite( &buf[0], 1, pos, stdout ); }
+
+  void write( char const* line ) {
+    if ( pos + len > buf.size() ) flush();
+    memcpy( &buf[pos], line, len ); 
+    pos += len;
+  }
+
+  void flush() {
+    if ( fwrite( &buf[0], 1, pos, stdout ) != pos )
+      throw runtime_error( "Unable to write rows" );
+    pos = 0;
+  }
+
+private:
+  vector<char> buf;
+  size_t pos, len;
+};
+
+// The state shared by the generators: the working bells, numbered
+// from 1 so that a[1..nw] are the working bells, and the line of output
+class row_generator
+{
+public:
+  char const* line() const { return &ln[0]; }
+  int sign() const { return sgn; }
+
+protected:
+  row_generator( unsigned nw, unsigned nh, unsigned nt ) 
+    : nw(nw), nh(nh), a( nw+1 ), ln( nt+1 ), sgn(+1)
+  {
+    for ( unsigned i = 0; i < nt; ++i ) ln[i] = bell(i).to_char();
+    ln[nt] = '\n';
+    for ( unsigned i = 1; i <= nw; ++i ) a[i] = i;
+  }
+
+  // Copy working bell a[i] into the output line
+  void set_line( unsigned i ) { ln[ nh+i-1 ] = bell( nh+a[i]-1 ).to_char(); }
+
+  void set_line() { for ( unsigned i = 1; i <= nw; ++i ) set_line(i); }
+
+  unsigned nw, nh;
+  vector<unsigned char> a;
+  vector<char> ln;
+  int sgn;
+};
+
+// Steps through the extent in lexicographical order, as extent_iterator
+// does, but updating a single row in place
+class lex_generator : public row_generator
+{
+public:
+  lex_generator( unsigned nw, unsigned nh, unsigned nt, RINGING_ULLONG n )
+    : row_generator( nw, nh, nt )
+  {
+    if ( n ) {
+      extent_ranker rk( nw, nh, nt );
+      if ( n >= rk.size() ) throw out_of_range( "Start is past the end" );
+      vector<bell> v( nt );
+      sgn = rk.unrank( n, &v[0] );
+      for ( unsigned i = 1; i <= nw; ++i ) a[i] = v[nh+i-1] - nh + 1;
+      set_line();
+    }
+  }
+
+  bool next() {
+    // As next_permutation, but keeping track of the sign
+    unsigned i = nw;
+    while ( i > 1 && a[i-1] > a[i] ) --i;
+    if ( i <= 1 ) return false;
+    unsigned j = nw;
+    while ( a[j] < a[i-1] ) --j;
+    swap( a[i-1], a[j] );
+    set_line( i-1 ); 
+    if ( (nw - i + 1) / 2 % 2 == 0 ) sgn = -sgn;
+    for ( unsigned k = i, l = nw; k < l; ++k, --l ) swap( a[k], a[l] );
+    for ( ; i <= nw; ++i ) set_line(i);
+    return true;
+  }
+};
+
+// Steps through the extent as plain changes, otherwise known as the 
+// Steinhaus-Johnson-Trotter order.  This is Algorithm P from Knuth, 
+// TAOCP 7.2.1.2: c[j] is the number of bells less than j to the right 
+// of j, and o[j] the direction j is moving in.
+class plain_generator : public row_generator
+{
+public:
+  plain_generator( unsigned nw, unsigned nh, unsigned nt, RINGING_ULLONG n )
+    : row_generator( nw, nh, nt ), c( nw+1 ), o( nw+1, +1 )
+  {
+    if ( n ) {
+      extent_ranker rk( nw, nh, nt );
+      if ( n >= rk.size() ) throw out_of_range( "Start is past the end" );
+      sgn = n % 2 ? -1 : +1;
+
+      // The order is a reflected mixed-radix Gray code in c[1..nw], with
+      // c[nw] changing most quickly.  Each digit runs backwards if the
+      // count of the digits before it is odd.
+      RINGING_ULLONG b = n;
+      for ( unsigned j = nw; j >= 1; --j ) {
+        RINGING_ULLONG const d = b % j;
+        b /= j;
+        c[j] = b % 2 ? j-1-d : d;
+        o[j] = b % 2 ? -1 : +1;
+      }
+
+      // Put each bell in turn in with c[j] smaller bells to its right
+      for ( unsigned j = 1; j <= nw; ++j ) {
+        unsigned const p = j - c[j];
+        for ( unsigned k = j; k > p; --k ) a[k] = a[k-1];
+        a[p] = j;
+      }
+      set_line();
+    }
+  }
+
+  bool next() {
+    if ( nw == 0 ) return false;
+
+    unsigned j = nw, s = 0;
+    while ( true ) {
+      int const q = c[j] + o[j];
+      if ( q == int(j) ) {
+        if ( j == 1 ) return false;
+        ++s;
+      }
+      else if ( q >= 0 ) {
+        unsigned const x = j - c[j] + s, y = j - q + s;
+        swap( a[x], a[y] );
+        set_line(x); set_line(y);
+        c[j] = q;
+        sgn = -sgn;
+        return true;
+      }
+      o[j] = -o[j];
+      --j;
+    }
+  }
+
+private:
+  vector<unsigned> c;
+  vector<int> o;
+};
+
+template <class Generator>
+void write_rows( Generator g, bool in_course, RINGING_ULLONG count, 
+                 size_t len )
+{
+  row_writer out( len );
+  while ( count ) {
+    if ( !in_course || g.sign() > 0 ) {
+      out.write( g.line() );
+      --count;
+    }
+    if ( !g.next() ) break;
+  }
+  out.flush();
+}
+
 int main( int argc, char *argv[] )
 {
   bell::set_symbols_from_env();
@@ -120,8 +351,32 @@ int main( int argc, char *argv[] )
   const unsigned int nw = args.bells - args.tenors - args.hunts;
   const unsigned int nh = args.hunts, nt = args.bells;
 
-  for ( extent_iterator i(nw, nh, nt), e; i != e; ++i ) {
-    if ( !args.in_course || i->sign() > 0 )
-      cout << *i << "\n";
-  }
+  try 
+    {
+      RINGING_ULLONG start = args.start;
+
+      // Convert a position in the in-course rows into one in the extent
+      if ( start && args.in_course ) {
+        if ( args.plain_changes ) 
+          start *= 2;
+        else {
+          extent_ranker const rk( nw, nh, nt );
+          if ( start >= rk.size() / 2 ) 
+            throw out_of_range( "Start is past the end" );
+          start = rk.rank( rk.unrank_incourse( start ) );
+        }
+      }
+
+      if ( args.plain_changes )
+        write_rows( plain_generator( nw, nh, nt, start ), 
+                    args.in_course, args.count, nt+1 );
+      else
+        write_rows( lex_generator( nw, nh, nt, start ), 
+                    args.in_course, args.count, nt+1 );
+    }
+  catch ( exception const& e )
+    {
+      cerr << "extent: " << e.what() << "\n";
+      return 1;
+    }
 }
@@ -24,14 +24,23 @@
 #include <ringing/pointers.h>
 #include <ringing/streamutils.h>
 #include <ringing/mathutils.h>
+#include <ringing/timing.h>
 
 #include <vector>
+#include <string>
 #include <cmath>
 #include <ctime>
+#include <cstdio>
 #include <iterator>
 #include <iostream>
+#include <fstream>
 #include <iomanip>
+#include <stdexcept>
 #include <cassert>
+#if RINGING_USE_THREADS
+#include <thread>
+#include <functional>
+#endif
 
 #include "args.h"
 #include "init_val.h"
@@ -97,6 +106,96 @@ inline void clear_status()
   status_out("");
 }
 
+// Checkpoints are written in the native byte order: they are only 
+// expected to be resumed on the machine that wrote them.
+template <class T>
+static void write_raw( ostream& os, T const& val )
+{
+  os.write( reinterpret_cast<char const*>(&val), sizeof(T) );
+}
+
+template <class T>
+static void read_raw( istream& is, T& val )
+{
+  if ( !is.read( reinterpret_cast<char*>(&val), sizeof(T) ) )
+    throw runtime_error( "Checkpoint is truncated" );
+}
+
+template <class T>
+static void write_vector( ostream& os, vector<T> const& v )
+{
+  write_raw( os, static_cast<unsigned RINGING_LLONG>( v.size() ) );
+  if ( v.size() )
+    os.write( reinterpret_cast<char const*>(&v[0]), v.size() * sizeof(T) );
+}
+
+// The vector must already have the size expected
+template <class T>
+static void read_vector( istream& is, vector<T>& v )
+{
+  unsigned RINGING_LLONG n;
+  read_raw( is, n );
+  if ( n != v.size() )
+    throw runtime_error( "Checkpoint does not match the search" );
+  if ( n && !is.read( reinterpret_cast<char*>(&v[0]), n * sizeof(T) ) )
+    throw runtime_error( "Checkpoint is truncated" );
+}
+
+// A map from row indices to values of type T, for a fixed number of
+// rows, which can be cleared in constant time and which does not 
+// allocate once it has warmed up.  Each slot is stamped with the 
+// generation in which it was last written, and the slots written in 
+// the current generation are listed in order of writing.
+template <class T>
+class row_delta
+{
+public:
+  row_delta() : gen(1) {}
+
+  void resize( size_t n ) {
+    vector<unsigned>( n, 0u ).swap( stamps );
+    vector<T>( n ).swap( values );
+    touched.clear();
+    gen = 1;
+  }
+
+  void clear() {
+    touched.clear();
+    if ( ++gen == 0 ) {
+      fill( stamps.begin(), stamps.end(), 0u );
+      gen = 1;
+    }
+  }
+
+  // Returns NULL if the slot has not been written since the last clear()
+  T const* find( size_t i ) const { 
+    return stamps[i] == gen ? &values[i] : NULL;
+  }
+
+  T const& at( size_t i ) const { return values[i]; }
+
+  T& operator[]( size_t i ) {
+    if ( stamps[i] != gen ) {
+      stamps[i] = gen;
+      values[i] = T();
+      touched.push_back(i);
+    }
+    return values[i];
+  }
+
+  // The indices that have been written
+  typedef vector<size_t>::const_iterator const_iterator;
+  const_iterator begin() const { return touched.begin(); }
+  const_iterator end() const { return touched.end(); }
+  void sort_indices() { sort( touched.begin(), touched.end() ); }
+
+private:
+  vector<unsigned> stamps;
+  vector<T> values;
+  vector<size_t> touched;
+  unsigned gen;
+};
+
 struct weighting 
 {
   weighting();
@@ -132,6 +231,14 @@ struct arguments
   init_val<bool,false>    principle;
 
   init_val<int,1>         loop;
+  init_val<int,1>         threads;
+  init_val<bool,false>    exchange;
+
+  string                  schedule;
+  string                  beta_str;
+  double                  beta_init, beta_final;
+  init_val<int,0>         reheat;
+  init_val<int,0>         patience;
 
   init_val<bool,false>    print_leads;
   init_val<int, 0>        min_leads;
@@ -139,6 +246,13 @@ struct arguments
   init_val<bool,false>    quiet;
   init_val<bool,false>    status;
 
+  string                  checkpoint_file;
+  init_val<int,600>       checkpoint_interval;
+  init_val<bool,false>    resume;
+
+  string                  stats_file;
+  init_val<int,10>        stats_interval;
+
   string                  meth_str;
   method                  meth;
 
@@ -353,6 +467,42 @@ void arguments::bind( arg_parser& p )
 	   "Repeat some number of times (or indefinitely)", "NUM",
 	   loop, -1 ) );
 
+  p.add( new integer_opt
+	 ( 'j', "threads",
+	   "Run NUM annealing chains in parallel, and report the best", "NUM",
+	   threads ) );
+
+  p.add( new boolean_opt
+	 ( '\0', "exchange",
+	   "Run the parallel chains at different temperatures, "
+	   "periodically exchanging their states",
+	   exchange ) );
+
+  p.add( new string_opt
+	 ( '\0', "schedule",
+	   "Use the named annealing schedule: 'geometric' (the default) "
+	   "raises the inverse temperature geometrically; 'adaptive' adjusts "
+	   "it to follow a target acceptance ratio", "NAME",
+	   schedule ) );
+
+  p.add( new string_opt
+	 ( '\0', "beta",
+	   "The initial and final inverse temperatures (default 3,25)", 
+	   "INIT,FINAL",
+	   beta_str ) );
+
+  p.add( new integer_opt
+	 ( '\0', "reheat",
+	   "Halve the inverse temperature after NUM iterations without "
+	   "an improvement in the score", "NUM",
+	   reheat ) );
+
+  p.add( new integer_opt
+	 ( '\0', "patience",
+	   "Stop annealing after NUM iterations without an improvement "
+	   "in the score", "NUM",
+	   patience ) );
+
   p.add( new strings_opt
 	 ( 'P', "part-end",
 	   "Specify a part-end",  "ROW",
@@ -388,6 +538,32 @@ void arguments::bind( arg_parser& p )
 	   "Display the current status",
 	   status ) );
 
+  p.add( new string_opt
+	 ( '\0', "checkpoint",
+	   "Periodically save the state of the search to FILE", "FILE",
+	   checkpoint_file ) );
+
+  p.add( new integer_opt
+	 ( '\0', "checkpoint-interval",
+	   "Save a checkpoint every NUM seconds (default 600)", "NUM",
+	   checkpoint_interval ) );
+
+  p.add( new boolean_opt
+	 ( '\0', "resume",
+	   "Resume the search from the checkpoint file, if it exists",
+	   resume ) );
+
+  p.add( new string_opt
+	 ( '\0', "stats",
+	   "Write statistics about the progress of the search to FILE, "
+	   "one JSON object per line", "FILE",
+	   stats_file ) );
+
+  p.add( new integer_opt
+	 ( '\0', "stats-interval",
+	   "Write statistics every NUM seconds (default 10)", "NUM",
+	   stats_interval ) );
+
   p.add( new boolean_opt
 	 ( '\0', "print-leads",
 	   "Print the matching leads (or courses)",
@@ -430,6 +606,66 @@ bool arguments::validate( arg_parser& ap )
     return false;
   }
 
+  if ( threads < 1 ) {
+    ap.error( "The number of threads must be at least one" );
+    return false;
+  }
+
+  if ( exchange && threads < 2 ) {
+    ap.error( "Exchanging states requires more than one thread" );
+    return false;
+  }
+
+  if ( schedule.empty() )
+    schedule = "geometric";
+  else if ( schedule != "geometric" && schedule != "adaptive" ) {
+    ap.error( make_string() << "Unknown annealing schedule: '" 
+	      << schedule << "'" );
+    return false;
+  }
+
+  beta_init = 3;  beta_final = 25;
+  if ( !beta_str.empty() ) {
+    string::size_type pos( beta_str.find(',') );
+    try {
+      if ( pos == string::npos ) throw bad_lexical_cast();
+      beta_init = lexical_cast<double>( beta_str.substr( 0, pos ) );
+      beta_final = lexical_cast<double>( beta_str.substr( pos + 1 ) );
+    }
+    catch ( bad_lexical_cast const& ) {
+      ap.error( "Inverse temperatures must be specified as INIT,FINAL" );
+      return false;
+    }
+  }
+
+  if ( beta_init <= 0 || beta_final < beta_init ) {
+    ap.error( "Inverse temperatures must be positive and increasing" );
+    return false;
+  }
+
+  if ( reheat < 0 || patience < 0 ) {
+    ap.error( "The number of iterations without improvement must not "
+	      "be negative" );
+    return false;
+  }
+
+  if ( resume && checkpoint_file.empty() ) {
+    ap.error( "The --resume option requires a checkpoint file" );
+    return false;
+  }
+
+  if ( checkpoint_interval < 1 || stats_interval < 1 ) {
+    ap.error( "Intervals must be at least one second" );
+    return false;
+  }
+
+#if !RINGING_USE_THREADS
+  if ( threads > 1 ) {
+    ap.error( "Threads are not supported in this build" );
+    return false;
+  }
+#endif
+
   if ( principle & whole_courses ) {
     ap.error( "Searching for principles in whole courses is not supported" );
     return false;
@@ -468,6 +704,19 @@ public:
   void set_beta(double b) { beta = b; }
   bool perturb(); // returns true if perturbation was kept
 
+  void seed( unsigned long s ) { rng.set_seed(s); }
+  double score() const { return sc; }
+
+  // The number of perturbations since the last call to reset_counts()
+  // that would have reduced the score, and how many were kept
+  int uphill_moves() const { return uphill; }
+  int uphill_kept() const { return uphill_acc; }
+  void reset_counts() { uphill = uphill_acc = 0; }
+
+  // Exchange the leads present, but not the random number generator,
+  // with another copy of the state
+  void swap_configuration( state& other );
+
   void prune_unlinked();
 
   int length() const {
@@ -484,6 +733,12 @@ public:
  
   void dump( ostream& os ) const;
 
+  // Save or restore the leads present and the random number generator.
+  // The state being restored must have been constructed with the 
+  // same arguments.
+  void save( ostream& os ) const;
+  void load( istream& is );
+
 private:
   enum lead_state {
     disallowed = -1,
@@ -566,7 +821,10 @@ private:
   friend class const_iterator;
   
   inline bool should_keep( double delta ) {
-    return delta > 0 || random_bool( exp(delta * beta) );
+    if ( delta > 0 ) return true;
+    bool const keep = rng.random_bool( exp(delta * beta) );
+    if ( delta < 0 ) { ++uphill; if (keep) ++uphill_acc; }
+    return keep;
   }
 
   typedef multtab::row_t      row_t;
@@ -590,15 +848,38 @@ private:
   int len, links;
   int flags;
   int nw, nh;
-  scoped_pointer<multtab> mt;
-  vector<double> weight;
-  vector<fch_t> fchs;
-  vector<row_t> req_rows;
-  vector< pair< vector< pair< fch_t, 
-			      size_t /*inverse qset index*/> >, 
-                size_t /*change_index*/> > qsets;
-  vector< pair< fch_t, fch_t > > lhs; // forward & reverse
+  random_source rng;
+  int uphill, uphill_acc;
+
+  // These are calculated by the constructor and then shared, read-only,
+  // between copies of the state, so that several chains can be run in
+  // parallel without duplicating them.
+  typedef vector< pair< vector< pair< fch_t, 
+				      size_t /*inverse qset index*/> >, 
+			size_t /*change_index*/> > qsets_t;
+  struct tables {
+    scoped_pointer<multtab> mt;
+    vector<double> weight;
+    vector<fch_t> fchs;
+    vector<row_t> req_rows;
+    qsets_t qsets;
+    vector< pair< fch_t, fch_t > > lhs; // forward & reverse
+  };
+  shared_pointer<tables> tab;
+
+  scoped_pointer<multtab>& mt;
+  vector<double>& weight;
+  vector<fch_t>& fchs;
+  vector<row_t>& req_rows;
+  qsets_t& qsets;
+  vector< pair< fch_t, fch_t > >& lhs;
+
   vector<lead_state> leads;
+
+  // Scratch space for perturbations
+  mutable row_delta<double> rdiff_buf;
+  mutable row_delta< pair<int, size_t> > ldiff_buf;
+
   vector<size_t> linkage; // if qsets.size(), indices into the qsets vector, or size_t(-1)
                           // else if lhs.size(), indices into the lhs vector
 };
@@ -925,7 +1206,9 @@ state::state( const method& m, int flags, const group& pgrp,
 	      const weighting& wprof )
   : bells(m.bells()), courselen(m.leads()), 
     link_weight( wprof.linked_course ),
-    beta(0), flags(flags)
+    beta(0), flags(flags), uphill(0), uphill_acc(0), tab( new tables ),
+    mt( tab->mt ), weight( tab->weight ), fchs( tab->fchs ), 
+    req_rows( tab->req_rows ), qsets( tab->qsets ), lhs( tab->lhs )
 {
   nh = flags & principle ? 0 : 1;
 
@@ -1085,20 +1368,18 @@ private:
   // Row status
   //
   bool is_added( row_t const& r ) const
-    { map<row_t, double, row_t::cmp>::const_iterator i = rdiff.find(r);
-      return i != rdiff.end() && i->second > 0; }
+    { double const* x = rdiff.find( r.index() ); return x && *x > 0; }
   bool is_removed( row_t const& r ) const 
-    { map<row_t, double, row_t::cmp>::const_iterator i = rdiff.find(r);
-      return i != rdiff.end() && i->second < 0; }
+    { double const* x = rdiff.find( r.index() ); return x && *x < 0; }
 
   // TODO:  It is bad to assume that  (double(w) - double(w) == 0.0)
 
   void do_add_row( row_t const& r )
     { double const w( s.weight[ r.index() ] ); 
-      d += w; if ( (rdiff[r] += w) == 0 ) rdiff.erase(r); }
+      d += w; rdiff[ r.index() ] += w; }
   void do_rm_row( row_t const& r )
     { double const w( s.weight[ r.index() ] ); 
-      d -= w; if ( (rdiff[r] -= w) == 0 ) rdiff.erase(r); }
+      d -= w; rdiff[ r.index() ] -= w; }
 
   //
   // General linkage
@@ -1124,20 +1405,22 @@ private:
   //
   state const& s;
 
-  map<row_t, double, row_t::cmp> rdiff; // +1 to add, -1 to remove
-  map<row_t, pair<int, size_t>, row_t::cmp> ldiff;
+  // These live in the state so that they can be reused.  A zero 
+  // weight means there is no change to that row.
+  row_delta<double>& rdiff; // +ve to add, -ve to remove
+  row_delta< pair<int, size_t> >& ldiff;
   double d;
 };
 
 inline size_t state::perturbation::get_linkage( row_t const& r ) const
 {
-  map<row_t, pair<int,size_t>, row_t::cmp>::const_iterator i = ldiff.find(r);
-  return i == ldiff.end() ? s.linkage[r.index()] : i->second.second; 
+  pair<int, size_t> const* x = ldiff.find( r.index() );
+  return x ? x->second : s.linkage[r.index()];
 }
 
 inline void state::perturbation::do_add_link( row_t const& r, size_t link )
 { 
-  pair<int, size_t>& x = ldiff[r];
+  pair<int, size_t>& x = ldiff[ r.index() ];
 
   DEBUG( "Actually adding link " << r.index() << ": " << link );
 
@@ -1148,21 +1431,24 @@ inline void state::perturbation::do_add_link( row_t const& r, size_t link )
 
 inline void state::perturbation::do_rm_link( row_t const& r )
 { 
-  pair<int, size_t>& x = ldiff[r];
+  pair<int, size_t>& x = ldiff[ r.index() ];
 
   DEBUG( "Actually removing link " << r.index() << ": " << get_linkage(r) );
 
   d -= s.link_weight; 
   if ( --x.first == 0 ) 
-    ldiff.erase(r); 
+    x.second = s.linkage[r.index()]; // i.e. no change
   else 
     x.second = size_t(-1); 
 }
 
 
 state::perturbation::perturbation( state const& s )
-  : s(s), d(0)
+  : s(s), rdiff(s.rdiff_buf), ldiff(s.ldiff_buf), d(0)
 {
+  rdiff.clear();
+  ldiff.clear();
+
   DEBUG( "" );
   DEBUG( "New perturbation -- initial score " << s.sc << "; " 
 	 << "links " << s.links );
@@ -1176,6 +1462,9 @@ void state::clear()
   if ( qsets.size() || lhs.size() )
     vector<size_t>( mt->size(), size_t(-1) ).swap( linkage );
 
+  rdiff_buf.resize( mt->size() );
+  ldiff_buf.resize( mt->size() );
+
   perturbation init(*this);
 
   // Find leads that are false against themselves (perhaps in different parts)
@@ -1206,13 +1495,13 @@ bool state::perturbation::check_delta() const
 {
   double real_delta(0);
 
-  for ( map<row_t, double, row_t::cmp>::const_iterator 
+  for ( row_delta<double>::const_iterator 
 	  i(rdiff.begin()), e(rdiff.end());  i != e;  ++i )
-    real_delta += i->second;
+    real_delta += rdiff.at(*i);
 
-  for ( map< row_t, pair<int, size_t>, row_t::cmp>::const_iterator 
+  for ( row_delta< pair<int, size_t> >::const_iterator 
 	  i(ldiff.begin()), e(ldiff.end());  i != e;  ++i )
-    real_delta += i->second.first * s.link_weight;
+    real_delta += ldiff.at(*i).first * s.link_weight;
 
   return real_delta == d;
 }
@@ -1399,32 +1688,41 @@ void state::perturbation::commit2( state& s, lead_state add, lead_state rm )
 {
   DEBUG( "Committing -- delta " << d );
 
-  for ( map<row_t, double, row_t::cmp>::const_iterator 
+  // Apply the changes in row order so the score is summed in a 
+  // consistent order
+  rdiff.sort_indices();
+  ldiff.sort_indices();
+
+  for ( row_delta<double>::const_iterator 
 	  i(rdiff.begin()), e(rdiff.end());  i != e;  ++i )
     {
-      DEBUG( "Commit row: " << i->first.index() << ", score " << i->second );
-      assert( i->second != 0 );
+      row_t const r( row_t::from_index(*i) );
+      double const w( rdiff.at(*i) );
+      if ( w == 0 ) continue;
+
+      DEBUG( "Commit row: " << *i << ", score " << w );
 
-      if ( i->second > 0 && s.is_absent(i->first) ||
-	   i->second < 0 && s.is_present(i->first) )
+      if ( ( w > 0 && s.is_absent(r) ) || ( w < 0 && s.is_present(r) ) )
 	{
 	  // TODO Gah! More assertions on floating equalities.  Bad, bad, bad.
-	  assert( s.weight[ i->first.index() ] == i->second * sign(i->second) );
-	  s.sc += i->second;
-	  s.len += sign(i->second);
+	  assert( s.weight[*i] == w * sign(w) );
+	  s.sc += w;
+	  s.len += sign(w);
 	}
 
-      s.leads[ i->first.index() ] = ( (i->second > 0) ? add : rm );
+      s.leads[*i] = ( (w > 0) ? add : rm );
     }
 
-  for ( map< row_t, pair<int, size_t>, row_t::cmp>::const_iterator 
+  for ( row_delta< pair<int, size_t> >::const_iterator 
 	  i(ldiff.begin()), e(ldiff.end());  i != e;  ++i )
     {
-      DEBUG( "Commit link: " << i->first.index() << ", score " << i->second.first );
+      pair<int, size_t> const& x( ldiff.at(*i) );
 
-      s.linkage[ i->first.index() ] = i->second.second;
-      s.sc += i->second.first * s.link_weight;
-      s.links += i->second.first;
+      DEBUG( "Commit link: " << *i << ", score " << x.first );
+
+      s.linkage[*i] = x.second;
+      s.sc += x.first * s.link_weight;
+      s.links += x.first;
     }
 
 #if ENABLE_CHECKS
@@ -1483,11 +1781,50 @@ void state::prune_unlinked()
     }
 }
 
+void state::swap_configuration( state& other )
+{
+  assert( tab == other.tab );
+  swap( sc, other.sc );
+  swap( len, other.len );
+  swap( links, other.links );
+  leads.swap( other.leads );
+  linkage.swap( other.linkage );
+}
+
+void state::save( ostream& os ) const
+{
+  write_raw( os, sc );
+  write_raw( os, len );
+  write_raw( os, links );
+  write_raw( os, rng.get_state() );
+  write_vector( os, leads );
+  write_vector( os, linkage );
+}
+
+void state::load( istream& is )
+{
+  unsigned RINGING_LLONG r;
+  read_raw( is, sc );
+  read_raw( is, len );
+  read_raw( is, links );
+  read_raw( is, r );
+  read_vector( is, leads );
+  read_vector( is, linkage );
+
+  if ( !r ) throw runtime_error( "Checkpoint is corrupt" );
+  rng.set_state(r);
+
+#if ENABLE_CHECKS
+  if ( !check() ) 
+    throw runtime_error( "Checkpoint is corrupt" );
+#endif
+}
+
 bool state::perturb()
 {
   perturbation p( *this );
 
-  int ri = random_int( leads.size() );
+  int ri = rng.random_int( leads.size() );
   bool valid(false);
 
   if ( leads[ri] == present )
@@ -1509,6 +1846,621 @@ bool state::perturb()
 }
 
 
+// An annealing schedule determines the inverse temperature, beta, 
+// for each round of steps.  It is told the acceptance ratio at the
+// end of each round, and may be reheated if the search stagnates.
+class schedule
+{
+public:
+  schedule( arguments const& args ) 
+    : beta_init( args.beta_init ), beta_final( args.beta_final ), 
+      num_steps( args.num_steps ), scale(1) 
+  {}
+  virtual ~schedule() {}
+
+  static schedule* create( arguments const& args );
+
+  virtual void reset() { scale = 1; }
+
+  // The inverse temperature at the given step, and the factor by 
+  // which it changes with each step in the round that follows
+  virtual double beta( int step ) const = 0;
+  virtual double multiplier() const { return 1; }
+
+  // Called after each round with the number of moves that would have
+  // reduced the score, and how many of them were kept
+  virtual void update( int /*step*/, int /*uphill*/, int /*kept*/ ) {}
+
+  void reheat() { scale /= 2; }
+
+  virtual void save( ostream& os ) const { write_raw( os, scale ); }
+  virtual void load( istream& is ) { read_raw( is, scale ); }
+
+protected:
+  double const beta_init, beta_final;
+  int const num_steps;
+  double scale;
+};
+
+// Beta increases geometrically from beta_init to beta_final
+class geometric_schedule : public schedule
+{
+public:
+  geometric_schedule( arguments const& args ) 
+    : schedule(args), 
+      mult( pow( beta_final / beta_init, 1/double(num_steps) ) )
+  {}
+
+  virtual double beta( int step ) const 
+    { return scale * beta_init * pow( mult, step ); }
+  virtual double multiplier() const { return mult; }
+
+private:
+  double const mult;
+};
+
+// Beta is adjusted after each round so that the proportion of moves 
+// reducing the score which are kept falls exponentially from 3% to 
+// 0.01% over the run, rather than following a fixed path that spends 
+// much of its time where almost none are kept.  Beta is never allowed 
+// to exceed beta_final.
+class adaptive_schedule : public schedule
+{
+public:
+  adaptive_schedule( arguments const& args ) 
+    : schedule(args), b( beta_init ), uphill(0), kept(0)
+  {}
+
+  virtual void reset() 
+    { schedule::reset(); b = beta_init; uphill = kept = 0; }
+  virtual double beta( int ) const { return scale * b; }
+  virtual void update( int step, int uphill, int kept );
+
+  virtual void save( ostream& os ) const { 
+    schedule::save(os); 
+    write_raw( os, b ); write_raw( os, uphill ); write_raw( os, kept );
+  }
+  virtual void load( istream& is ) { 
+    schedule::load(is); 
+    read_raw( is, b ); read_raw( is, uphill ); read_raw( is, kept );
+  }
+
+private:
+  static double target( double f );
+
+  double b;
+  double uphill, kept;  // Exponentially weighted counts
+};
+
+double adaptive_schedule::target( double f )
+{
+  return 0.03 * pow( 0.003, f );
+}
+
+void adaptive_schedule::update( int step, int up, int k )
+{
+  // A round is too short to measure small acceptance ratios, so 
+  // average over the last few
+  uphill = 0.75 * uphill + up;
+  kept = 0.75 * kept + k;
+  double const acceptance = uphill ? kept / uphill : 1.0;
+
+  // Compare the ratios rather than their difference, as the target
+  // becomes very small towards the end.  The epsilon avoids trouble 
+  // when nothing is accepted.
+  double const eps = 1e-4;
+  double const r = ( acceptance + eps ) / ( target( step / double(num_steps) ) + eps );
+  b = min( beta_final, b * max( 0.5, min( 2.0, sqrt(r) ) ) );
+}
+
+schedule* schedule::create( arguments const& args )
+{
+  if ( args.schedule == "adaptive" )
+    return new adaptive_schedule( args );
+  else 
+    return new geometric_schedule( args );
+}
+
+
+// A number of copies of the state, each with its own random number 
+// generator, which are annealed in parallel.  Without --exchange the 
+// chains are independent; with it, chain k runs at a temperature 
+// scaled by exchange_ratio^(k/(n-1)) and neighbouring chains 
+// periodically swap their leads (replica exchange).
+//
+// The chain_set also keeps track of the progress of the search across
+// repeated annealing runs, so that it can be checkpointed and resumed, 
+// and can write statistics about it as it goes.
+class chain_set
+{
+public:
+  chain_set( state const& s, arguments const& args );
+
+  void anneal();
+  void clear();
+
+  // The best result from the last call to anneal()
+  state const& best() const { return *best_so_far; }
+
+  // The number of completed calls to anneal(), and the best length
+  // found by any of them
+  int iterations() const { return iter; }
+  int highest() const { return mx; }
+
+  // Restores the search from the checkpoint file.  Returns false if 
+  // there is no checkpoint.
+  bool resume();
+
+private:
+  static void run_chain( state& s, double beta, double mult, int steps,
+			 int& accepted );
+  void run_round( int step, int steps );
+  void exchange( double beta );
+  void reduce();
+  bool stagnated( int limit ) const 
+    { return limit && step - max( last_improved, last_reheat ) >= limit; }
+  bool acceptable( state const& s ) const 
+    { return !args.linkage || s.fully_linked(); }
+
+  int band( double beta ) const;
+  string signature() const;
+  void save( ostream& os ) const;
+  void load( istream& is );
+  void write_checkpoint();
+  void write_stats( bool done );
+  void report();
+
+  // Steps between exchanges and status updates
+  static const int round_steps = 1000;
+
+  // The temperature of the hottest chain relative to the first
+  static const double exchange_ratio;
+
+  // The number of temperature bands for which acceptance ratios are
+  // reported, equally spaced on a logarithmic scale
+  static const int stat_bands = 10;
+
+  arguments const& args;
+  vector< shared_pointer<state> > chains;
+  vector<double> ladder;
+  random_source rng;  // Used for exchanges
+  bool parity;
+  scoped_pointer<state> best_so_far;
+  scoped_pointer<schedule> sched;
+
+  // Progress through the search
+  int iter, step, mx;
+
+  // The best score seen by any chain during the current call to 
+  // anneal(), and the steps at which it last improved and the 
+  // schedule was last reheated
+  double best_score;
+  int last_improved, last_reheat;
+
+  // Statistics for the current call to anneal()
+  vector<int> accepted;
+  vector<unsigned RINGING_LLONG> band_moves, band_accepted;
+  vector<unsigned RINGING_LLONG> band_uphill, band_uphill_kept;
+  unsigned RINGING_LLONG moves;
+
+  scoped_pointer<ofstream> stats_out;
+  double started, last_stats, last_checkpoint;
+  unsigned RINGING_LLONG last_moves;
+};
+
+const double chain_set::exchange_ratio = 0.5;
+
+chain_set::chain_set( state const& s, arguments const& args )
+  : args(args), rng( args.seed + args.threads ), parity(false),
+    sched( schedule::create(args) ), iter(0), step(0), mx(0), 
+    best_score( -HUGE_VAL ), last_improved(0), last_reheat(0),
+    accepted( args.threads ), band_moves( stat_bands ), 
+    band_accepted( stat_bands ), band_uphill( stat_bands ), 
+    band_uphill_kept( stat_bands ), moves(0),
+    started( clock_seconds() ), last_stats( started ), 
+    last_checkpoint( started ), last_moves(0)
+{
+  for ( int k=0; k<args.threads; ++k ) {
+    chains.push_back( shared_pointer<state>( new state(s) ) );
+    chains.back()->seed( args.seed + k );
+    ladder.push_back( args.exchange 
+		      ? pow( exchange_ratio, k / double(args.threads-1) ) 
+		      : 1.0 );
+  }
+
+  if ( !args.stats_file.empty() ) {
+    stats_out.reset( new ofstream( args.stats_file.c_str(), 
+				   ios::out | ios::app ) );
+    if ( !*stats_out ) 
+      throw runtime_error( "Unable to open " + args.stats_file );
+  }
+}
+
+void chain_set::run_chain( state& s, double beta, double mult, int steps,
+			   int& accepted )
+{
+  accepted = 0;
+  for ( int i=0; i<steps; ++i, beta *= mult ) {
+    s.set_beta(beta);
+    if ( s.perturb() ) ++accepted;
+  }
+}
+
+void chain_set::run_round( int step, int steps )
+{
+  double const mult = sched->multiplier();
+  double const beta = sched->beta( step );
+
+#if RINGING_USE_THREADS
+  // The first chain is run on this thread
+  vector<thread> threads;
+  for ( size_t k=1; k<chains.size(); ++k )
+    threads.push_back( thread( &run_chain, ref(*chains[k]), 
+			       beta * ladder[k], mult, steps, 
+			       ref(accepted[k]) ) );
+  run_chain( *chains[0], beta * ladder[0], mult, steps, accepted[0] );
+  for ( size_t k=0; k<threads.size(); ++k )
+    threads[k].join();
+#else
+  for ( size_t k=0; k<chains.size(); ++k )
+    run_chain( *chains[k], beta * ladder[k], mult, steps, accepted[k] );
+#endif
+
+  // The temperature changes very little over a round, so attribute
+  // all of it to the band it started in
+  for ( size_t k=0; k<chains.size(); ++k ) {
+    int const b = band( beta * ladder[k] );
+    band_moves[b] += steps;
+    band_accepted[b] += accepted[k];
+    band_uphill[b] += chains[k]->uphill_moves();
+    band_uphill_kept[b] += chains[k]->uphill_kept();
+  }
+  moves += steps * chains.size();
+
+  // The schedule is adjusted using the proportion of moves that 
+  // reduce the score which are kept, as many moves leave the score 
+  // unchanged and are always kept.  With --exchange the schedule 
+  // follows the first chain; otherwise the chains are all at the same 
+  // temperature.
+  {
+    size_t const n = args.exchange ? 1 : chains.size();
+    int up = 0, kept = 0;
+    for ( size_t k=0; k<n; ++k ) {
+      up += chains[k]->uphill_moves();
+      kept += chains[k]->uphill_kept();
+    }
+    for ( size_t k=0; k<chains.size(); ++k ) 
+      chains[k]->reset_counts();
+    sched->update( step + steps, up, kept );
+  }
+
+  if ( args.exchange ) 
+    exchange( beta * pow( mult, steps ) );
+}
+
+void chain_set::exchange( double beta )
+{
+  // Alternate between exchanging chains (0,1), (2,3), ... 
+  // and (1,2), (3,4), ...
+  for ( size_t k = parity; k+1 < chains.size(); k += 2 ) {
+    double const d = beta * (ladder[k] - ladder[k+1]) 
+      * ( chains[k+1]->score() - chains[k]->score() );
+    if ( d >= 0 || rng.random_bool( exp(d) ) )
+      chains[k]->swap_configuration( *chains[k+1] );
+  }
+  parity = !parity;
+}
+
+void chain_set::reduce()
+{
+  for ( size_t k=0; k<chains.size(); ++k )
+    if ( acceptable( *chains[k] ) && 
+	 ( !best_so_far || chains[k]->length() > best_so_far->length() ) )
+      best_so_far.reset( new state( *chains[k] ) );
+}
+
+void chain_set::anneal()
+{
+  // If resuming from a checkpoint, step may already be non-zero
+  while ( step < args.num_steps && !stagnated( args.patience ) ) {
+    int const steps = min( int(round_steps), args.num_steps - step );
+    run_round( step, steps );
+    reduce();
+
+    if ( args.status )
+      status_out( make_string() << "Currently " 
+		  << floor(double(step)/args.num_steps * 1000)/10. 
+		  << "% done" );
+
+    step += steps;
+
+    for ( size_t k=0; k<chains.size(); ++k )
+      if ( chains[k]->score() > best_score ) {
+	best_score = chains[k]->score();
+	last_improved = step;
+      }
+
+    if ( stagnated( args.reheat ) ) {
+      sched->reheat();
+      last_reheat = step;
+    }
+
+    report();
+  }
+
+  for ( size_t k=0; k<chains.size(); ++k ) {
+    state& s = *chains[k];
+
+    if ( args.linkage && !s.fully_linked() )
+      s.prune_unlinked();
+
+#if ENABLE_CHECKS
+    if (!s.check()) { 
+      clear_status();
+      cerr << "ERROR!!!" << endl;
+      s.dump( cerr );
+      exit(1);
+    }
+#endif
+  }
+
+  reduce();
+
+  // Can only happen if the linkage requirement can't be met
+  if ( !best_so_far )
+    best_so_far.reset( new state( *chains[0] ) );
+
+  if ( acceptable( *best_so_far ) && best_so_far->length() > mx ) 
+    mx = best_so_far->length();
+
+  if ( stats_out ) 
+    write_stats( true );
+}
+
+void chain_set::clear()
+{
+  for ( size_t k=0; k<chains.size(); ++k )
+    chains[k]->clear();
+  best_so_far.reset();
+
+  sched->reset();
+  ++iter; step = 0; 
+  best_score = -HUGE_VAL;  last_improved = last_reheat = 0;
+  fill( band_moves.begin(), band_moves.end(), 0u );
+  fill( band_accepted.begin(), band_accepted.end(), 0u );
+  fill( band_uphill.begin(), band_uphill.end(), 0u );
+  fill( band_uphill_kept.begin(), band_uphill_kept.end(), 0u );
+
+  report();
+}
+
+// Write a checkpoint or statistics if they are due
+void chain_set::report()
+{
+  if ( !stats_out && args.checkpoint_file.empty() ) 
+    return;
+
+  double const now = clock_seconds();
+
+  if ( stats_out && now - last_stats >= args.stats_interval ) 
+    write_stats( false );
+
+  if ( !args.checkpoint_file.empty() && 
+       now - last_checkpoint >= args.checkpoint_interval ) {
+    write_checkpoint();
+    last_checkpoint = now;
+  }
+}
+
+int chain_set::band( double beta ) const
+{
+  double const lo = args.beta_init * ( args.exchange ? exchange_ratio : 1.0 );
+  int b = int( floor( stat_bands * log( beta / lo ) 
+		      / log( args.beta_final / lo ) ) );
+  return max( 0, min( b, stat_bands-1 ) );
+}
+
+void chain_set::write_stats( bool done )
+{
+  double const now = clock_seconds();
+  double const lo = args.beta_init * ( args.exchange ? exchange_ratio : 1.0 );
+  double const hi = args.beta_final;
+
+  // The chain with the most leads
+  state const* cur = chains[0].get();
+  for ( size_t k=1; k<chains.size(); ++k ) 
+    if ( chains[k]->length() > cur->length() ) 
+      cur = chains[k].get();
+
+  ostream& os = *stats_out;
+  os << "{\"iteration\":" << iter << ",\"step\":" << step 
+     << ",\"steps\":" << args.num_steps << ",\"done\":" 
+     << ( done ? "true" : "false" ) << ",\"elapsed\":" << now - started
+     << ",\"moves\":" << moves << ",\"moves_per_sec\":";
+  if ( now > last_stats ) 
+    os << (moves - last_moves) / (now - last_stats);
+  else 
+    os << "null";
+  os << ",\"beta\":" << sched->beta( step )
+     << ",\"length\":" << cur->length()
+     << ",\"best_length\":" << ( best_so_far ? best_so_far->length() : 0 )
+     << ",\"highest\":" << mx;
+  if ( args.linkage ) 
+    os << ",\"percent_linked\":" 
+       << ( cur->length() ? cur->percent_linked() : 0.0 );
+
+  os << ",\"bands\":[";
+  for ( int b=0; b<stat_bands; ++b ) {
+    os << ( b ? "," : "" ) << "{\"beta_min\":" 
+       << lo * pow( hi / lo, b / double(stat_bands) )
+       << ",\"beta_max\":" 
+       << lo * pow( hi / lo, (b+1) / double(stat_bands) )
+       << ",\"moves\":" << band_moves[b] 
+       << ",\"accepted\":" << band_accepted[b] << ",\"acceptance\":";
+    if ( band_moves[b] ) 
+      os << band_accepted[b] / double( band_moves[b] );
+    else 
+      os << "null";
+    os << ",\"uphill_acceptance\":";
+    if ( band_uphill[b] ) 
+      os << band_uphill_kept[b] / double( band_uphill[b] );
+    else 
+      os << "null";
+    os << "}";
+  }
+  os << "]}" << endl;
+
+  last_stats = now;
+  last_moves = moves;
+}
+
+// Everything that affects the state or the annealing schedule
+string chain_set::signature() const
+{
+  make_string os;
+  os << args.meth_str << ' ' << args.bells << ' ' << args.num_steps 
+     << ' ' << args.whole_courses << args.tenors_together 
+     << args.in_course << args.principle << args.linkage 
+     << ' ' << args.threads << ' ' << args.exchange
+     << ' ' << args.schedule << ' ' << args.beta_init << ',' 
+     << args.beta_final << ' ' << args.reheat << ' ' << args.patience;
+
+  for ( size_t i=0; i<args.pend_strs.size(); ++i ) 
+    os << " P" << args.pend_strs[i];
+  for ( size_t i=0; i<args.required_strs.size(); ++i ) 
+    os << " r" << args.required_strs[i];
+  for ( size_t i=0; i<args.call_strs.size(); ++i ) 
+    os << " C" << args.call_strs[i];
+
+  weighting const& w = args.wprof;
+  os << " W" << w.base << ',' << w.linked_course << ',' << w.in_course 
+     << ',' << w.out_of_course << ',' << w.tenors_together 
+     << ',' << w.tenors_over;
+
+  return os;
+}
+
+static char const checkpoint_magic[8] = { 'F','X','T','C','K','P','T','2' };
+
+void chain_set::save( ostream& os ) const
+{
+  os.write( checkpoint_magic, sizeof(checkpoint_magic) );
+
+  string const sig( signature() );
+  write_raw( os, static_cast<unsigned RINGING_LLONG>( sig.size() ) );
+  os.write( sig.data(), sig.size() );
+
+  write_raw( os, iter );
+  write_raw( os, step );
+  write_raw( os, mx );
+  write_raw( os, parity );
+  write_raw( os, rng.get_state() );
+  write_raw( os, best_score );
+  write_raw( os, last_improved );
+  write_raw( os, last_reheat );
+  sched->save( os );
+  for ( size_t k=0; k<chains.size(); ++k )
+    chains[k]->save( os );
+
+  write_raw( os, bool(best_so_far) );
+  if ( best_so_far ) 
+    best_so_far->save( os );
+
+  write_raw( os, moves );
+  write_vector( os, band_moves );
+  write_vector( os, band_accepted );
+  write_vector( os, band_uphill );
+  write_vector( os, band_uphill_kept );
+}
+
+void chain_set::load( istream& is )
+{
+  char magic[ sizeof(checkpoint_magic) ];
+  if ( !is.read( magic, sizeof(magic) ) || 
+       !equal( magic, magic + sizeof(magic), checkpoint_magic ) )
+    throw runtime_error( "Not an fextent checkpoint" );
+
+  string const sig( signature() );
+  unsigned RINGING_LLONG n;
+  read_raw( is, n );
+  string s( n < 0x10000 ? size_t(n) : 0, ' ' );
+  if ( !is.read( &s[0], s.size() ) || s != sig )
+    throw runtime_error( "Checkpoint was made with different options" );
+
+  unsigned RINGING_LLONG r;
+  read_raw( is, iter );
+  read_raw( is, step );
+  read_raw( is, mx );
+  read_raw( is, parity );
+  read_raw( is, r );
+  if ( !r ) throw runtime_error( "Checkpoint is corrupt" );
+  rng.set_state(r);
+
+  read_raw( is, best_score );
+  read_raw( is, last_improved );
+  read_raw( is, last_reheat );
+  sched->load( is );
+  for ( size_t k=0; k<chains.size(); ++k )
+    chains[k]->load( is );
+
+  bool have_best;
+  read_raw( is, have_best );
+  if ( have_best ) {
+    best_so_far.reset( new state( *chains[0] ) );
+    best_so_far->load( is );
+  }
+  else 
+    best_so_far.reset();
+
+  read_raw( is, moves );
+  read_vector( is, band_moves );
+  read_vector( is, band_accepted );
+  read_vector( is, band_uphill );
+  read_vector( is, band_uphill_kept );
+
+  if ( iter < 0 || step < 0 || step > args.num_steps ) 
+    throw runtime_error( "Checkpoint is corrupt" );
+}
+
+// Write to a temporary file and rename it, so that a crash while 
+// writing can't lose the previous checkpoint
+void chain_set::write_checkpoint()
+{
+  string const tmp( args.checkpoint_file + ".tmp" );
+  {
+    ofstream os( tmp.c_str(), ios::out | ios::binary | ios::trunc );
+    save( os );
+    os.close();
+    if ( !os ) 
+      throw runtime_error( "Unable to write checkpoint to " + tmp );
+  }
+
+  if ( rename( tmp.c_str(), args.checkpoint_file.c_str() ) != 0 ) {
+    // Windows will not rename over an existing file
+    remove( args.checkpoint_file.c_str() );
+    if ( rename( tmp.c_str(), args.checkpoint_file.c_str() ) != 0 )
+      throw runtime_error( "Unable to write checkpoint to " 
+			   + args.checkpoint_file );
+  }
+}
+
+bool chain_set::resume()
+{
+  ifstream is( args.checkpoint_file.c_str(), ios::in | ios::binary );
+  if ( !is ) return false;
+
+  try {
+    load( is );
+  }
+  catch ( exception const& ex ) {
+    throw runtime_error( "Unable to resume from " + args.checkpoint_file 
+			 + ": " + ex.what() );
+  }
+
+  last_moves = moves;
+  return true;
+}
+
 int main( int argc, char* argv[] )
 {
   try {
@@ -1535,80 +2487,57 @@ int main( int argc, char* argv[] )
       exit(1);
     }
 
-    int mx = 0;
-    
     if ( args.seed == -1 )
-      srand( args.seed = time(NULL) );
-    else if ( args.seed )
-      srand( args.seed );
+      args.seed = time(NULL);
     
     if ( args.seed && !args.quiet )
       cout << "Started with seed " << int(args.seed) << endl;
     
     if ( !args.quiet )
       cout << "Using part-end group of order " << args.pends.size() << endl;
-  
-    for ( int i=0; args.loop == -1 || i < args.loop; ++i ) {
-      
-      const double beta_init  = 3;
-      const double beta_final = 25;
 
-      
-      const double beta_mult
-	= pow( beta_final / beta_init, 1/double(args.num_steps) );
-      
-      int n = 0;
-      for ( double beta = beta_init ; beta < beta_final; beta *= beta_mult ) {
-	s->set_beta(beta);
-	s->perturb();
-
-	if ( args.status ) {
-	  if ( n++% 1000 == 0 )
-	    status_out( make_string() << "Currently " 
-			<< floor(double(n)/args.num_steps * 1000)/10. 
-			<< "% done" );
-	}
-      }
+    chain_set chains( *s, args );
 
-      if ( args.linkage && !s->fully_linked() )
-	s->prune_unlinked();
-
-      clear_status();
-
-#if ENABLE_CHECKS
-      if (!s->check()) { 
-	cerr << "ERROR!!!" << endl;
-	s->dump( cerr );
-	exit(1);
+    if ( args.resume ) {
+      if ( chains.resume() ) {
+	if ( !args.quiet )
+	  cout << "Resumed from " << args.checkpoint_file << " after " 
+	       << chains.iterations() << " iterations" << endl;
       }
-#endif
+      else if ( !args.quiet )
+	cout << "No checkpoint found in " << args.checkpoint_file << endl;
+    }
+  
+    while ( args.loop == -1 || chains.iterations() < args.loop ) {
+      chains.anneal();
+      clear_status();
 
-      if ( s->length() > mx && ( !args.linkage || s->fully_linked() ) ) 
-	mx = s->length();
+      state const& b = chains.best();
+      int const mx = chains.highest();
       
       if ( !args.quiet ) {
-	cout << s->length() << " leads " 
-	     << "(" << s->length() * args.meth.size() << ")";
-	if ( args.linkage && !s->fully_linked() )
-	  cout << " not fully linked (" << setw(2) << s->percent_linked() << "%)";
+	cout << b.length() << " leads " 
+	     << "(" << b.length() * args.meth.size() << ")";
+	if ( args.linkage && !b.fully_linked() )
+	  cout << " not fully linked (" << setw(2) << b.percent_linked() << "%)";
 	if ( args.loop != 1 )
 	  cout << " [highest = " << mx << " leads "
 	       << "(" << mx * args.meth.size() << ")]";
 	cout << endl;
       }
 
-      if ( args.print_leads && s->length() >= args.min_leads 
-	   && ( !args.linkage || s->fully_linked() ) ) {
-	s->dump( cout );
+      if ( args.print_leads && b.length() >= args.min_leads 
+	   && ( !args.linkage || b.fully_linked() ) ) {
+	b.dump( cout );
         if ( !args.quiet )
           cout << "\n\n\n" << endl;
       }
 
-      s->clear();
+      chains.clear();
     }
 
     if ( args.quiet && !args.print_leads )
-      cout << mx << endl;
+      cout << chains.highest() << endl;
 
     return 0;
   }
@@ -0,0 +1,593 @@
+// batch.cpp - Prove many compositions in one process
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+
+#include "batch.h"
+#include "execution_context.h"
+#include "parser.h"
+#include "statement.h"
+#include "prog_args.h"
+#include <ringing/pointers.h>
+#include <ringing/streamutils.h>
+#if RINGING_OLD_INCLUDES
+#include <stdexcept.h>
+#include <vector.h>
+#include <map.h>
+#include <list.h>
+#else
+#include <stdexcept>
+#include <vector>
+#include <map>
+#include <list>
+#endif
+#if RINGING_OLD_C_INCLUDES
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#else
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#endif
+#if RINGING_OLD_IOSTREAMS
+#include <iostream.h>
+#include <fstream.h>
+#else
+#include <iostream>
+#include <fstream>
+#endif
+#if RINGING_USE_STRINGSTREAM
+#if RINGING_OLD_INCLUDES
+#include <sstream.h>
+#else
+#include <sstream>
+#endif
+#else // RINGING_USE_STRINGSTREAM
+#if RINGING_OLD_INCLUDES
+#include <strstream.h>
+#else
+#include <strstream>
+#endif
+#endif // RINGING_USE_STRINGSTREAM
+#include <string>
+#if RINGING_USE_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+RINGING_USING_NAMESPACE
+
+RINGING_START_ANON_NAMESPACE
+
+struct job {
+  size_t index;
+  string id;    // the raw JSON of the "id" member, if any
+  string text;
+};
+
+// Reads the compositions from the input, either separated by lines
+// containing just the delimiter, or one per line as JSON.
+class batch_reader
+{
+public:
+  batch_reader( istream& in, const arguments& args )
+    : in(in), args(args), count(0), line_no(0) {}
+
+  // Returns false at the end of the input.  Throws for a malformed
+  // line of JSON, after which reading may continue.
+  bool next( job& j );
+
+private:
+  bool next_delimited( job& j );
+  bool next_json( job& j );
+
+  // A minimal JSON parser: enough to pick out string members of an
+  // object and to skip over anything else.
+  void skip_space( string const& s, size_t& i ) const;
+  string parse_string( string const& s, size_t& i ) const;
+  void skip_value( string const& s, size_t& i ) const;
+  void error( char const* msg ) const;
+
+  istream& in;
+  const arguments& args;
+  size_t count, line_no;
+};
+
+bool batch_reader::next( job& j )
+{
+  // Count a malformed line too, so that the indices of later
+  // compositions match their position in the input
+  j.index = count++;
+  j.id.clear();
+  j.text.clear();
+
+  bool got = args.json_lines ? next_json(j) : next_delimited(j);
+  if ( !got ) --count;
+  return got;
+}
+
+bool batch_reader::next_delimited( job& j )
+{
+  bool blank = true;
+  string line;
+  while ( getline( in, line ) ) {
+    ++line_no;
+    if ( line.size() && line[line.size()-1] == '\r' )
+      line.erase( line.size()-1 );
+    if ( line == args.batch_delimiter )
+      return true;
+    if ( line.find_first_not_of( " \t" ) != string::npos )
+      blank = false;
+    j.text += line; j.text += '\n';
+  }
+
+  // Ignore anything but whitespace after the final delimiter
+  return !blank;
+}
+
+bool batch_reader::next_json( job& j )
+{
+  string line;
+  size_t i = 0;
+  do {
+    if ( !getline( in, line ) ) return false;
+    ++line_no; i = 0;
+    skip_space( line, i );
+  } while ( i == line.size() );
+
+  if ( line[i] == '"' )
+    j.text = parse_string( line, i );
+
+  else if ( line[i] == '{' ) {
+    bool found = false;
+    ++i; skip_space( line, i );
+    while ( i < line.size() && line[i] != '}' ) {
+      string key( parse_string( line, i ) );
+      skip_space( line, i );
+      if ( i == line.size() || line[i] != ':' ) error( "expected ':'" );
+      ++i; skip_space( line, i );
+
+      if ( key == "composition" ) {
+        if ( i == line.size() || line[i] != '"' )
+          error( "composition must be a string" );
+        j.text = parse_string( line, i );
+        found = true;
+      }
+      else {
+        size_t start = i;
+        skip_value( line, i );
+        if ( key == "id" ) j.id = line.substr( start, i - start );
+      }
+
+      skip_space( line, i );
+      if ( i < line.size() && line[i] == ',' ) {
+        ++i; skip_space( line, i );
+      }
+      else if ( i == line.size() || line[i] != '}' )
+        error( "expected ',' or '}'" );
+    }
+    if ( i == line.size() ) error( "unterminated object" );
+    if ( !found ) error( "no composition member" );
+    ++i;
+  }
+
+  else
+    error( "expected a string or an object" );
+
+  skip_space( line, i );
+  if ( i != line.size() ) error( "unexpected content after value" );
+
+  return true;
+}
+
+void batch_reader::error( char const* msg ) const
+{
+  throw runtime_error( make_string() << "JSON parse error on line "
+                         << line_no << ": " << msg );
+}
+
+void batch_reader::skip_space( string const& s, size_t& i ) const
+{
+  while ( i < s.size() &&
+          ( s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n' ) )
+    ++i;
+}
+
+void append_utf8( string& out, unsigned long u )
+{
+  if ( u < 0x80 )
+    out += char(u);
+  else if ( u < 0x800 ) {
+    out += char( 0xC0 | (u >> 6) );
+    out += char( 0x80 | (u & 0x3F) );
+  }
+  else if ( u < 0x10000 ) {
+    out += char( 0xE0 | (u >> 12) );
+    out += char( 0x80 | ((u >> 6) & 0x3F) );
+    out += char( 0x80 | (u & 0x3F) );
+  }
+  else {
+    out += char( 0xF0 | (u >> 18) );
+    out += char( 0x80 | ((u >> 12) & 0x3F) );
+    out += char( 0x80 | ((u >> 6) & 0x3F) );
+    out += char( 0x80 | (u & 0x3F) );
+  }
+}
+
+string batch_reader::parse_string( string const& s, size_t& i ) const
+{
+  if ( i == s.size() || s[i] != '"' ) error( "expected a string" );
+  ++i;
+
+  string out;
+  while (true) {
+    if ( i == s.size() ) error( "unterminated string" );
+    char c = s[i++];
+    if ( c == '"' ) break;
+    if ( c != '\\' ) { out += c; continue; }
+
+    if ( i == s.size() ) error( "unterminated string" );
+    switch ( c = s[i++] ) {
+    case '"': case '\\': case '/': out += c; break;
+    case 'b': out += '\b'; break;
+    case 'f': out += '\f'; break;
+    case 'n': out += '\n'; break;
+    case 'r': out += '\r'; break;
+    case 't': out += '\t'; break;
+    case 'u': {
+      unsigned long u = 0;
+      for ( int k = 0; k < 4; ++k, ++i ) {
+        if ( i == s.size() || !isxdigit( (unsigned char) s[i] ) )
+          error( "bad \\u escape" );
+        u = u * 16 + ( isdigit( (unsigned char) s[i] ) ? s[i] - '0' 
+                       : tolower( (unsigned char) s[i] ) - 'a' + 10 );
+      }
+      // Combine a UTF-16 surrogate pair
+      if ( u >= 0xD800 && u < 0xDC00 && i + 6 <= s.size()
+           && s[i] == '\\' && s[i+1] == 'u' ) {
+        char* end;
+        unsigned long v = strtoul( s.substr( i+2, 4 ).c_str(), &end, 16 );
+        if ( !*end && v >= 0xDC00 && v < 0xE000 ) {
+          u = 0x10000 + ( (u - 0xD800) << 10 ) + (v - 0xDC00);
+          i += 6;
+        }
+      }
+      append_utf8( out, u );
+      break;
+    }
+    default:
+      error( "bad escape sequence" );
+    }
+  }
+  return out;
+}
+
+void batch_reader::skip_value( string const& s, size_t& i ) const
+{
+  if ( i == s.size() ) error( "expected a value" );
+
+  if ( s[i] == '"' )
+    parse_string( s, i );
+
+  else if ( s[i] == '{' || s[i] == '[' ) {
+    char close = s[i] == '{' ? '}' : ']';
+    ++i; skip_space( s, i );
+    while ( i < s.size() && s[i] != close ) {
+      if ( close == '}' ) {
+        parse_string( s, i ); skip_space( s, i );
+        if ( i == s.size() || s[i] != ':' ) error( "expected ':'" );
+        ++i; skip_space( s, i );
+      }
+      skip_value( s, i ); skip_space( s, i );
+      if ( i < s.size() && s[i] == ',' ) { ++i; skip_space( s, i ); }
+      else if ( i == s.size() || s[i] != close ) error( "bad JSON value" );
+    }
+    if ( i == s.size() ) error( "unterminated JSON value" );
+    ++i;
+  }
+
+  else {
+    // A number, true, false or null
+    size_t start = i;
+    while ( i < s.size() && ( isalnum( (unsigned char) s[i] )
+                              || s[i] == '-' || s[i] == '+' || s[i] == '.' ) )
+      ++i;
+    if ( i == start ) error( "bad JSON value" );
+  }
+}
+
+void write_string( ostream& os, string const& s )
+{
+  os << '"';
+  for ( string::const_iterator i = s.begin(), e = s.end(); i != e; ++i )
+    switch ( *i ) {
+    case '"':  os << "\\\""; break;
+    case '\\': os << "\\\\"; break;
+    case '\n': os << "\\n"; break;
+    case '\r': os << "\\r"; break;
+    case '\t': os << "\\t"; break;
+    default:
+      if ( (unsigned char) *i < 0x20 ) {
+        char buf[8];
+        sprintf( buf, "\\u%04x", (unsigned) (unsigned char) *i );
+        os << buf;
+      }
+      else os << *i;
+    }
+  os << '"';
+}
+
+// Prove one composition in a copy of the environment, and return its
+// result as a line of JSON
+string prove_job( execution_context const& env, const arguments& args,
+                  job const& j, bool& ok )
+{
+  make_string output;
+  execution_context e( env );
+  e.output( output.out_stream() );
+  e.set_failure( false );
+
+  string error;
+  RINGING_ISTRINGSTREAM in( j.text );
+  shared_pointer<parser> p( make_default_parser( in, e ) );
+  try {
+    bool read_anything = false;
+    while (true) {
+      statement s( p->parse() );
+      if ( s.eof() ) break;
+      s.execute(e);
+      read_anything = true;
+    }
+
+    if ( read_anything && args.prove_symbol.size() )
+      prove_symbol( e, args );
+  }
+  catch ( exception const& ex ) {
+    error = make_string() << p->line() << ": " << ex.what();
+  }
+  catch ( script_exception const& ) {
+    error = make_string() << p->line() << ": break outside a proof";
+  }
+
+  if ( error.empty() && args.prove_one && !e.done_one_proof() )
+    error = "No touch proved";
+
+  vector<execution_context::proof_result> const& results = e.get_results();
+  ok = error.empty() && !e.failure();
+
+  make_string result;
+  ostream& os = result.out_stream();
+  os << "{\"index\":" << j.index;
+  if ( j.id.size() ) os << ",\"id\":" << j.id;
+  os << ",\"result\":";
+  write_string( os, error.size() ? "error"
+                  : results.empty() ? "none" : results.back().status );
+
+  os << ",\"proofs\":[";
+  for ( vector<execution_context::proof_result>::const_iterator
+          i = results.begin(), e = results.end(); i != e; ++i ) {
+    if ( i != results.begin() ) os << ',';
+    os << "{\"result\":"; write_string( os, i->status );
+    os << ",\"length\":" << i->length
+       << ",\"music\":" << i->music_score
+       << ",\"end\":"; write_string( os, i->end.print() );
+    os << ",\"false_rows\":[";
+    for ( prover::failinfo::const_iterator
+            fi = i->false_rows.begin(), fe = i->false_rows.end();
+          fi != fe; ++fi ) {
+      if ( fi != i->false_rows.begin() ) os << ',';
+      os << "{\"row\":"; write_string( os, fi->_row.print() );
+      os << ",\"lines\":[";
+      for ( list<int>::const_iterator li = fi->_lines.begin(),
+              le = fi->_lines.end(); li != le; ++li )
+        os << ( li == fi->_lines.begin() ? "" : "," ) << *li;
+      os << "]}";
+    }
+    os << "]}";
+  }
+  os << ']';
+
+  os << ",\"output\":"; write_string( os, output );
+  if ( error.size() ) { os << ",\"error\":"; write_string( os, error ); }
+  os << "}\n";
+  return result;
+}
+
+// The result line for a composition that could not be read
+string error_result( size_t index, string const& error )
+{
+  make_string result;
+  ostream& os = result.out_stream();
+  os << "{\"index\":" << index << ",\"result\":\"error\",\"proofs\":[]"
+     << ",\"output\":\"\",\"error\":";
+  write_string( os, error );
+  os << "}\n";
+  return result;
+}
+
+#if RINGING_USE_THREADS
+// Hands jobs out to the worker threads, and writes their results in
+// the order the jobs were read.
+class batch_pool
+{
+public:
+  explicit batch_pool( size_t max_queued )
+    : max_queued(max_queued), next_out(0), finished(false), all_ok(true) {}
+
+  // Called by the reader; blocks while the queue is full
+  void push( job const& j );
+  void push_result( size_t index, string const& result, bool ok );
+  void close();
+
+  // Called by the workers; returns false once there is no more work
+  bool pop( job& j );
+
+  bool ok() const { return all_ok; }
+
+private:
+  void write_done();
+
+  std::mutex m;
+  std::condition_variable not_empty, not_full;
+  list<job> queue;
+  size_t max_queued;
+
+  map<size_t, string> done;
+  size_t next_out;
+  bool finished, all_ok;
+};
+
+void batch_pool::push( job const& j )
+{
+  std::unique_lock<std::mutex> lock(m);
+  while ( queue.size() >= max_queued ) not_full.wait(lock);
+  queue.push_back(j);
+  not_empty.notify_one();
+}
+
+void batch_pool::close()
+{
+  std::lock_guard<std::mutex> lock(m);
+  finished = true;
+  not_empty.notify_all();
+}
+
+bool batch_pool::pop( job& j )
+{
+  std::unique_lock<std::mutex> lock(m);
+  while ( queue.empty() && !finished ) not_empty.wait(lock);
+  if ( queue.empty() ) return false;
+  j = queue.front();
+  queue.pop_front();
+  not_full.notify_one();
+  return true;
+}
+
+void batch_pool::push_result( size_t index, string const& result, bool ok )
+{
+  std::lock_guard<std::mutex> lock(m);
+  if ( !ok ) all_ok = false;
+  done[index] = result;
+  write_done();
+}
+
+void batch_pool::write_done()
+{
+  bool any = false;
+  for ( map<size_t, string>::iterator i = done.begin();
+        i != done.end() && i->first == next_out; done.erase(i++), ++next_out )
+    cout << i->second, any = true;
+  if ( any ) cout << flush;
+}
+
+// Reference counts are not thread-safe, so no two threads may share
+// an expression node.  Each worker but the first builds its own 
+// environment in its own thread, rather than copying one.
+void worker( batch_pool& pool, execution_context const* env,
+             const arguments& args )
+{
+  scoped_pointer<execution_context> own;
+  if ( !env ) {
+    own.reset( new execution_context( cout, args ) );
+    try {
+      initialise( *own, args );
+    }
+    catch ( exception const& ex ) {
+      cerr << "Unexpected error: " << ex.what() << endl;
+      exit(2);
+    }
+    env = own.get();
+  }
+
+  job j;
+  while ( pool.pop(j) ) {
+    bool ok;
+    string result( prove_job( *env, args, j, ok ) );
+    pool.push_result( j.index, result, ok );
+  }
+}
+#endif
+
+RINGING_END_ANON_NAMESPACE
+
+bool run_batch( execution_context const& env, const arguments& args )
+{
+  scoped_pointer<istream> file;
+  if ( !args.filename.empty() ) {
+    file.reset( new ifstream( args.filename.c_str() ) );
+    if ( !*file ) {
+      cerr << "Error opening file: " << args.filename << "\n";
+      exit(3);
+    }
+  }
+
+  batch_reader reader( file.get() ? *file : cin, args );
+  bool all_ok = true;
+  job j;
+
+#if RINGING_USE_THREADS
+  if ( args.threads > 1 ) {
+    // The first worker uses ENV, which this thread no longer touches
+    batch_pool pool( 4 * args.threads );
+    vector<std::thread> threads;
+    for ( int i = 0; i < args.threads; ++i )
+      threads.push_back( std::thread( worker, std::ref(pool),
+                                      i ? NULL : &env, std::cref(args) ) );
+
+    while (true) {
+      try {
+        if ( !reader.next(j) ) break;
+        pool.push(j);
+      }
+      catch ( exception const& ex ) {
+        pool.push_result( j.index, error_result( j.index, ex.what() ),
+                          false );
+      }
+    }
+
+    pool.close();
+    for ( vector<std::thread>::iterator i = threads.begin(),
+            e = threads.end(); i != e; ++i )
+      i->join();
+
+    return pool.ok();
+  }
+#endif
+
+  while (true) {
+    string result;
+    try {
+      if ( !reader.next(j) ) break;
+      bool ok;
+      result = prove_job( env, args, j, ok );
+      if ( !ok ) all_ok = false;
+    }
+    catch ( exception const& ex ) {
+      result = error_result( j.index, ex.what() );
+      all_ok = false;
+    }
+    cout << result << flush;
+  }
+
+  return all_ok;
+}
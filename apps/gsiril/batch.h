@@ -0,0 +1,41 @@
+// -*- C++ -*- batch.h - Prove many compositions in one process
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef GSIRIL_BATCH_INCLUDED
+#define GSIRIL_BATCH_INCLUDED
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+
+class execution_context;
+struct arguments;
+
+// Defined in main.cpp
+void initialise( execution_context& ex, const arguments& args );
+void prove_symbol( execution_context& e, const arguments& args );
+
+// Reads compositions from the -f file or standard input and proves
+// each one in a copy of E, which must already have been initialised.
+// One line of JSON describing the outcome is written to standard output
+// for each composition, in the order they were read.  Returns true if
+// every composition was read and proved successfully.
+bool run_batch( execution_context const& e, const arguments& args );
+
+#endif // GSIRIL_BATCH_INCLUDED
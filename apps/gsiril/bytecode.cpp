@@ -0,0 +1,312 @@
+// bytecode.cpp - Compiled form of an expression
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+
+#include "bytecode.h"
+#include "expression.h"
+#include "proof_context.h"
+
+#include <cassert>
+
+RINGING_USING_NAMESPACE
+
+static const size_t npos = size_t(-1);
+
+// Don't memoise blocks longer than this
+static const size_t max_block_size = 65536;
+
+bytecode::bytecode( proof_context& ctx, expression const& e )
+  : ctx(ctx), cur(NULL)
+{
+  compile_segment( e, +1, npos );
+}
+
+size_t bytecode::new_segment()
+{
+  segs.push_back( segment() );
+  seg_rows.push_back( npos );
+  seg_blocks.push_back( npos );
+  return segs.size() - 1;
+}
+
+size_t bytecode::compile_segment( expression const& e, int dir, size_t id )
+{
+  if ( id == npos ) id = new_segment();
+
+  // segs may be reallocated while compiling, so build the segment
+  // separately and move it into place at the end.
+  segment code;
+  segment* saved = cur; cur = &code;
+  e.compile( *this, dir );
+  cur = saved;
+
+  segs[id].swap(code);
+
+  seg_rows[id] = count_rows(id);
+  // There's no point memoising a single run of place notation
+  if ( seg_rows[id] != npos && seg_rows[id] <= max_block_size
+       && ( segs[id].size() > 1 || segs[id][0].op != op_changes ) ) {
+    seg_blocks[id] = blocks.size();
+    blocks.push_back( block() );
+    block& b = blocks.back();
+    b.verified = npos;
+    b.rows.reserve( seg_rows[id] );
+    row r( ctx.bells() );
+    build_block( id, b, r );
+  }
+
+  return id;
+}
+
+// The number of rows in a segment, or -1 if it cannot be memoised.
+// A segment cannot be memoised if it contains anything other than
+// place notation, transpositions and symbols whose segments can be
+// memoised (and which have been fully compiled, which excludes
+// recursion), or is empty.
+size_t bytecode::count_rows( size_t seg ) const
+{
+  size_t n = 0;
+  for ( segment::const_iterator i = segs[seg].begin(), e = segs[seg].end();
+        i != e; ++i )
+    switch ( i->op ) {
+    case op_changes: n += i->len; break;
+    case op_transp:  n += 1; break;
+
+    case op_symbol: {
+      size_t s = syms[i->arg].seg[ i->dir > 0 ? 0 : 1 ];
+      if ( s == npos || seg_rows[s] == npos )
+        return npos;
+      n += seg_rows[s];
+      break;
+    }
+
+    default:
+      return npos;
+    }
+
+  return n ? n : npos;
+}
+
+void bytecode::build_block( size_t seg, block& b, row& r ) const
+{
+  for ( segment::const_iterator i = segs[seg].begin(), e = segs[seg].end();
+        i != e; ++i )
+    switch ( i->op ) {
+    case op_changes: {
+      // Music strokes restart with each run of place notation, as 
+      // they do with each use of permute_and_prove
+      bool backstroke = false;
+      for ( size_t j = i->arg; j != i->arg + i->len; ++j ) {
+        r *= pool[j];
+        proof_context::block_row br = { r, backstroke };
+        b.rows.push_back(br);
+        backstroke = !backstroke;
+      }
+      break;
+    }
+
+    case op_transp: {
+      r *= rows[i->arg];
+      proof_context::block_row br = { r, false };
+      b.rows.push_back(br);
+      break;
+    }
+
+    case op_symbol: {
+      checkpoint c = { b.rows.size(), npos, i->arg, i->dir };
+      size_t n = b.checks.size();
+      b.checks.push_back(c);
+      build_block( syms[i->arg].seg[ i->dir > 0 ? 0 : 1 ], b, r );
+      b.checks[n].end = b.rows.size();
+      break;
+    }
+
+    default:
+      assert(false);
+    }
+}
+
+void bytecode::add_changes( vector<change> const& changes, int dir )
+{
+  if ( changes.empty() ) return;
+
+  size_t off = pool.size();
+  if ( dir > 0 ) pool.insert( pool.end(), changes.begin(), changes.end() );
+  else pool.insert( pool.end(), changes.rbegin(), changes.rend() );
+  cur->push_back( instruction( op_changes, dir, off, changes.size() ) );
+}
+
+void bytecode::add_transp( row const& transp )
+{
+  cur->push_back( instruction( op_transp, +1, rows.size() ) );
+  rows.push_back( transp );
+}
+
+void bytecode::add_symbol( symbol_id sym, int dir )
+{
+  map<symbol_id, size_t>::const_iterator i = sym_index.find(sym);
+  size_t s;
+  if ( i != sym_index.end() )
+    s = i->second;
+  else {
+    s = syms.size();
+    syms.push_back( symbol_entry() );
+    syms[s].id = sym;
+    if ( ctx.defined(sym) ) syms[s].defn = ctx.lookup_symbol(sym);
+    syms[s].seg[0] = syms[s].seg[1] = npos;
+    sym_index[sym] = s;
+  }
+
+  // Allocate the segment before compiling it so that recursive
+  // references find it.
+  size_t& seg = syms[s].seg[ dir > 0 ? 0 : 1 ];
+  if ( seg == npos && !syms[s].defn.isnull() ) {
+    size_t id = seg = new_segment();
+    compile_segment( syms[s].defn, dir, id );
+  }
+
+  cur->push_back( instruction( op_symbol, dir, s ) );
+}
+
+void bytecode::add_loop( int count, expression const& body, int dir )
+{
+  size_t id = compile_segment( body, dir, npos );
+  cur->push_back( instruction( op_loop, dir, id,
+                               count == -1 ? npos : size_t(count) ) );
+}
+
+void bytecode::add_exec( expression const& e, int dir )
+{
+  cur->push_back( instruction( op_exec, dir, exprs.size() ) );
+  exprs.push_back(e);
+}
+
+void bytecode::execute()
+{
+  run(0);
+}
+
+bool bytecode::check_symbol( size_t sym ) const
+{
+  symbol_entry const& s = syms[sym];
+  return ctx.defined(s.id) && ctx.lookup_symbol(s.id).same(s.defn);
+}
+
+void bytecode::run( size_t seg )
+{
+  if ( seg_blocks[seg] != npos ) 
+    run_block( seg );
+  else
+    run_segment( seg );
+}
+
+void bytecode::run_block( size_t seg )
+{
+  block& b = blocks[ seg_blocks[seg] ];
+
+  if ( b.verified != ctx.definitions_generation() ) {
+    for ( vector<checkpoint>::const_iterator 
+            i = b.checks.begin(), e = b.checks.end(); i != e; ++i )
+      if ( !check_symbol( i->sym ) ) {
+        run_segment( seg );
+        return;
+      }
+    b.verified = ctx.definitions_generation();
+  }
+
+  typedef proof_context::block_row block_row;
+  block_row const* const rows = &b.rows[0];
+  size_t i = 0, n = b.rows.size();
+  row start( ctx.current_row() );
+  vector<checkpoint>::const_iterator ci = b.checks.begin(), 
+    ce = b.checks.end();
+
+  while ( i < n ) {
+    if ( b.verified == ctx.definitions_generation() ) {
+      // Nothing has been redefined, so every symbol is still valid
+      i = ctx.prove_block( start, rows + i, rows + n ) - rows;
+      while ( ci != ce && ci->begin < i ) ++ci;
+    }
+    else if ( ci != ce && ci->begin == i ) {
+      // A hook has defined something: check each symbol as it is
+      // reached, as the tree walker would look it up
+      symbol_entry const& s = syms[ci->sym];
+      expression defn( ctx.lookup_symbol(s.id) );
+      if ( defn.same(s.defn) ) { ++ci; continue; }
+
+      // Execute the new definition, and carry on with the rest of
+      // the block from the row it finishes on
+      defn.execute( ctx, ci->dir );
+      i = ci->end;
+      start = ctx.current_row() * rows[i-1].rel.inverse();
+      while ( ci != ce && ci->begin < i ) ++ci;
+    }
+    else {
+      size_t next = ci != ce ? ci->begin : n;
+      i = ctx.prove_block( start, rows + i, rows + next ) - rows;
+    }
+  }
+}
+
+void bytecode::run_segment( size_t seg )
+{
+  for ( segment::const_iterator i = segs[seg].begin(), e = segs[seg].end();
+        i != e; ++i )
+    switch ( i->op ) {
+    case op_changes:
+      ctx.prove_changes( &pool[i->arg], &pool[i->arg] + i->len );
+      break;
+
+    case op_transp:
+      ctx.permute_and_prove()( rows[i->arg] );
+      break;
+
+    case op_symbol: {
+      symbol_entry const& s = syms[i->arg];
+      expression defn( ctx.lookup_symbol(s.id) );
+      if ( defn.same(s.defn) )
+        run( s.seg[ i->dir > 0 ? 0 : 1 ] );
+      else
+        defn.execute( ctx, i->dir );
+      break;
+    }
+
+    case op_loop: {
+      // This must behave exactly as repeated_node::execute
+      proof_context::scoped_variable lc(ctx, "loop_counter");
+      try {
+        for ( size_t n=1; i->len == npos || n <= i->len; ++n ) {
+          lc.set( expression( new integer_node( (RINGING_LLONG) n ) ) );
+          run( i->arg );
+        }
+      } catch ( script_exception const& ex ) {
+        if ( ex.t != script_exception::do_break )
+          throw;
+      }
+      break;
+    }
+
+    case op_exec:
+      exprs[i->arg].execute( ctx, i->dir );
+      break;
+    }
+}
@@ -0,0 +1,136 @@
+// -*- C++ -*- bytecode.h - Compiled form of an expression
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef GSIRIL_BYTECODE_INCLUDED
+#define GSIRIL_BYTECODE_INCLUDED
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#include <map.h>
+#else
+#include <vector>
+#include <map>
+#endif
+#include <string>
+#include <ringing/row.h>
+#include <ringing/change.h>
+#include "expr_base.h"
+#include "proof_context.h"
+
+RINGING_USING_STD
+RINGING_USING_NAMESPACE
+
+// A compiled expression.  Runs of place notation are copied into a
+// single pool of changes (already reversed where they are executed
+// backwards), repeats become loops over a flattened body, and each
+// symbol is compiled once per direction into its own segment.  Symbol
+// references are resolved when the bytecode is compiled, but are
+// checked against the current definition each time they are executed:
+// if the symbol has been redefined, the new definition is executed
+// by the tree walker.  Any node that cannot be compiled is also
+// handed back to the tree walker, so the result of executing the
+// bytecode is always the same as executing the original expression.
+//
+// A segment which only contains place notation, transpositions and
+// symbols whose segments are likewise is also memoised as a block: 
+// the rows it produces relative to its starting row.  A block is
+// executed by transposing its rows by the starting row, checking the
+// symbols it was built from only when the definitions may have changed.
+class bytecode
+{
+public:
+  bytecode( proof_context& ctx, expression const& e );
+
+  void execute();
+
+  // These are used by expression::node::compile
+  void add_changes( vector<change> const& changes, int dir );
+  void add_transp( row const& transp );
+  void add_symbol( symbol_id sym, int dir );
+  void add_loop( int count, expression const& body, int dir );
+  void add_exec( expression const& e, int dir );
+
+private:
+  enum opcode { op_changes, op_transp, op_symbol, op_loop, op_exec };
+
+  // The meaning of arg and len depends on the opcode:
+  //   op_changes  offset and length of the run in the change pool
+  //   op_transp   index into rows
+  //   op_symbol   index into syms
+  //   op_loop     the segment for the body and the repeat count
+  //   op_exec     index into exprs
+  struct instruction {
+    instruction( opcode op, int dir, size_t arg, size_t len = 0 )
+      : op(op), dir(dir), arg(arg), len(len) {}
+
+    opcode op;
+    int dir;
+    size_t arg, len;
+  };
+
+  typedef vector<instruction> segment;
+
+  // The rows [begin, end) of a block were produced by a symbol, which
+  // must still have the same definition when the block is executed.
+  struct checkpoint {
+    size_t begin, end;
+    size_t sym;
+    int dir;
+  };
+
+  struct block {
+    vector<proof_context::block_row> rows;
+    vector<checkpoint> checks;
+    size_t verified; // generation at which all checks last passed
+  };
+
+  struct symbol_entry {
+    symbol_id id;
+    expression defn;
+    size_t seg[2]; // forwards and backwards
+  };
+
+  size_t new_segment();
+  size_t compile_segment( expression const& e, int dir, size_t id );
+  size_t count_rows( size_t seg ) const;
+  void build_block( size_t seg, block& b, row& r ) const;
+  bool check_symbol( size_t sym ) const;
+
+  void run( size_t seg );
+  void run_segment( size_t seg );
+  void run_block( size_t seg );
+
+  proof_context& ctx;
+  vector<change> pool;
+  vector<row> rows;
+  vector<expression> exprs;
+  vector<symbol_entry> syms;
+  map<symbol_id, size_t> sym_index;
+  vector<segment> segs;
+  vector<size_t> seg_rows;   // length if it can be memoised, or -1
+  vector<size_t> seg_blocks; // index into blocks, or -1
+  vector<block> blocks;
+  segment* cur;
+};
+
+#endif // GSIRIL_BYTECODE_INCLUDED
@@ -31,6 +31,8 @@
 
 RINGING_USING_NAMESPACE
 
+static const symbol_id first_sym = intern_symbol("__first__");
+
 
 int execution_context::bells( int b ) 
 {
@@ -44,6 +46,7 @@ int execution_context::bells( int b )
     }
 
   swap( b, args.bells.get() );
+  ++env_generation;
   define_line();
   return b;
 }
@@ -85,12 +88,13 @@ execution_context::expected_length( pair<size_t, size_t> l )
   }
 
   swap( l, args.expected_length ); 
+  ++env_generation;
   return l;
 }
 
 execution_context::execution_context( ostream& os, const arguments& a )
   : args(a), rmask(a.row_mask.length() ? a.row_mask : "*"), os(&os), 
-    failed(false), node_count(0), done_proof(false)
+    failed(false), node_count(0), done_proof(false), env_generation(0)
 {
   if ( args.bells ) {
     if ( !args.rounds.bells() )
@@ -109,11 +113,22 @@ bool execution_context::defined( const string& sym ) const
   return !sym_table.lookup(sym).isnull();
 }
 
+bool execution_context::defined( symbol_id sym ) const
+{
+  return !sym_table.lookup(sym).isnull();
+}
+
 expression execution_context::lookup_symbol( const string& sym ) const
+{
+  return lookup_symbol( intern_symbol(sym) );
+}
+
+expression execution_context::lookup_symbol( symbol_id sym ) const
 {
   expression e( sym_table.lookup(sym) );
   if ( e.isnull() )
-    throw runtime_error( make_string() << "Unknown symbol: " << sym );
+    throw runtime_error( make_string() << "Unknown symbol: " 
+                           << symbol_name(sym) );
   return e;
 }
 
@@ -129,20 +144,23 @@ bool execution_context::default_define_symbol( const pair< const string, express
 
   sym_table.define(defn);
 
-  if ( sym_table.lookup( "__first__" ).isnull() )
-    sym_table.define
-      ( pair<const string, expression>( "__first__", defn.second ) );
+  if ( sym_table.lookup( first_sym ).isnull() )
+    sym_table.define( first_sym, defn.second );
   return true;
 }
 
 bool execution_context::define_symbol( const pair< const string, expression > &defn )
 {
-  if ( sym_table.define(defn) )
+  return define_symbol( intern_symbol(defn.first), defn.second );
+}
+
+bool execution_context::define_symbol( symbol_id sym, const expression& val )
+{
+  if ( sym_table.define(sym, val) )
     return true;  // redefinition can't be first
 
-  if ( sym_table.lookup( "__first__" ).isnull() )
-    sym_table.define
-      ( pair<const string, expression>( "__first__", defn.second ) );
+  if ( sym_table.lookup( first_sym ).isnull() )
+    sym_table.define( first_sym, val );
   return false;
 }
 
@@ -27,8 +27,10 @@
 
 #if RINGING_OLD_INCLUDES
 #include <map.h>
+#include <vector.h>
 #else
 #include <map>
+#include <vector>
 #endif
 #if RINGING_HAVE_OLD_IOSTREAM
 #include <ostream.h>
@@ -48,6 +50,8 @@ RINGING_USING_STD
 RINGING_USING_NAMESPACE
 
 class expression;
+struct proof_history;
+struct import_cache;
 
 class execution_context
 {
@@ -56,19 +60,23 @@ public:
  ~execution_context();
 
   ostream& output() const { return *os; }
+  void output( ostream& o ) { os = &o; }
 
   bool defined( const string& sym ) const;
+  bool defined( symbol_id sym ) const;
 
   // Returns true for a redefinition and false otherwise
   bool define_symbol( const pair< const string, expression > &defn );
+  bool define_symbol( symbol_id sym, const expression& val );
 
   // Returns true if used and false otherwise
   bool default_define_symbol( const pair< const string, expression > &defn );
 
   void undefine_symbol( const string& sym );
   expression lookup_symbol( const string &sym ) const;
+  expression lookup_symbol( symbol_id sym ) const;
  
-  void extents( int n ) { args.num_extents = n; }
+  void extents( int n ) { args.num_extents = n; ++env_generation; }
   int  extents() const { return args.num_extents; }
 
   int bells( int b );
@@ -80,7 +88,7 @@ public:
   bool verbose( bool v ) { swap(v, args.verbose.get()); return v; }
   bool verbose() const   { return args.verbose; }
 
-  row rounds( row r ) { swap(r, args.rounds); return r; }
+  row rounds( row r ) { swap(r, args.rounds); ++env_generation; return r; }
   row rounds() const { return args.rounds; }
 
   const arguments& get_args() const { return args; }
@@ -100,13 +108,39 @@ public:
   music_details const& row_mask() const { return rmask; }
   void row_mask(music_details const& m);
 
-  void clear_music() { mus.clear(bells()); }
-  void add_music(music const& m) { mus.append(m); }
+  void clear_music() { mus.clear(bells()); ++env_generation; }
+  void add_music(music const& m) { mus.append(m); ++env_generation; }
   music const& get_music() const { return mus; }
 
+  // Incremented whenever anything other than a symbol that can affect
+  // a proof is changed
+  size_t environment_generation() const { return env_generation; }
+
+  // The rows of the last proof, kept in interactive mode
+  shared_pointer<proof_history> take_history() 
+    { shared_pointer<proof_history> h; h.swap(history); return h; }
+  void save_history( shared_pointer<proof_history> const& h ) { history = h; }
+
   bool evaluate_bool_const( expression const& ) const;
   string evaluate_string_var( string const& ) const;
 
+  // The outcome of a prove statement, recorded in batch mode
+  struct proof_result {
+    string status; // true, false, notround, tooshort, aborted or terminated
+    size_t length;
+    int music_score;
+    row end;
+    prover::failinfo false_rows;
+  };
+
+  void add_result( proof_result const& r ) { results.push_back(r); }
+  vector<proof_result> const& get_results() const { return results; }
+
+  // The files parsed by import.  These are shared with copies of this
+  // context, which share its definitions anyway, but not with any other
+  // context, so independent contexts never share parsed statements.
+  shared_pointer<import_cache>& imported_files() { return imports; }
+
 private:
   void define_line();
 
@@ -118,6 +152,10 @@ private:
   bool failed;
   mutable RINGING_ULLONG node_count;
   bool done_proof;
+  vector<proof_result> results;
+  size_t env_generation;
+  shared_pointer<proof_history> history;
+  shared_pointer<import_cache> imports;
 };
 
 #endif // GSIRIL_EXECUTION_CONTEXT_INCLUDED
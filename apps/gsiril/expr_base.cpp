@@ -28,6 +28,7 @@
 #include "proof_context.h"
 #include "execution_context.h"
 #include "expression.h"
+#include "bytecode.h"
 
 RINGING_USING_NAMESPACE
 
@@ -136,6 +137,11 @@ void expression::execute( proof_context &ctx, int dir ) const {
   impl->execute(ctx, dir); 
 }
 
+void expression::compile( bytecode &bc, int dir ) const { 
+  if ( !impl->compile(bc, dir) )
+    bc.add_exec(*this, dir);
+}
+
 expression expression::evaluate( proof_context& ctx ) const { 
   ctx.increment_node_count();
   return impl->evaluate(ctx); 
@@ -41,6 +41,7 @@ RINGING_USING_NAMESPACE
 class proof_context;
 class execution_context;
 class parser;
+class bytecode;
 
 // Represents a whole statement (e.g. a definition, proof, ...)
 class statement 
@@ -95,6 +96,10 @@ public:
     virtual type_t type( proof_context &ctx ) const { return no_type; }
     virtual string name( proof_context &ctx ) const;
 
+    // Add instructions to execute the node to the bytecode.  Returns
+    // false if the node can only be executed by the tree walker.
+    virtual bool compile( bytecode &bc, int dir ) const { return false; }
+
   protected:
 #   if __cplusplus >= 201103L
     [[noreturn]]
@@ -138,9 +143,15 @@ public:
 
   void debug_print( ostream &os ) const    { impl->debug_print(os); }
 
+  // Do two handles refer to the same node?
+  bool same( expression const& o ) const { return impl == o.impl; }
+
   // execute an expression, possibly adding to the current proof
   void execute( proof_context &ctx, int dir ) const;
 
+  // compile an expression, falling back to executing the tree
+  void compile( bytecode &bc, int dir ) const;
+
   // Evaluate a const expression in boolean, integer or stringcontext.
   // If evaluation requires execution of an expression, a silent clone
   // of the proof_context is made and discarded at the end of the evaluation.
@@ -26,6 +26,7 @@
 
 #include "expression.h"
 #include "proof_context.h"
+#include "bytecode.h"
 #include <ringing/streamutils.h>
 #include <ringing/method.h>
 #include <ringing/music.h>
@@ -52,6 +53,14 @@ void list_node::execute( proof_context &ctx, int dir ) const
   if (dir <= 0) car.execute( ctx, dir );
 }
 
+bool list_node::compile( bytecode &bc, int dir ) const
+{
+  if (dir > 0) car.compile( bc, dir );
+  cdr.compile( bc, dir );
+  if (dir <= 0) car.compile( bc, dir );
+  return true;
+}
+
 expression list_node::evaluate( proof_context &ctx ) const
 {
   car.execute( ctx, +1 );
@@ -99,6 +108,11 @@ void nop_node::execute( proof_context &, int dir ) const
 {
 }
 
+bool nop_node::compile( bytecode &, int dir ) const
+{
+  return true;
+}
+
 bool nop_node::isnop() const
 {
   return true;
@@ -126,6 +140,12 @@ void repeated_node::execute( proof_context &ctx, int dir ) const
   }
 }
 
+bool repeated_node::compile( bytecode &bc, int dir ) const
+{
+  bc.add_loop( count, child, dir );
+  return true;
+}
+
 vector<change> repeated_node::pn_evaluate( proof_context &ctx ) const {
   if (count == -1)
     unable_to("evaluate repeat expression as a static block of changes");
@@ -158,6 +178,12 @@ void reverse_node::execute( proof_context &ctx, int dir ) const
   child.execute( ctx, -dir );
 }
 
+bool reverse_node::compile( bytecode &bc, int dir ) const
+{
+  child.compile( bc, -dir );
+  return true;
+}
+
 vector<change> reverse_node::pn_evaluate( proof_context &ctx ) const 
 {
   vector<change> fwd( child.pn_evaluate(ctx) );
@@ -317,6 +343,12 @@ void pn_node::execute( proof_context &ctx, int dir ) const
     for_each( changes.rbegin(), changes.rend(), ctx.permute_and_prove() );
 }
 
+bool pn_node::compile( bytecode &bc, int dir ) const
+{
+  bc.add_changes( changes, dir );
+  return true;
+}
+
 string pn_node::name( proof_context &ctx ) const { 
   return meth_name;
 }
@@ -414,6 +446,12 @@ void transp_node::execute( proof_context &ctx, int dir ) const
   ctx.permute_and_prove()( transp );
 }
 
+bool transp_node::compile( bytecode &bc, int dir ) const
+{
+  bc.add_transp( transp );
+  return true;
+}
+
 void symbol_node::debug_print( ostream &os ) const
 {
   os << sym;
@@ -421,73 +459,79 @@ void symbol_node::debug_print( ostream &os ) const
 
 void symbol_node::execute( proof_context &ctx, int dir ) const
 {
-  ctx.execute_symbol(sym, dir);
+  ctx.execute_symbol(id, dir);
+}
+
+bool symbol_node::compile( bytecode &bc, int dir ) const
+{
+  bc.add_symbol( id, dir );
+  return true;
 }
 
 expression symbol_node::evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.evaluate(ctx);
 }
 
 bool symbol_node::bool_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.bool_evaluate(ctx);
 }
 
 RINGING_LLONG symbol_node::int_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.int_evaluate(ctx);
 }
 
 string symbol_node::string_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.string_evaluate(ctx);
 }
 
 string symbol_node::string_evaluate( proof_context &ctx, bool *no_nl ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.string_evaluate(ctx, no_nl);
 }
 
 vector<change> symbol_node::pn_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.pn_evaluate(ctx);
 }
 
 music symbol_node::music_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.music_evaluate(ctx);
 }
 
 vector<expression> symbol_node::array_evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.array_evaluate(ctx);
 }
 
 expression::type_t symbol_node::type( proof_context& ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.type(ctx);
 }
 
 string symbol_node::name( proof_context& ctx ) const
 {
-  expression e( ctx.lookup_symbol(sym) );
+  expression e( ctx.lookup_symbol(id) );
   return e.name(ctx);
 }
 
 void
 symbol_node::apply_replacement( proof_context& ctx, vector<change>& m ) const
 {
-   expression e( ctx.lookup_symbol(sym) );
+   expression e( ctx.lookup_symbol(id) );
    return e.apply_replacement(ctx, m);
 }
 
@@ -511,7 +555,7 @@ static void throw_no_backwards_execution(expression::node const& x)
 void assign_node::execute( proof_context& ctx, int dir ) const
 {
   if (dir < 0) throw_no_backwards_execution(*this);
-  ctx.define_symbol(defn);
+  ctx.define_symbol(id, defn.second);
 }
 
 void append_assign_node::debug_print( ostream &os ) const
@@ -524,7 +568,7 @@ void append_assign_node::debug_print( ostream &os ) const
 void append_assign_node::execute( proof_context& ctx, int dir ) const
 {
   if (dir < 0) throw_no_backwards_execution(*this);
-  ctx.define_symbol( make_pair(sym, apply(ctx.lookup_symbol(sym), val, ctx)) );
+  ctx.define_symbol( id, apply(ctx.lookup_symbol(id), val, ctx) );
 }
 
 expression 
@@ -544,7 +588,7 @@ void immediate_assign_node::debug_print( ostream &os ) const
 void immediate_assign_node::execute( proof_context& ctx, int dir ) const
 {
   if (dir < 0) throw_no_backwards_execution(*this);
-  ctx.define_symbol( make_pair(sym, val.evaluate(ctx)) );
+  ctx.define_symbol( id, val.evaluate(ctx) );
 }
 
 static void validate_regex( const music_details& desc, int bells )
@@ -663,7 +707,7 @@ void defined_node::debug_print( ostream &os ) const
 
 bool defined_node::bool_evaluate( proof_context &ctx ) const
 {
-  return ctx.defined(sym);
+  return ctx.defined(id);
 }
 
 void boolean_node::debug_print( ostream &os ) const
@@ -930,8 +974,8 @@ void add_node::debug_print( ostream &os ) const
 
 RINGING_LLONG increment_node::int_evaluate( proof_context& ctx ) const
 {
-  RINGING_LLONG res( ctx.lookup_symbol(sym).int_evaluate(ctx) + val );
-  ctx.define_symbol( make_pair( sym, expression( new integer_node(res) ) ) );
+  RINGING_LLONG res( ctx.lookup_symbol(id).int_evaluate(ctx) + val );
+  ctx.define_symbol( id, expression( new integer_node(res) ) );
   return res;
 }
 
@@ -1033,7 +1077,7 @@ void call_node::execute( proof_context& ctx, int dir ) const
 
 expression call_node::evaluate( proof_context &ctx ) const
 {
-  expression e( ctx.lookup_symbol(name) );
+  expression e( ctx.lookup_symbol(id) );
   return e.call(ctx, args);
 }
 
@@ -1074,12 +1118,12 @@ vector<expression> call_node::array_evaluate( proof_context &ctx ) const
 
 expression::type_t call_node::type( proof_context &ctx ) const
 {
-  return ctx.lookup_symbol(name).type(ctx);
+  return ctx.lookup_symbol(id).type(ctx);
 }
 
 void save_node::execute( proof_context& ctx, int dir ) const
 {
-  ctx.save_symbol(name);
+  ctx.save_symbol(id);
 }
 
 void save_node::debug_print( ostream& os ) const
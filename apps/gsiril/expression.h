@@ -26,6 +26,7 @@
 #endif
 
 #include "expr_base.h"
+#include "symbol_table.h"
 #include <utility>
 #include <string>
 #include <ringing/row.h>
@@ -48,6 +49,7 @@ public:
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual expression evaluate( proof_context &ctx ) const;
   virtual bool bool_evaluate( proof_context &ctx ) const;
   virtual RINGING_LLONG int_evaluate( proof_context &ctx ) const;
@@ -63,6 +65,7 @@ class nop_node : public expression::node {
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual bool isnop() const;
 };
 
@@ -75,6 +78,7 @@ public:
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual vector<change> pn_evaluate( proof_context &ctx ) const;
 
 private:  
@@ -90,6 +94,7 @@ public:
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual vector<change> pn_evaluate( proof_context &ctx ) const;
 
 private:  
@@ -128,6 +133,7 @@ public:
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual vector<change> pn_evaluate( proof_context &ctx ) const
     { return changes; }
   virtual void apply_replacement( proof_context& ctx, vector<change>& m ) const;
@@ -177,6 +183,7 @@ public:
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
 
 private:
   row transp;
@@ -185,11 +192,12 @@ private:
 class symbol_node : public expression::node {
 public:
   symbol_node( const string &sym )
-    : sym(sym) {}
+    : sym(sym), id( intern_symbol(sym) ) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
   virtual void execute( proof_context &ctx, int dir ) const;
+  virtual bool compile( bytecode &bc, int dir ) const;
   virtual expression evaluate( proof_context &ctx ) const;
   virtual bool bool_evaluate( proof_context &ctx ) const;
   virtual RINGING_LLONG int_evaluate( proof_context &ctx ) const;
@@ -204,12 +212,13 @@ protected:
 
 private:
   string sym;
+  symbol_id id;
 };
 
 class assign_node : public expression::node {
 public:
   assign_node( const string& sym, const expression& val )
-    : defn( make_pair(sym, val) ) {}
+    : defn( make_pair(sym, val) ), id( intern_symbol(sym) ) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -217,13 +226,14 @@ protected:
 
 private:
   pair< const string, expression > defn;
+  symbol_id id;
 };
 
 // TODO: Make this a generic op_assign_node
 class append_assign_node : public expression::node {
 public:
   append_assign_node( const string& sym, const expression& val )
-    : sym(sym), val(val) {}
+    : sym(sym), id( intern_symbol(sym) ), val(val) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -234,13 +244,14 @@ private:
                     proof_context& ctx ) const;
 
   const string sym;
+  symbol_id id;
   expression val;
 };
 
 class immediate_assign_node : public expression::node {
 public:
   immediate_assign_node( const string& sym, const expression& val )
-    : sym(sym), val(val) {}
+    : sym(sym), id( intern_symbol(sym) ), val(val) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -248,6 +259,7 @@ protected:
 
 private:
   const string sym;
+  symbol_id id;
   expression val;
 };
 
@@ -301,7 +313,7 @@ private:
 class defined_node : public expression::bnode {
 public:
   defined_node( const string& sym )
-    : sym(sym) {}
+    : sym(sym), id( intern_symbol(sym) ) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -309,6 +321,7 @@ protected:
 
 private:
   string sym;
+  symbol_id id;
 };
 
 class boolean_node : public expression::bnode {
@@ -491,7 +504,7 @@ private:
 class increment_node : public expression::inode {
 public:
   increment_node( const string& sym, RINGING_LLONG val )
-    : sym(sym), val(val) {}
+    : sym(sym), id( intern_symbol(sym) ), val(val) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -499,6 +512,7 @@ protected:
 
 private:
   const string sym;
+  symbol_id id;
   RINGING_LLONG val;
 };
 
@@ -535,7 +549,7 @@ private:
 class call_node : public expression::node {
 public:
   call_node( string const& name, vector<expression> const& args )
-    : name(name), args(args) {}
+    : name(name), id( intern_symbol(name) ), args(args) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -552,13 +566,14 @@ protected:
 
 private:
   string name;
+  symbol_id id;
   vector<expression> args;
 };
 
 class save_node : public expression::node {
 public:
   explicit save_node( string const& name )
-    : name(name) {}
+    : name(name), id( intern_symbol(name) ) {}
 
 protected:
   virtual void debug_print( ostream &os ) const;
@@ -566,6 +581,7 @@ protected:
 
 private:
   string name;
+  symbol_id id;
 };
 
 class array_node : public expression::node {
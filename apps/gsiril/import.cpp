@@ -1,5 +1,5 @@
 // import.cpp - Code to load other gsiril files
-// Copyright (C) 2002, 2003, 2004, 2007, 2008, 2010
+// Copyright (C) 2002, 2003, 2004, 2007, 2008, 2010, 2026
 // Richard Smith <richard@ex-parrot.com>
 
 // This program is free software; you can redistribute it and/or modify
@@ -24,8 +24,14 @@
 #include <string>
 #if RINGING_OLD_INCLUDES
 #include <list.h>
+#include <map.h>
+#include <vector.h>
+#include <utility.h>
 #else
 #include <list>
+#include <map>
+#include <vector>
+#include <utility>
 #endif
 #if RINGING_OLD_IOSTREAMS
 #include <istream.h>
@@ -34,6 +40,11 @@
 #include <istream>
 #include <fstream>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "parser.h"
+#include "execution_context.h"
+#include "expr_base.h"
 
 RINGING_USING_NAMESPACE
 
@@ -57,28 +68,22 @@ list<string> split_path( string const& p )
   return pp;
 }
 
-
-
-shared_pointer<istream> try_load_file( string const& name ) 
-
+bool can_open( string const& name )
 {
-  shared_pointer<istream> in( new ifstream(name.c_str()) );
-  if ( !*in ) {
-    string filename( name ); filename += ".gsir";
-    in.reset( new ifstream(filename.c_str()) );
-  }
-  if ( !*in ) {
-    string filename( name ); filename += ".sir";
-    in.reset( new ifstream(filename.c_str()) );
-  }
-  if ( !*in )
-    in.reset();
-  return in;
+  ifstream in( name.c_str() );
+  return !!in;
 }
 
-RINGING_END_ANON_NAMESPACE
+// Returns the name of the file found, or an empty string
+string try_find_file( string const& name ) 
+{
+  if ( can_open( name ) ) return name;
+  if ( can_open( name + ".gsir" ) ) return name + ".gsir";
+  if ( can_open( name + ".sir" ) ) return name + ".sir";
+  return string();
+}
 
-shared_pointer<istream> load_file( string const& filename )
+string find_file( string const& filename )
 {
   // XXX: Some code here is common with that in ringing/library.cpp
   char const sep = RINGING_WINDOWS ? '\\' : '/';
@@ -90,19 +95,129 @@ shared_pointer<istream> load_file( string const& filename )
     isabs = true;
 #endif
 
-  shared_pointer<istream> in( try_load_file(filename) );
-  if ( !in && !isabs )
+  string path( try_find_file(filename) );
+  if ( path.empty() && !isabs )
   {
     string libpath;
     if ( char const* const gslibpath = getenv("GSIRIL_LIBRARY_PATH") )
       libpath = gslibpath;
     list<string> locs( split_path(libpath) );
     for (list<string>::const_iterator i=locs.begin(), e=locs.end(); i!=e; ++i) 
-      if ( in = try_load_file( *i + sep + filename ) )
+      if ( !( path = try_find_file( *i + sep + filename ) ).empty() )
         break;
   }
+  return path;
+}
+
+// A statement parsed from a file, with the line it ended on and the 
+// number of bells it was parsed with.
+struct parsed_statement {
+  statement s;
+  int line, bells;
+};
+
+struct parsed_file {
+  off_t size;
+  time_t mtime;
+  vector<parsed_statement> stmts;
+};
+
+// Parsing depends on the number of bells, so this is part of the key.
+typedef map< pair<string, int>, parsed_file > file_cache;
+
+RINGING_END_ANON_NAMESPACE
+
+struct import_cache {
+  file_cache files;
+};
+
+RINGING_START_ANON_NAMESPACE
+
+file_cache& get_file_cache( execution_context& e )
+{
+  shared_pointer<import_cache>& c = e.imported_files();
+  if ( !c ) c.reset( new import_cache );
+  return c->files;
+}
+
+RINGING_END_ANON_NAMESPACE
+
+shared_pointer<istream> load_file( string const& filename )
+{
+  shared_pointer<istream> in;
+  string path( find_file(filename) );
+  if ( !path.empty() )
+    in.reset( new ifstream(path.c_str()) );
   return in;
 }
 
+bool import_file( execution_context& e, string const& filename, 
+                  parser::error_policy ep )
+{
+  string path( find_file(filename) );
+  if ( path.empty() ) return false;
+
+  struct stat st;
+  bool cacheable = stat( path.c_str(), &st ) == 0;
+  pair<string, int> key( path, e.bells() );
+  file_cache& cache = get_file_cache(e);
+
+  // Run the statements from an earlier parse for as long as the 
+  // number of bells is the same as when they were parsed.  
+  size_t done = 0;
+  file_cache::const_iterator ci = cache.find(key);
+  if ( cacheable && ci != cache.end() && ci->second.size == st.st_size 
+       && ci->second.mtime == st.st_mtime ) {
+    // Copy them, as executing them may change the cache
+    vector<parsed_statement> stmts( ci->second.stmts );
+    for ( ; done < stmts.size() && stmts[done].bells == e.bells(); ++done )
+      try {
+        stmts[done].s.execute(e);
+      }
+      catch ( exception const& ex ) {
+        parser::report_error( ex, filename, stmts[done].line, ep );
+      }
+
+    if ( done == stmts.size() ) return true;
+  }
 
+  // Otherwise parse the file, skipping any statements already run
+  ifstream in( path.c_str() );
+  shared_pointer<parser> p( make_default_parser(in, e) );
+  parsed_file pf;
+  bool parsed = true;
+  for ( size_t n = 0; true; ++n ) {
+    parsed_statement ps = { statement(NULL), 0, e.bells() };
+    try {
+      ps.s = p->parse();
+    }
+    catch ( exception const& ex ) {
+      // Statements already run were parsed with the bells they needed
+      if ( n >= done ) {
+        parsed = false;
+        parser::report_error( ex, filename, p->line(), ep );
+      }
+      continue;
+    }
+
+    if ( ps.s.eof() ) break;
+    ps.line = p->line();
+    if ( n < done ) continue;
+    pf.stmts.push_back(ps);
 
+    try {
+      ps.s.execute(e);
+    }
+    catch ( exception const& ex ) {
+      parser::report_error( ex, filename, ps.line, ep );
+    }
+  }
+
+  if ( cacheable && parsed && done == 0 ) {
+    pf.size = st.st_size;
+    pf.mtime = st.st_mtime;
+    cache[key] = pf;
+  }
+
+  return true;
+}
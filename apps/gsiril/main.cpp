@@ -33,6 +33,7 @@
 #include "expression.h"
 #include "prog_args.h"
 #include "functions.h"
+#include "batch.h"
 #include <string>
 #if RINGING_OLD_INCLUDES
 #include <stdexcept.h>
@@ -135,13 +136,9 @@ void initialise( execution_context& ex, const arguments& args )
 	  i(args.import_modules.begin()), e( args.import_modules.end());
 	i != e; ++i ) 
     {
-      shared_pointer<istream> in( load_file(*i) );
-
-      if ( !in )
+      if ( !import_file( ex, *i, parser::fatal ) )
 	throw runtime_error
 	  ( make_string() << "Unable to find module: " << *i );
-
-      make_default_parser(*in, ex)->run(ex, *i, parser::fatal);
     }
     
   // The 'everyrow' symbol is defined to "@" if -E is specified.
@@ -156,32 +153,37 @@ void initialise( execution_context& ex, const arguments& args )
   ex.undefine_symbol( "__first__" );
 }
 
+void prove_symbol( execution_context& e, const arguments& args )
+{
+  // We want to suppress a warning about the prove symbol not being
+  // defined only when it is __first__: the logic being that if it
+  // has been explicitly set, it should be there; but if it is 
+  // implicitly set (e.g. by invoking as 'msiril'), we shouldn't give
+  // an error.
+  if ( args.prove_symbol != "__first__" 
+       || !e.done_one_proof() && e.defined("__first__") ) {
+    if ( e.verbose() )
+      cerr << "Proving " << args.prove_symbol << std::endl;
+
+    RINGING_ISTRINGSTREAM in("prove " + args.prove_symbol);
+
+    shared_pointer<parser> p( make_default_parser(in, e) );
+    statement s( p->parse() );
+
+    if (!p->parse().eof()) { 
+      cerr << "Unexpected content at the end of -P argument\n";
+      exit(3);
+    }
+
+    s.execute(e);
+  }
+}
+
 void prove_first_symbol( execution_context& e, const arguments& args )
 {
   try 
     {
-      // We want to suppress a warning about the prove symbol not being
-      // defined only when it is __first__: the logic being that if it
-      // has been explicitly set, it should be there; but if it is 
-      // implicitly set (e.g. by invoking as 'msiril'), we shouldn't give
-      // an error.
-      if ( args.prove_symbol != "__first__" 
-           || !e.done_one_proof() && e.defined("__first__") ) {
-        if ( e.verbose() )
-          cerr << "Proving " << args.prove_symbol << std::endl;
-
-        RINGING_ISTRINGSTREAM in("prove " + args.prove_symbol);
-
-        shared_pointer<parser> p( make_default_parser(in, e) );
-        statement s( p->parse() );
-
-        if (!p->parse().eof()) { 
-          cerr << "Unexpected content at the end of -P argument\n";
-          exit(3);
-        }
-
-        s.execute(e);
-      }
+      prove_symbol( e, args );
     } 
   catch (const exception& ex ) 
     {
@@ -310,7 +312,11 @@ int main( int argc, char *argv[] )
     execution_context e( cout, args );
     initialise(e, args);
 
-    if ( args.filter )
+    if ( args.batch ) {
+      if ( !run_batch( e, args ) )
+        ret = 1;
+    }
+    else if ( args.filter )
       filter( e, args );
     else if ( !run( e, args ) )
       if ( !args.determine_bells )
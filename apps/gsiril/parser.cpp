@@ -1034,17 +1034,23 @@ int parser::run( execution_context& e, const string& filename,
       ++count;
     }
     catch (const exception& ex ) {
-      if (filename.empty())
-        cerr << "Error: " << ex.what() << endl;
-      else
-        cerr << filename << ':' << line() << ": " << ex.what() << endl;
- 
-      if (ep == fatal)
-        exit(2);
-      else if (ep == propagate)
-        throw runtime_error( "Error importing module: " + filename );
+      report_error( ex, filename, line(), ep );
     }
   }
 
   return count;
 }
+
+void parser::report_error( const exception& ex, const string& filename,
+                           int line, error_policy ep )
+{
+  if (filename.empty())
+    cerr << "Error: " << ex.what() << endl;
+  else
+    cerr << filename << ':' << line << ": " << ex.what() << endl;
+ 
+  if (ep == fatal)
+    exit(2);
+  else if (ep == propagate)
+    throw runtime_error( "Error importing module: " + filename );
+}
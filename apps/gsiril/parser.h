@@ -28,9 +28,11 @@
 #if RINGING_OLD_INCLUDES
 #include <utility.h>
 #include <map.h>
+#include <stdexcept.h>
 #else
 #include <utility>
 #include <map>
+#include <stdexcept>
 #endif
 #if RINGING_HAVE_OLD_IOSTREAMS
 #include <istream.h>
@@ -65,6 +67,10 @@ public:
   // Run the parser until EOF, executing each statement, and return the 
   // number of statements executed.
   int run(execution_context& e, const string& filename, enum error_policy); 
+
+  // Report an error in a statement as run does
+  static void report_error( const exception& ex, const string& filename,
+                            int line, enum error_policy );
 };
 
 // if library_mode is set, the parser will not emit final
@@ -74,4 +80,11 @@ make_default_parser( istream& in, execution_context& e );
 // Defined in import.cpp
 shared_pointer<istream> load_file( string const& filename );
 
+// Find the file as load_file does, and run it as parser::run does.  The
+// statements parsed are kept, and are used again when the same file is
+// imported later in the process, unless its size or modification time 
+// has changed.  Returns false if the file cannot be found.
+bool import_file( execution_context& e, string const& filename, 
+                  parser::error_policy ep );
+
 #endif // GSIRIL_PARSER_INCLUDED
@@ -31,6 +31,7 @@
 # endif
 #endif
 
+#include <ringing/binlib.h>
 #include <ringing/cclib.h>
 #include <ringing/mslib.h>
 #include <ringing/xmllib.h>
@@ -38,6 +39,9 @@
 #include "args.h"
 #include "stringutils.h"
 #include "prog_args.h"
+#if RINGING_USE_THREADS
+#include <mutex>
+#endif
 
 RINGING_USING_NAMESPACE
 
@@ -224,6 +228,12 @@ void arguments::bind( arg_parser& p )
            "Print the number of nodes processed.",
            print_node_count ) );
 
+  p.add( new boolean_opt
+         ( '\0', "interpret", 
+           "Execute proofs by walking the expression tree instead of "
+           "compiling them first (for debugging)",
+           interpret ) );
+
   p.add( new boolean_opt
          ( '\0', "determine-bells", 
            "Determine the number of bells for each proof without proving.",
@@ -244,6 +254,29 @@ void arguments::bind( arg_parser& p )
            "Run as a filter on a method library or stream",
            filter ) );
 
+  p.add( new boolean_opt
+         ( '\0', "batch",
+           "Prove each of a series of compositions separately, "
+           "printing a JSON line with the result of each",
+           batch ) );
+
+  p.add( new string_opt
+         ( '\0', "batch-delimiter",
+           "Separate the compositions in batch mode with lines "
+           "containing just STR; default '---'",
+           "STR", batch_delimiter ) );
+
+  p.add( new boolean_opt
+         ( '\0', "json-lines",
+           "Read one composition per line in batch mode, as a JSON "
+           "string or an object with \"composition\" and \"id\" members",
+           json_lines ) );
+
+  p.add( new integer_opt
+         ( '\0', "threads",
+           "Prove up to NUM compositions concurrently in batch mode", "NUM",
+           threads ) );
+
   p.add( new string_opt
          ( '\0', "lead-symbol",
            "Assign lead place-notation (excluding l.h.) to SYM; default 'm'",
@@ -323,6 +356,34 @@ bool arguments::validate( arg_parser& ap )
       return false;
     }
 
+  if ( batch && ( filter || interactive || !expression.empty() || no_read ) )
+    {
+      ap.error( "Batch mode cannot be used with --filter, -i, -e or -N" );
+      return false;
+    }
+
+  if ( ( json_lines || threads != 1 || batch_delimiter.size() ) && !batch )
+    {
+      ap.error( "The --json-lines, --batch-delimiter and --threads options "
+                "require --batch" );
+      return false;
+    }
+
+  if ( threads < 1 )
+    {
+      ap.error( "The number of threads must be at least one" );
+      return false;
+    }
+
+  if ( batch_delimiter.empty() )
+    batch_delimiter = "---";
+
+#if !RINGING_USE_THREADS
+  if ( threads > 1 )
+    ap.error( "Warning: threads are not supported in this build, "
+              "so compositions will be proved in turn" );
+#endif
+
   if ( filter && bells == 0 )
     {
       ap.error( "When running in filter mode, "
@@ -343,32 +404,63 @@ bool arguments::validate( arg_parser& ap )
   if ( determine_bells )
     quiet = 2;
 
+  // Node counts and symbol tracing are only exact in the tree walker
+  if ( node_limit || print_node_count 
+       || trace_all_symbols || trace_symbols.size() )
+    interpret = true;
+
   return true;
 }
 
-methodset const& arguments::methset() const
+vector<library> const& arguments::libraries() const
 {
-  if ( ( libnames.size() || getenv("METHOD_LIBRARY") ) && !the_methset ) {
+  if ( ( libnames.size() || getenv("METHOD_LIBRARY") ) && !the_libs ) {
     // Register mslib last, as various things can accidentally match it
+    binlib::registerlib();
     cclib::registerlib();
     xmllib::registerlib();
     mslib::registerlib();
 
     library::setpath_from_env();
 
-    the_methset.reset( new methodset );
-
-    if ( libnames.empty() )
-      the_methset->import_libraries_from_env();
+    // Libraries are opened but not read in full: those formats that
+    // have an index can then look methods up directly.
+    vector<string> names( libnames );
+    if ( names.empty() ) {
+      list<string> env( library::split_path( getenv("METHOD_LIBRARY") ) );
+      names.assign( env.begin(), env.end() );
+    }
 
+    the_libs.reset( new vector<library> );
     for ( vector<string>::const_iterator 
-            i = libnames.begin(), e = libnames.end(); i != e; ++i )
-      the_methset->import_library( *i );
+            i = names.begin(), e = names.end(); i != e; ++i ) {
+      library l( *i );
+      if ( !l.good() )
+        throw runtime_error( "Library format unknown: " + *i );
+      the_libs->push_back(l);
+    }
   }
 
-  if ( !the_methset )
+  if ( !the_libs )
     throw runtime_error( "No method library available" );
 
-  return *the_methset;
+  return *the_libs;
 }
 
+library_entry arguments::find_method( string const& title ) const
+{
+#if RINGING_USE_THREADS
+  // In batch mode, several threads may be looking up methods, and 
+  // opening a library registers the library types globally.
+  static mutex m;
+  lock_guard<mutex> lock(m);
+#endif
+
+  vector<library> const& libs = libraries();
+  for ( vector<library>::const_iterator i = libs.begin(), e = libs.end();
+        i != e; ++i ) {
+    library_entry le( i->find(title) );
+    if ( !le.null() ) return le;
+  }
+  return library_entry();
+}
@@ -27,7 +27,7 @@
 #endif
 
 #include <ringing/row.h>
-#include <ringing/methodset.h>
+#include <ringing/library.h>
 #include "init_val.h"
 #include "bell_fmt.h"
 #include <string>
@@ -60,6 +60,11 @@ struct arguments
 
   init_val<bool,false> filter;
 
+  init_val<bool,false> batch;
+  string               batch_delimiter;
+  init_val<bool,false> json_lines;
+  init_val<int,1>      threads;
+
   vector<string>       import_modules;
   vector<string>       definitions;
   vector<string>       string_defs;
@@ -71,6 +76,7 @@ struct arguments
   init_val<bool,false> no_init_file;
   init_val<int,0>      node_limit;
   init_val<bool,false> print_node_count;
+  init_val<bool,false> interpret;
   init_val<bool,false> determine_bells;
 
   string               prove_symbol;
@@ -92,10 +98,13 @@ struct arguments
 
   arguments( int argc, char** argv );
 
-  methodset const&     methset() const;
+  // Look up a method by title in the method libraries
+  library_entry        find_method( string const& title ) const;
 
 private:
-  mutable shared_pointer<methodset> the_methset;
+  vector<library> const& libraries() const;
+
+  mutable shared_pointer< vector<library> > the_libs;
 
   void set_msiril_compatible();
   void set_sirilic_compatible();
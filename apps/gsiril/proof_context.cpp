@@ -46,23 +46,37 @@
 
 RINGING_USING_NAMESPACE
 
+static const size_t npos = size_t(-1);
+
+#if RINGING_USE_TERMCAP
+static bool init_terminfo()
+{
+  char const *term = getenv("TERM");
+  if ( term && strlen(term) )
+    setupterm(NULL, 1, NULL); 
+  return true;
+}
+#endif
+
 proof_context::proof_context( const execution_context &ectx ) 
   : ectx(ectx), row_mask(ectx.bells(), ectx.row_mask()),
     max_length( ectx.expected_length().second ),
-    p( new prover(ectx.get_args().num_extents) ), proving(true), 
-    parent( NULL ), mus(ectx.get_music()), output( &ectx.output() ),
+    // Only batch results report the false rows
+    fi( ectx.get_args().batch ? new prover::failinfo : NULL ),
+    p( fi ? new prover(*fi, ectx.get_args().num_extents)
+          : new prover(ectx.get_args().num_extents) ), proving(true), 
+    parent( NULL ), mus(ectx.get_music()), generation(0),
+    replay( npos ), replay_end( 0 ), start_generation( 0 ),
+    output( &ectx.output() ),
     silent( ectx.get_args().everyrow_only || ectx.get_args().filter
             || ectx.get_args().quiet >= 2 ), 
     underline( false )
 {
 # if RINGING_USE_TERMCAP
-  static bool terminfo_initialized = false;
-  if ( !terminfo_initialized ) {
-    char const *term = getenv("TERM");
-    if ( term && strlen(term) )
-      setupterm(NULL, 1, NULL); 
-    terminfo_initialized = true;
-  }
+  // Initialising a local static is thread-safe, which matters in
+  // batch mode
+  static bool terminfo_initialized = init_terminfo();
+  (void) terminfo_initialized;
 # endif
 
   if ( ectx.bells() == -1 )
@@ -106,13 +120,20 @@ void proof_context::output_string( const string& str, bool to_parent ) const
   else do_output(str);
 }
 
+// The hooks run after each row are looked up by handle
+static const symbol_id start_sym = intern_symbol("start"),
+  everyrow_sym = intern_symbol("everyrow"),
+  rounds_sym = intern_symbol("rounds"), 
+  conflict_sym = intern_symbol("conflict"),
+  toolong_sym = intern_symbol("toolong");
+
 void proof_context::execute_everyrow()
 {
   // Temporarily disable silent flag if running with -E
   bool s = silent;
   if ( ectx.get_args().everyrow_only && !ectx.get_args().filter ) 
     silent = false;
-  execute_symbol("everyrow");
+  execute_symbol(everyrow_sym);
   silent = s;
 }
 
@@ -131,14 +152,19 @@ bool proof_context::permute_and_prove_t::operator()( const row &c )
 bool proof_context::permute_and_prove_t::prove() 
 {
   if ( !pctx.is_proving() ) return true;
+  if ( pctx.replay_row(backstroke) ) {
+    backstroke = !backstroke;
+    return true;
+  }
   bool rv = p.add_row(r); 
   mus.process_row(r, backstroke);
+  pctx.record_row(backstroke, rv);
   backstroke = !backstroke;
   pctx.execute_everyrow();
   if ( pctx.max_length && p.size() > pctx.max_length ) 
-    pctx.execute_symbol("toolong");
-  if ( pctx.isrounds() ) pctx.execute_symbol("rounds");
-  if ( !rv ) pctx.execute_symbol("conflict");
+    pctx.execute_symbol(toolong_sym);
+  if ( pctx.isrounds() ) pctx.execute_symbol(rounds_sym);
+  if ( !rv ) pctx.execute_symbol(conflict_sym);
   return rv;
 }
 
@@ -154,14 +180,177 @@ proof_context::permute_and_prove()
   return permute_and_prove_t( r, *p, mus, *this );
 }
 
+bool proof_context::needs_everyrow() const
+{
+  return !defined(everyrow_sym) || !lookup_symbol(everyrow_sym).isnop();
+}
+
+// The everyrow symbol can only be redefined by executing a symbol,
+// so check it again after each one.
+inline void proof_context::prove_row( bool backstroke, bool& everyrow )
+{
+  if ( replay_row(backstroke) ) return;
+
+  bool rv = p->add_row(r);
+  mus.process_row(r, backstroke);
+  record_row(backstroke, rv);
+  if ( everyrow ) execute_everyrow();
+
+  bool hook = false;
+  if ( max_length && p->size() > max_length ) 
+    execute_symbol(toolong_sym), hook = true;
+  if ( isrounds() ) execute_symbol(rounds_sym), hook = true;
+  if ( !rv ) execute_symbol(conflict_sym), hook = true;
+
+  if ( hook && !everyrow ) everyrow = needs_everyrow();
+}
+
+void proof_context::reuse_history( shared_pointer<proof_history> const& h )
+{
+  // Skipping rows would skip these symbols too
+  if ( !defined(start_sym) || !lookup_symbol(start_sym).isnop()
+       || needs_everyrow() )
+    return;
+
+  start_generation = generation;
+  if ( h && h->environment == ectx.environment_generation() ) {
+    hist = h;
+    fi = hist->fi;
+    p = hist->p;
+    replay = 0;
+    replay_end = min( hist->reusable, hist->rows.size() );
+  }
+  else {
+    hist.reset( new proof_history );
+    hist->reusable = npos;
+  }
+}
+
+shared_pointer<proof_history> proof_context::history() const
+{
+  catch_up();
+  if ( hist ) {
+    hist->environment = ectx.environment_generation();
+    hist->fi = fi;
+    hist->p = p;
+    hist->mus = mus;
+  }
+  return hist;
+}
+
+// Rows can only be replayed while everyrow is empty.  It can only be
+// redefined by defining a symbol, so check it again after each one.
+inline bool proof_context::everyrow_empty()
+{
+  if ( generation == start_generation ) return true;
+  if ( needs_everyrow() ) return false;
+  start_generation = generation;
+  return true;
+}
+
+// Returns true if the current row is the next row of the proof being
+// replayed.  Replaying stops at the first row that is different.
+inline bool proof_context::replay_row( bool backstroke )
+{
+  if ( replay == npos ) return false;
+
+  if ( replay < replay_end && everyrow_empty() ) {
+    proof_history::entry const& e = hist->rows[replay];
+    if ( e.backstroke == backstroke && e.r == r ) {
+      ++replay;
+      return true;
+    }
+  }
+
+  catch_up();
+  return false;
+}
+
+inline void proof_context::record_row( bool backstroke, bool is_true )
+{
+  if ( !hist ) return;
+
+  proof_history::entry e = { r, backstroke };
+  hist->rows.push_back(e);
+
+  // A row that will run a hook must be proved again, as must every row
+  // after it.  This is checked before running them, as they may throw.
+  if ( hist->reusable == npos 
+       && ( !is_true || ( max_length && p->size() > max_length ) 
+            || isrounds() || !everyrow_empty() ) )
+    hist->reusable = hist->rows.size() - 1;
+}
+
+// Removes the rows after those replayed so far from the prover, and
+// recalculates the music for those that remain.
+prover::failinfo const& proof_context::false_rows() const
+{
+  static prover::failinfo const none;
+  catch_up();
+  return fi ? *fi : none;
+}
+
+void proof_context::catch_up() const
+{
+  if ( replay == npos ) return;
+
+  size_t n = replay;
+  replay = npos;
+
+  if ( n < hist->rows.size() ) {
+    p->truncate(n);
+    hist->rows.erase( hist->rows.begin() + n, hist->rows.end() );
+    mus = ectx.get_music();
+    for ( vector<proof_history::entry>::const_iterator 
+            i = hist->rows.begin(), e = hist->rows.end(); i != e; ++i )
+      mus.process_row( i->r, i->backstroke );
+  }
+  else 
+    mus = hist->mus;
+
+  hist->reusable = npos;
+}
+
+void proof_context::prove_changes( change const* first, change const* last )
+{
+  bool everyrow = needs_everyrow();
+  bool backstroke = false;
+
+  for ( ; first != last; ++first ) {
+    r *= *first;
+    if ( !proving ) continue;
+    prove_row( backstroke, everyrow );
+    backstroke = !backstroke;
+  }
+}
+
+proof_context::block_row const* 
+proof_context::prove_block( row const& start, block_row const* first, 
+                            block_row const* last )
+{
+  bool everyrow = needs_everyrow();
+  size_t gen = generation;
+
+  while ( first != last ) {
+    r = start * first->rel;
+    if ( proving ) prove_row( first->backstroke, everyrow );
+    ++first;
+    if ( generation != gen ) break;
+  }
+
+  return first;
+}
+
 void proof_context::disable_proving()
 {
+  catch_up();
   if (proving) last_row = r;
   proving = false;
 }
 
 bool proof_context::isrounds() const 
 {
+  catch_up();
   return r == ectx.rounds() && p->count_row(r) == ectx.extents(); 
 }
 
@@ -170,25 +359,38 @@ int proof_context::bells() const
   return ectx.bells();
 }
 
-void proof_context::execute_symbol( const string& sym, int dir )
+void proof_context::trace_symbol( symbol_id sym ) const
 {
-  if ( output ) {
-    bool trace = ectx.get_args().trace_all_symbols && sym != "everyrow";
-    bool inc_sym = ectx.get_args().trace_all_symbols;
-
-    if ( !trace ) {
-      vector<string> const& syms = ectx.get_args().trace_symbols;
-      vector<string>::const_iterator i = syms.begin(), e = syms.end();
-      trace = find( i, e, sym ) != e;
-      inc_sym = syms.size() > 1;
-    }
+  arguments const& args = ectx.get_args();
+  if ( !args.trace_all_symbols && args.trace_symbols.empty() ) 
+    return;
+
+  string const name( symbol_name(sym) );
+  bool trace = args.trace_all_symbols && name != "everyrow";
+  bool inc_sym = args.trace_all_symbols;
+
+  if ( !trace ) {
+    vector<string> const& syms = args.trace_symbols;
+    vector<string>::const_iterator i = syms.begin(), e = syms.end();
+    trace = find( i, e, name ) != e;
+    inc_sym = syms.size() > 1;
+  }
 
-    if ( trace ) {
-      *output << r;
-      if ( inc_sym ) *output << "\t" << sym;
-      *output << endl;
-    }
+  if ( trace ) {
+    *output << r;
+    if ( inc_sym ) *output << "\t" << name;
+    *output << endl;
   }
+}
+
+void proof_context::execute_symbol( const string& sym, int dir )
+{
+  execute_symbol( intern_symbol(sym), dir );
+}
+
+void proof_context::execute_symbol( symbol_id sym, int dir )
+{
+  if ( output ) trace_symbol(sym);
 
   expression e( lookup_symbol(sym) );
   e.execute( *this, dir );
@@ -202,6 +404,11 @@ void proof_context::execute_final_symbol( const string& sym ) {
 }
 
 expression proof_context::lookup_symbol( const string& sym ) const
+{
+  return lookup_symbol( intern_symbol(sym) );
+}
+
+expression proof_context::lookup_symbol( symbol_id sym ) const
 {
   expression e( dsym_table.lookup(sym) );
   if ( e.isnull() ) e = ectx.lookup_symbol(sym);
@@ -209,29 +416,53 @@ expression proof_context::lookup_symbol( const string& sym ) const
 }
 
 bool proof_context::defined( const string& sym ) const
+{
+  return defined( intern_symbol(sym) );
+}
+
+bool proof_context::defined( symbol_id sym ) const
 {
   return !dsym_table.lookup(sym).isnull() || ectx.defined(sym);
 }
 
 void proof_context::save_symbol( const string& sym )
 {
+  save_symbol( intern_symbol(sym) );
+}
+
+void proof_context::save_symbol( symbol_id sym )
+{
+  ++generation;
   if (!parent)
     const_cast<execution_context&>(ectx)
-      .define_symbol( make_pair(sym, lookup_symbol(sym)) );
+      .define_symbol( sym, lookup_symbol(sym) );
 }
 
 void proof_context::define_symbol( const pair<const string, expression>& defn )
 {
-  dsym_table.define(defn);
+  define_symbol( intern_symbol(defn.first), defn.second );
+}
+
+void proof_context::define_symbol( symbol_id sym, expression const& val )
+{
+  ++generation;
+  dsym_table.define(sym, val);
 }
 
 void proof_context::undefine_symbol( const string& name )
 {
-  dsym_table.undefine(name);
+  undefine_symbol( intern_symbol(name) );
+}
+
+void proof_context::undefine_symbol( symbol_id sym )
+{
+  ++generation;
+  dsym_table.undefine(sym);
 }
 
 proof_context::proof_state proof_context::state() const
 {
+  catch_up();
   if ( p->truth() ) {
     row lr( proving ? r : last_row );
     return lr == ectx.rounds() ? rounds : notround;
@@ -344,10 +575,10 @@ string proof_context::substitute_string( const string &str,
           if (do_exit) *do_exit = true;
         }
 	else
-	  os << p->duplicates();
+	  os << ( catch_up(), p->duplicates() );
 	break;
       case '#':
-	os << p->size();
+	os << ( catch_up(), p->size() );
 	break;
       case '\\':
 	if (i+1 == e) {
@@ -387,7 +618,9 @@ void proof_context::output_newline( bool to_parent ) const
 
 proof_context proof_context::silent_clone() const
 {
+  catch_up();
   proof_context copy( *this );
+  copy.hist.reset();
   copy.p = prover::create_branch(copy.p);
   copy.p->disable_proving();
   copy.max_length = 0;
@@ -439,7 +672,7 @@ method proof_context::load_method( const string& name )
     string title(name);
     if (i->length())
       (title += ' ') += *i;
-    le = ectx.get_args().methset().find(title);
+    le = ectx.get_args().find_method(title);
     if (!le.null()) break;
   }
   if (le.null())
@@ -449,26 +682,26 @@ method proof_context::load_method( const string& name )
 
 proof_context::scoped_variable::scoped_variable( proof_context& ctx, 
                                                  string const& name )
-  : ctx(ctx), name(name)
+  : ctx(ctx), sym( intern_symbol(name) )
 {
-  if (ctx.defined(name)) 
-    old = ctx.lookup_symbol(name);
+  if (ctx.defined(sym)) 
+    old = ctx.lookup_symbol(sym);
 }
 
 proof_context::scoped_variable::~scoped_variable()
 {
   if (old.isnull())
-    ctx.undefine_symbol(name);
+    ctx.undefine_symbol(sym);
   else
-    ctx.define_symbol( make_pair(name, old) );
+    ctx.define_symbol(sym, old);
 }
 
 void proof_context::scoped_variable::set( expression const& val )
 {
-  return ctx.define_symbol( make_pair(name, val) );
+  return ctx.define_symbol(sym, val);
 }
 
 expression proof_context::scoped_variable::get() const
 {
-  return ctx.lookup_symbol(name);
+  return ctx.lookup_symbol(sym);
 }
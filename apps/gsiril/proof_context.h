@@ -25,9 +25,15 @@
 #pragma interface
 #endif
 
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#else
+#include <vector>
+#endif
 #include <iosfwd>
 #include <string>
 #include <ringing/row.h>
+#include <ringing/pointers.h>
 #include <ringing/proof.h>
 #include <ringing/music.h>
 #include "symbol_table.h"
@@ -41,6 +47,23 @@ RINGING_USING_NAMESPACE
 
 class execution_context;
 
+// The rows of a proof, kept in interactive mode so that the next proof
+// need only prove the rows after the point where it differs.
+struct proof_history
+{
+  struct entry {
+    row r;
+    bool backstroke;
+  };
+
+  vector<entry> rows;
+  size_t reusable;    // how many of the rows can be replayed
+  size_t environment; // execution_context::environment_generation
+  shared_pointer<prover::failinfo> fi;
+  shared_pointer<prover> p;
+  music mus;
+};
+
 class proof_context
 {
 public:
@@ -70,23 +93,50 @@ public:
  ~proof_context();
   
   permute_and_prove_t permute_and_prove();
+
+  // Equivalent to for_each( first, last, permute_and_prove() ), but
+  // avoids looking up everyrow for each row when it is a nop.
+  void prove_changes( change const* first, change const* last );
+
+  // A row of a precomputed block, relative to the row the block 
+  // starts from, and the stroke it is treated as for music.
+  struct block_row {
+    row rel;
+    bool backstroke;
+  };
+
+  // Prove the rows start * rel of a block.  The hooks are executed
+  // exactly as by prove_changes.  Stops early if a hook defines a 
+  // symbol, and returns an iterator to the first row not proved.
+  block_row const* prove_block( row const& start, block_row const* first, 
+                                block_row const* last );
+
   void disable_proving();
   bool is_proving() { return proving; }
 
   row current_row() const { return r; }
   bool isrounds() const;
-  size_t length() const { return p->size(); }
+  size_t length() const { catch_up(); return p->size(); }
   int bells() const;
 
   bool set_silent( bool s ) { bool rv = silent; silent = s; return rv; }
 
   void execute_symbol( const string& sym, int dir = +1 );
+  void execute_symbol( symbol_id sym, int dir = +1 );
   void execute_final_symbol( const string& sym );
   void define_symbol( const pair< const string, expression > &defn );
+  void define_symbol( symbol_id sym, expression const& val );
   void undefine_symbol( const string& name );
+  void undefine_symbol( symbol_id sym );
   expression lookup_symbol( const string& sym ) const;
+  expression lookup_symbol( symbol_id sym ) const;
   bool defined( const string& sym ) const;
+  bool defined( symbol_id sym ) const;
   void save_symbol( const string& sym );
+  void save_symbol( symbol_id sym );
+
+  // Incremented whenever a symbol is defined or undefined
+  size_t definitions_generation() const { return generation; }
 
   enum proof_state { rounds, notround, isfalse };
   proof_state state() const;
@@ -105,7 +155,19 @@ public:
 
   void increment_node_count() const;
 
-  int music_score() const { return mus.get_score(); }
+  int music_score() const { catch_up(); return mus.get_score(); }
+
+  // The rows which have occurred too many times, and where.  Only
+  // recorded in batch mode.
+  prover::failinfo const& false_rows() const;
+
+  // Rows which are the same as those at the start of the proof in H 
+  // are not proved again, but taken from H.  Has no effect unless the 
+  // start and everyrow symbols are empty.
+  void reuse_history( shared_pointer<proof_history> const& h );
+
+  // The history of this proof, if it was started by reuse_history
+  shared_pointer<proof_history> history() const;
 
   class scoped_variable {
   public:
@@ -117,11 +179,18 @@ public:
 
   private:
     proof_context& ctx;
-    string const name;
+    symbol_id const sym;
     expression old;
   };
 
 private:
+  void trace_symbol( symbol_id sym ) const;
+  bool needs_everyrow() const;
+  void prove_row( bool backstroke, bool& everyrow );
+  bool everyrow_empty();
+  bool replay_row( bool backstroke );
+  void record_row( bool backstroke, bool is_true );
+  void catch_up() const;
   void termination_sequence( ostream& os ) const;
   void do_output( string const& str ) const;
 
@@ -130,10 +199,17 @@ private:
   mutable music row_mask;
   row r, last_row;
   size_t max_length;
+  shared_pointer<prover::failinfo> fi;
   shared_pointer<prover> p;
   bool proving;
   proof_context const* parent;
-  music mus;
+  mutable music mus;
+  size_t generation;
+
+  shared_pointer<proof_history> hist;
+  mutable size_t replay;  // rows of hist replayed so far, or -1
+  size_t replay_end;      // hist->reusable when replaying started
+  size_t start_generation; // generation when everyrow was last empty
 
   ostream* output;
   bool silent;
@@ -27,6 +27,7 @@
 #include "expression.h"
 #include "execution_context.h"
 #include "proof_context.h"
+#include "bytecode.h"
 #include <fstream>
 #include <ringing/streamutils.h>
 
@@ -83,6 +84,20 @@ void null_stmt::execute( execution_context& e )
     e.output() << diagnostic;
 }
 
+static void record_result( execution_context& e, proof_context const& p,
+                           char const* status )
+{
+  if ( !e.get_args().batch ) return;
+
+  execution_context::proof_result r;
+  r.status = status;
+  r.length = p.length();
+  r.music_score = p.music_score();
+  r.end = p.current_row();
+  r.false_rows = p.false_rows();
+  e.add_result(r);
+}
+
 void prove_stmt::execute( execution_context& e )
 {
   if (e.get_args().prove_one && e.done_one_proof())
@@ -98,10 +113,14 @@ void prove_stmt::execute( execution_context& e )
   }
 
   proof_context p(e);
+  if ( e.interactive() ) p.reuse_history( e.take_history() );
 
   try {
     p.execute_symbol( "start" );
-    expr.execute(p, +1);
+    if ( e.get_args().interpret )
+      expr.execute(p, +1);
+    else
+      bytecode(p, expr).execute();
     p.execute_symbol( "finish" );
   } 
   catch( const script_exception& ex ) {
@@ -109,30 +128,37 @@ void prove_stmt::execute( execution_context& e )
       p.execute_final_symbol( "abort" );
       e.set_failure();
     }
+    record_result( e, p, p.state() == proof_context::isfalse ? "false"
+                   : ex.t == script_exception::do_abort ? "aborted" 
+                   : "terminated" );
+    if ( e.interactive() ) e.save_history( p.history() );
     if ( e.verbose() )
       e.output() << "Proof terminated" << endl;
     return;
   }
 
   bool failed = true;   
+  char const* status = NULL;
   switch ( p.state() ) {
   case proof_context::rounds: 
     if ( e.expected_length().first && 
          p.length() < e.expected_length().first )
-      p.execute_final_symbol("tooshort");
+      p.execute_final_symbol( status = "tooshort" );
     else {
       if ( e.get_args().quiet ) p.set_silent(true);
-      p.execute_final_symbol("true"); 
+      p.execute_final_symbol( status = "true" ); 
       failed = false;
     }
     break;
   case proof_context::notround:
-    p.execute_final_symbol("notround");
+    p.execute_final_symbol( status = "notround" );
     break;
   case proof_context::isfalse:
-    p.execute_final_symbol("false"); 
+    p.execute_final_symbol( status = "false" ); 
     break;
   }
+  record_result( e, p, status );
+  if ( e.interactive() ) e.save_history( p.history() );
 
   if (failed) {
     e.set_failure();
@@ -234,15 +260,11 @@ void import_stmt::execute( execution_context& e )
   { // Use RAII to revert the number of bells, etc. in case we throw.
     restore_values restore(e);
   
-    shared_pointer<istream> in(( load_file(name) )); 
-    if ( !in )
-      throw runtime_error
-        ( make_string() << "Unable to load resource: " << name );
-        
-    shared_pointer<parser> p( make_default_parser(*in, e ) );
     e.interactive(false);
     e.verbose(false);
-    p->run(e, name, parser::propagate);
+    if ( !import_file( e, name, parser::propagate ) )
+      throw runtime_error
+        ( make_string() << "Unable to load resource: " << name );
   }
 
   if ( e.verbose() )
@@ -265,6 +287,10 @@ void echo_stmt::execute( execution_context& e )
   bool no_nl = false;
   string str( expr.string_evaluate(p, &no_nl) );
 
+  // In batch mode, an error abandons this composition but not the batch
+  if ( mode == error && e.get_args().batch )
+    throw runtime_error(str);
+
   ostream& os = mode == echo ? e.output() : cerr;
   os << str;
   if (!no_nl) os << '\n';
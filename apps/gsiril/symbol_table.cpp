@@ -26,37 +26,102 @@
 #include "symbol_table.h"
 #include "expr_base.h" // Must be before execution_context.h because 
                        // of bug in MSVC 6.0
+#if RINGING_OLD_INCLUDES
+#include <map.h>
+#else
+#include <map>
+#endif
+#if RINGING_USE_THREADS
+#include <mutex>
+#endif
 
 RINGING_USING_NAMESPACE
 
+RINGING_START_ANON_NAMESPACE
+
+// A function-local static avoids depending on the order in which
+// static objects are initialised.
+struct intern_table {
+  map<string, symbol_id> ids;
+  vector<string> names;
+#if RINGING_USE_THREADS
+  std::mutex m;
+#endif
+
+  static intern_table& instance() {
+    static intern_table t;
+    return t;
+  }
+};
+
+RINGING_END_ANON_NAMESPACE
+
+symbol_id intern_symbol( const string& name )
+{
+  intern_table& t = intern_table::instance();
+#if RINGING_USE_THREADS
+  std::lock_guard<std::mutex> lock(t.m);
+#endif
+  map<string, symbol_id>::const_iterator i = t.ids.find(name);
+  if ( i != t.ids.end() )
+    return i->second;
+
+  symbol_id sym = t.names.size();
+  t.names.push_back(name);
+  t.ids[name] = sym;
+  return sym;
+}
+
+bool find_symbol( const string& name, symbol_id& sym )
+{
+  intern_table& t = intern_table::instance();
+#if RINGING_USE_THREADS
+  std::lock_guard<std::mutex> lock(t.m);
+#endif
+  map<string, symbol_id>::const_iterator i = t.ids.find(name);
+  if ( i == t.ids.end() )
+    return false;
+
+  sym = i->second;
+  return true;
+}
 
-expression symbol_table::lookup( const string& sym ) const
+string symbol_name( symbol_id sym )
 {
-  sym_table_t::const_iterator i = sym_table.find(sym);
-  if ( i == sym_table.end() )
-    return expression( NULL );
-  return i->second;
+  intern_table& t = intern_table::instance();
+#if RINGING_USE_THREADS
+  std::lock_guard<std::mutex> lock(t.m);
+#endif
+  return t.names[sym];
 }
 
-bool symbol_table::define( const pair<const string, expression>& defn )
+expression symbol_table::lookup( const string& name ) const
 {
-  sym_table_t::iterator i = sym_table.find( defn.first );
+  // A name that was never interned cannot have been defined
+  symbol_id sym;
+  return find_symbol( name, sym ) ? lookup(sym) : expression(NULL);
+}
+
+bool symbol_table::define( symbol_id sym, const expression& val )
+{
+  if ( sym >= table.size() )
+    table.resize( sym + 1, expression(NULL) );
 
   // Is it a redefinition?
-  if ( i != sym_table.end() )
-    {
-      i->second = defn.second;
-      return true;
-    }
-  else
-    {
-      sym_table.insert( defn );
-      return false;
-    }
+  bool redefinition = !table[sym].isnull();
+  table[sym] = val;
+  return redefinition;
 }
 
-void symbol_table::undefine( const string& sym )
+void symbol_table::undefine( symbol_id sym )
 {
-  sym_table.erase(sym);
+  if ( sym < table.size() )
+    table[sym] = expression(NULL);
 }
 
+void symbol_table::undefine( const string& name )
+{
+  symbol_id sym;
+  if ( find_symbol( name, sym ) )
+    undefine(sym);
+}
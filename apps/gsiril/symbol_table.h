@@ -27,9 +27,9 @@
 #endif
 
 #if RINGING_OLD_INCLUDES
-#include <map.h>
+#include <vector.h>
 #else
-#include <map>
+#include <vector>
 #endif
 #include <string>
 #include "expr_base.h" // MSVC 6 requires expression to be complete.
@@ -39,19 +39,34 @@ RINGING_USING_NAMESPACE
 
 class expression;
 
+// Identifiers are interned when they are parsed: each distinct name is
+// given a small integer handle, and symbol tables are indexed by it.
+// Interning is thread-safe.
+typedef size_t symbol_id;
+
+symbol_id intern_symbol( const string& name );
+// Returns false, without interning it, if name has never been interned
+bool find_symbol( const string& name, symbol_id& sym );
+string symbol_name( symbol_id sym );
+
 class symbol_table
 {
 public:
+  // Returns a null expression if the symbol is not defined
+  expression lookup( symbol_id sym ) const
+    { return sym < table.size() ? table[sym] : expression(NULL); }
   expression lookup( const string& sym ) const;
 
   // Returns true for a redefinition and false otherwise
-  bool define( const pair< const string, expression >& defn );
+  bool define( symbol_id sym, const expression& val );
+  bool define( const pair< const string, expression >& defn )
+    { return define( intern_symbol(defn.first), defn.second ); }
 
+  void undefine( symbol_id sym );
   void undefine( const string& sym );
 
 private:
-  typedef map< string, expression > sym_table_t;
-  sym_table_t sym_table;
+  vector<expression> table;
 };
 
 #endif // GSIRIL_SYMBOL_TABLE_INCLUDED
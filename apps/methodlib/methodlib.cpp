@@ -17,6 +17,7 @@
 
 #include <ringing/common.h>
 #include <ringing/library.h>
+#include <ringing/binlib.h>
 #include <ringing/cclib.h>
 #include <ringing/mslib.h>
 #include <ringing/xmllib.h>
@@ -182,7 +183,7 @@ arguments::arguments( int argc, char const *argv[] )
     exit(1);
 }
 
-void read_library( const string &filename, libout& out ) {
+library open_library( const string &filename ) {
   try {
    library l( filename );
 
@@ -196,6 +197,18 @@ void read_library( const string &filename, libout& out ) {
       exit(1);
     }
 
+    return l;
+  }
+  catch ( const exception &e ) {
+    cerr << "Unable to read library: " << filename << ": " 
+         << e.what() << '\n';
+    exit(1);
+  }
+}
+
+void read_library( const string &filename, libout& out ) {
+  library l( open_library( filename ) );
+  try {
     copy( l.begin(), l.end(), back_inserter(out) );
   }
   catch ( const exception &e ) {
@@ -205,6 +218,17 @@ void read_library( const string &filename, libout& out ) {
   }
 }
 
+// Look the title up in each library in turn, so that libraries
+// which have an index need not be read in full.
+library_entry find_title( vector<library> const& libs, string const& title ) {
+  for ( vector<library>::const_iterator i=libs.begin(), e=libs.end(); 
+        i != e; ++i ) {
+    library_entry le( i->find(title) );
+    if (!le.null()) return le;
+  }
+  return library_entry();
+}
+
 bool read_one_title( arguments& args ) {
   args.titles.clear();
   args.payloads.clear();
@@ -247,15 +271,20 @@ bool apply_filters( arguments& args, library_entry const& le, libout& out ) {
   else return false;
 }
 
-bool filter_by_titles( library const& meths, arguments& args, libout& out ) {
+bool filter_by_titles( vector<library> const& libs, arguments& args, 
+                       libout& out ) {
   bool okay = true;
   for ( size_t i=0, n=args.titles.size(); i != n; ++i ) {
+    // A methodset of just this entry, so that it is formatted as before
+    // and can have its payload set.  Sharing one between titles would 
+    // merge titles with the same place notation.
+    methodset found;
     library_entry le;
     for ( string suffix : args.suffixes ) {
       string title( args.titles[i] );
       if (suffix.length())
         (title += ' ') += suffix;
-      le = meths.find(title);
+      le = find_title(libs, title);
       if (!le.null()) break;
     }
 
@@ -264,6 +293,9 @@ bool filter_by_titles( library const& meths, arguments& args, libout& out ) {
       okay = false;
     }
     else {
+      found.append(le);
+      le = found.find( le.meth() );
+
       if (args.copy_payload)
         le.set_facet<litelib::payload>( args.payloads[i] );
       else if (args.suffixstr.size())
@@ -287,6 +319,7 @@ bool filter_by_start( library const& meths, arguments& args, libout& out ) {
 
 int main(int argc, char const** argv) {
   // Register mslib last, as various things can accidentally match it
+  binlib::registerlib();
   cclib::registerlib();
   xmllib::registerlib();
   mslib::registerlib();
@@ -295,10 +328,14 @@ int main(int argc, char const** argv) {
 
   arguments args( argc, argv );
 
+  vector<library> libs;
   methodset meths;
   for ( vector< string >::const_iterator 
           i( args.libs.begin() ), e( args.libs.end() ); i != e; ++i )
-    read_library( *i, meths );
+    if ( args.read_titles || args.titles.size() )
+      libs.push_back( open_library( *i ) );
+    else
+      read_library( *i, meths );
  
   method_stream::name_form form 
     = args.pn_only    ? method_stream::none
@@ -310,11 +347,11 @@ int main(int argc, char const** argv) {
   if (args.read_titles) {
     okay = true;
     while ( read_one_title(args) )
-      if (!filter_by_titles(meths, args, out))
+      if (!filter_by_titles(libs, args, out))
         okay = false;
   }
   else if (args.titles.size())
-    okay = filter_by_titles(meths, args, out);
+    okay = filter_by_titles(libs, args, out);
   else
     okay = filter_by_start(meths, args, out);
   return okay ? 0 : 1;
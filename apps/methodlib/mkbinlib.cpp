@@ -0,0 +1,166 @@
+// -*- C++ -*- mkbinlib.cpp - convert method libraries to the binary format
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+#include <ringing/library.h>
+#include <ringing/binlib.h>
+#include <ringing/cclib.h>
+#include <ringing/mslib.h>
+#include <ringing/xmllib.h>
+#include <ringing/litelib.h>
+#include <ringing/streamutils.h>
+
+#include <iostream>
+
+#include "init_val.h"
+#include "args.h"
+
+
+RINGING_USING_NAMESPACE
+RINGING_USING_STD
+
+struct arguments
+{
+  arguments( int argc, char const *argv[] );
+
+  init_val<int,0>       bells;
+  string                output;
+  vector<string>        libs;
+
+private:
+  void bind( arg_parser& p );
+  bool validate( arg_parser& p );
+};
+
+void arguments::bind( arg_parser& p )
+{
+  p.add( new help_opt );
+  p.add( new version_opt );
+
+  p.add( new string_opt
+           ( 'o', "output",  "Write the binary library to FILE", "FILE",
+             output ) );
+
+  p.add( new integer_opt
+           ( 'b', "bells",  "The number of bells for reading litelib input "
+             "from standard input", "BELLS", bells ) );
+
+  p.set_default( new strings_opt( '\0', "", "", "", libs ) );
+}
+
+bool arguments::validate( arg_parser& ap )
+{
+  if ( output.empty() ) {
+    ap.error( "Please specify an output file" );
+    return false;
+  }
+
+  if ( libs.empty() && !bells ) {
+    ap.error( "Please provide at least one library, or the number of bells "
+              "to read from standard input" );
+    return false;
+  }
+
+  if ( bells && ( bells < 2 || bells > int(bell::MAX_BELLS) ) ) {
+    ap.error( make_string() << "The number of bells must be between 2 and "
+                << bell::MAX_BELLS << " (inclusive)" );
+    return false;
+  }
+
+  return true;
+}
+
+arguments::arguments( int argc, char const *argv[] )
+{
+  arg_parser ap( argv[0], "mkbinlib -- convert method libraries to the "
+                 "binary library format", "[OPTIONS] -o OUTPUT [LIBRARY...]" );
+  bind( ap );
+
+  if ( !ap.parse(argc, argv) ) {
+    ap.usage();
+    exit(1);
+  }
+
+  if ( !validate(ap) )
+    exit(1);
+}
+
+size_t copy_library( library const& l, string const& filename, libout& out )
+{
+  size_t n = 0;
+  try {
+    for ( library::const_iterator i(l.begin()), e(l.end()); i != e; ++i ) {
+      library_entry const le(*i);
+      try {
+        out.append(le);
+      }
+      catch ( const exception &e ) {
+        cerr << "Unable to write method " << n+1 << " of " << filename 
+             << ": " << e.what() << '\n';
+        exit(1);
+      }
+      ++n;
+    }
+  }
+  catch ( const exception &e ) {
+    cerr << "Unable to read library: " << filename << ": "
+         << e.what() << '\n';
+    exit(1);
+  }
+  return n;
+}
+
+int main( int argc, char const** argv ) {
+  // Register mslib last, as various things can accidentally match it
+  binlib::registerlib();
+  cclib::registerlib();
+  xmllib::registerlib();
+  mslib::registerlib();
+
+  library::setpath_from_env();
+
+  arguments args( argc, argv );
+
+  binout out( args.output );
+  size_t n = 0;
+
+  if ( args.libs.empty() )
+    n += copy_library( litelib( args.bells, cin ), "<stdin>", out );
+
+  for ( vector< string >::const_iterator
+          i( args.libs.begin() ), e( args.libs.end() ); i != e; ++i ) {
+    library l( *i );
+    if ( !l.good() ) {
+      cerr << "Unable to read library " << *i << "\n";
+      exit(1);
+    }
+    n += copy_library( l, *i, out );
+  }
+
+  try {
+    out.flush();
+  }
+  catch ( const exception &e ) {
+    cerr << e.what() << '\n';
+    exit(1);
+  }
+
+  if ( n == 0 )
+    cerr << "Warning: no methods were written\n";
+
+  return 0;
+}
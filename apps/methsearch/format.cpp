@@ -679,16 +679,20 @@ void clear_status()
   cerr << '\r' << string( display_columns() - 1, ' ' ) << '\r';
 }
 
-void output_status( const method &m )
+void output_status( const method &m, const string& note )
 {
   string s = m.format(method::M_DASH);
 
   int width = display_columns() - 12;
+  if ( note.size() ) width -= note.size() + 3;
+  if ( width < 0 ) width = 0;
   if ( s.size() > width ) 
     s = s.substr(0, width) + "...";
   
   clear_status();
-  cerr << "Trying " << s << flush;
+  cerr << "Trying " << s;
+  if ( note.size() ) cerr << " [" << note << "]";
+  cerr << flush;
 }
 
 void output_raw_count( ostream& out, RINGING_ULLONG c )
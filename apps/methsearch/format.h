@@ -126,7 +126,7 @@ private:
 size_t parse_requirement( const string& str );
 
 void clear_status();
-void output_status( const method &m );
+void output_status( const method &m, const string& note = string() );
 
 void output_count( ostream& out, RINGING_ULLONG count );
 void output_raw_count( ostream& out, RINGING_ULLONG count );
@@ -37,6 +37,11 @@
 #else
 #include <iostream>
 #endif
+#if RINGING_OLD_INCLUDES
+#include <algorithm.h>
+#else
+#include <algorithm>
+#endif
 #if RINGING_OLD_C_INCLUDES
 #include <cstdlib.h>
 #else
@@ -45,6 +50,7 @@
 #include <ringing/method.h>
 #include <ringing/library.h>
 #include <ringing/litelib.h>
+#include <ringing/binlib.h>
 #include <ringing/cclib.h>
 #include <ringing/mslib.h>
 #include <ringing/xmllib.h>
@@ -61,7 +67,7 @@ method_libraries &method_libraries::instance()
 }
 
 method_libraries::method_libraries()
-  : done_init(false)
+  : done_init(false), lazy(false)
 {
 }
 
@@ -99,25 +105,118 @@ void method_libraries::read_libraries()
   }
 }
 
-void method_libraries::init()
+void method_libraries::open_library( const string& name )
+{
+  library l( name );
+  if ( !l.good() )
+    throw runtime_error( "Library format unknown: " + name );
+  libs.push_back( lazy_library(l) );
+}
+
+void method_libraries::open_libraries()
 {
+  clear();
+  libs.clear();
+
+  if ( formats_have_cc_ids() )
+    store_facet< cc_collection_id >();
+
+  try {
+    if ( library_names.empty() ) 
+      if ( char const* const lib_env = getenv("METHOD_LIBRARY") ) {
+        // Split as import_libraries_from_env does in eager mode
+        list<string> names( library::split_path(lib_env) );
+        for ( list<string>::const_iterator i=names.begin(), e=names.end(); 
+              i != e; ++i )
+          open_library( *i );
+      }
+
+    for ( vector< string >::const_iterator 
+            i( library_names.begin() ), e( library_names.end() );
+          i != e; ++i )
+      open_library( *i );
+  }
+  catch ( const exception &e ) {
+    cerr << "Error reading method libraries: " << e.what() << '\n';
+    exit(1);
+  }
+}
+
+library_entry method_libraries::find_lazily( const method &m )
+{
+  // Anything previously found will be in the methodset
+  library_entry found( find(m) );
+  if ( !found.null() ) return found;
+
+  size_t const h = m.hash();
+
+  try {
+    for ( vector<lazy_library>::iterator i=libs.begin(), e=libs.end(); 
+          i != e; ++i ) {
+      if ( !i->lib.indexed() ) {
+        if ( !i->have_hashes ) {
+          for ( library::const_iterator j=i->lib.begin(), je=i->lib.end(); 
+                j != je; ++j )
+            i->hashes.push_back( j->meth().hash() );
+          sort( i->hashes.begin(), i->hashes.end() );
+          i->have_hashes = true;
+        }
+        
+        // Only do the linear search if the method might be present
+        if ( !binary_search( i->hashes.begin(), i->hashes.end(), h ) )
+          continue;
+      }
+
+      library_entry le( i->lib.find(m) );
+      if ( !le.null() ) {
+        // Copy it, with any facets we need
+        append(le);
+        return find(m);
+      }
+    }
+  }
+  catch ( const exception &e ) {
+    cerr << "Error reading method libraries: " << e.what() << '\n';
+    exit(1);
+  }
+
+  return library_entry();
+}
+
+void method_libraries::init( bool lazy )
+{
+  if ( instance().done_init && instance().lazy != lazy )
+    instance().done_init = false;
+
   if ( !instance().done_init && has_libraries() )
     {
       // Register mslib last, as various things can accidentally match it
+      binlib::registerlib();
       cclib::registerlib();
       xmllib::registerlib();
       mslib::registerlib();
 
       library::setpath_from_env();
       
-      instance().read_libraries();
+      instance().lazy = lazy;
+      if ( lazy )
+        instance().open_libraries();
+      else
+        instance().read_libraries();
 
       instance().done_init = true;
     }
 }
 
+library_entry method_libraries::find_method( const method &m ) {
+  if ( instance().lazy )
+    return instance().find_lazily( m );
+  else
+    return instance().find( m );
+}
+
 method method_libraries::lookup_method( const method &m ) {
-  library_entry i( instance().find( m ) );
+  library_entry i( find_method( m ) );
   if ( ! i.null() )
     return i.meth();
   else 
@@ -125,7 +224,7 @@ method method_libraries::lookup_method( const method &m ) {
 }
 
 bool method_libraries::has_method( const method &m ) {
-  return !instance().find( m ).null();
+  return !find_method( m ).null();
 }
 
 library const& overwork_map( int bells, const string& filename ) {
@@ -38,23 +38,42 @@ RINGING_END_NAMESPACE
 RINGING_USING_NAMESPACE
 RINGING_USING_STD
 
+// In lazy mode, the libraries are opened but not read at start-up.
+// Lookups use the library's own index where it has one (as cclib and 
+// binlib do), and otherwise a list of method hashes built on first 
+// use.  Entries are only copied into the methodset when they are 
+// found, so iterating over instance() is only useful in eager mode.
 class method_libraries : public methodset
 {
 public:
   static void add_new_library( const string &name );
-  static void init();
+  static void init( bool lazy = false );
   static bool has_libraries();
   static method lookup_method( const method &m );
   static bool has_method( const method &m );
+  static library_entry find_method( const method &m );
 
   static method_libraries &instance();
 
 private:
   void read_libraries();
+  void open_libraries();
+  void open_library( const string& name );
+  library_entry find_lazily( const method &m );
   method_libraries();
 
-  bool done_init;
+  struct lazy_library {
+    explicit lazy_library( const library& lib ) 
+      : lib(lib), have_hashes(false) {}
+
+    library lib;
+    bool have_hashes;
+    vector<size_t> hashes;  // Sorted, if lib isn't indexed
+  };
+
+  bool done_init, lazy;
   vector<string> library_names;
+  vector<lazy_library> libs;
 };
 
 // Call without arguments to fetch and with arguments to load
@@ -45,7 +45,8 @@ int main( int argc, char *argv[] )
 
   if ( formats_have_names() || formats_have_cc_ids() || args.filter_lib_mode 
          || args.only_named || args.only_unnamed )
-    method_libraries::init();
+    // Only the filter needs to read every method up front
+    method_libraries::init( !args.filter_lib_mode );
 
   // So that errors with -M options are presented now rather than later.
   musical_analysis::force_init( args.bells );
@@ -296,7 +296,7 @@ string method_properties::impl2::get_property( pair<int,int> const& num_opts,
 	} break;
  
         case 'i': {
-          library_entry const& e = method_libraries::instance().find(m);
+          library_entry const& e = method_libraries::find_method(m);
           if ( !e.null() && e.has_facet<cc_collection_id>() )
             os << setw(num_opts.first) << e.get_facet<cc_collection_id>();
           else 
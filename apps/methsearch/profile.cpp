@@ -0,0 +1,133 @@
+// -*- C++ -*- profile.cpp - where the search spends its time
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation "methsearch/profile"
+#endif
+
+#include "profile.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+RINGING_USING_NAMESPACE
+RINGING_USING_STD
+
+char const* search_profile::name( constraint c )
+{
+  static char const* const names[num_constraints] = {
+    "midlead", "falseness", "quarterlead", "halflead", "halflead-sym",
+    "leadend", "leadend-sym", "offset-start", "rows", "method"
+  };
+  return names[c];
+}
+
+void search_profile::test( size_t depth, constraint c, bool passed,
+                           double secs )
+{
+  size_t const i = depth * num_constraints + c;
+  if ( i >= entries.size() ) entries.resize( i + num_constraints - c );
+
+  entry& e = entries[i];
+  ++e.tested;
+  if ( !passed ) ++e.rejected;
+  e.secs += secs;
+}
+
+search_profile::entry search_profile::total( constraint c ) const
+{
+  entry t;
+  for ( size_t i = c; i < entries.size(); i += num_constraints ) {
+    t.tested += entries[i].tested;
+    t.rejected += entries[i].rejected;
+    t.secs += entries[i].secs;
+  }
+  return t;
+}
+
+namespace {
+
+void output_entry( ostream& os, char const* name, RINGING_ULLONG tested,
+                   RINGING_ULLONG rejected, double secs )
+{
+  os << setw(14) << left << name << right
+     << setw(14) << tested << setw(14) << rejected
+     << setw(8) << fixed << setprecision(1)
+     << ( tested ? 100.0 * rejected / tested : 0.0 ) << '%'
+     << setw(11) << setprecision(3) << secs << "\n";
+}
+
+}
+
+void search_profile::output( ostream& os ) const
+{
+  ios::fmtflags const flags = os.flags();
+  streamsize const prec = os.precision();
+
+  char const* const header 
+    = "Constraint            Tested      Rejected  Reject%   Time (s)\n";
+
+  os << header;
+  for ( int c = 0; c < num_constraints; ++c ) {
+    entry const t = total( constraint(c) );
+    if ( t.tested )
+      output_entry( os, name( constraint(c) ), t.tested, t.rejected, t.secs );
+  }
+
+  os << "\nDepth " << header;
+  for ( size_t i = 0; i < entries.size(); ++i )
+    if ( entries[i].tested ) {
+      os << setw(5) << i / num_constraints << ' ';
+      output_entry( os, name( constraint( i % num_constraints ) ),
+                    entries[i].tested, entries[i].rejected, entries[i].secs );
+    }
+
+  os.flags(flags);
+  os.precision(prec);
+}
+
+string search_profile::summary() const
+{
+  // The three constraints with the most rejections, and their
+  // share of all rejections
+  entry totals[num_constraints];
+  RINGING_ULLONG rejected = 0;
+  for ( int c = 0; c < num_constraints; ++c ) {
+    totals[c] = total( constraint(c) );
+    rejected += totals[c].rejected;
+  }
+
+  ostringstream os;
+  bool used[num_constraints] = {};
+  for ( int n = 0; rejected && n < 3; ++n ) {
+    int best = -1;
+    for ( int c = 0; c < num_constraints; ++c )
+      if ( !used[c] && totals[c].rejected
+           && ( best == -1 || totals[c].rejected > totals[best].rejected ) )
+        best = c;
+    if ( best == -1 ) break;
+    used[best] = true;
+
+    if ( n ) os << ' ';
+    os << name( constraint(best) ) << ' '
+       << int( 100 * totals[best].rejected / rejected ) << '%';
+  }
+  return os.str();
+}
@@ -0,0 +1,69 @@
+// -*- C++ -*- profile.h - where the search spends its time
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef METHSEARCH_PROFILE_INCLUDED
+#define METHSEARCH_PROFILE_INCLUDED
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface "methsearch/profile"
+#endif
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+RINGING_USING_NAMESPACE
+RINGING_USING_STD
+
+// Counts, for each depth in the search and each constraint, how many
+// candidate changes were tested and rejected, and how long it took.
+class search_profile
+{
+public:
+  // The constraints in the order new_midlead_change tries them.
+  // Falseness is tested from within the midlead constraint, so its
+  // time is included in that too.
+  enum constraint {
+    midlead, falseness, quarterlead, halflead, halflead_sym,
+    leadend, leadend_sym, offset_start, rows, method,
+    num_constraints
+  };
+
+  static char const* name( constraint c );
+
+  void test( size_t depth, constraint c, bool passed, double secs );
+
+  // The whole table, and a one-line summary for the status line
+  void output( ostream& os ) const;
+  string summary() const;
+
+private:
+  struct entry {
+    entry() : tested(0), rejected(0), secs(0.0) {}
+    RINGING_ULLONG tested, rejected;
+    double secs;
+  };
+
+  entry total( constraint c ) const;
+
+  // Indexed by depth * num_constraints + constraint
+  vector<entry> entries;
+};
+
+#endif // METHSEARCH_PROFILE_INCLUDED
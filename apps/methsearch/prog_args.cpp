@@ -478,6 +478,11 @@ void arguments::bind( arg_parser &p )
            "Count the number of search nodes visited",
            node_count ) );
 
+  p.add( new boolean_opt
+         ( '\0', "profile",
+           "Count candidate changes tested and rejected by each constraint",
+           profile ) );
+
   p.add( new boolean_opt
          ( 'I', "filter",
            "Act as a filter on standard input rather than searching",
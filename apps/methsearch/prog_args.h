@@ -96,6 +96,7 @@ struct arguments
   init_val<bool,false> count;
   init_val<bool,false> raw_count;
   init_val<bool,false> node_count;
+  init_val<bool,false> profile;
   init_val<bool,false> filter_mode;
   init_val<bool,false> filter_lib_mode;
   init_val<bool,false> invert_filter;
@@ -32,6 +32,7 @@
 #include "output.h"
 #include "libraries.h" // for filter_lib code
 #include "mask.h"
+#include "profile.h"
 
 #include <vector>
 #include <algorithm>
@@ -53,6 +54,7 @@
 #include <ringing/mathutils.h>
 #include <ringing/litelib.h>
 #include <ringing/falseness.h>
+#include <ringing/timing.h>
 
 
 RINGING_USING_NAMESPACE
@@ -101,6 +103,12 @@ private:
   bool is_acceptable_leadhead( const row &lh );
   bool is_falseness_acceptable( const change& ch );
 
+  typedef bool (searcher::*change_test)( const change& );
+  typedef bool (searcher::*method_test)();
+  inline bool profiled( search_profile::constraint c, change_test test,
+                        const change& ch );
+  inline bool profiled( search_profile::constraint c, method_test test );
+
 private:
   arguments &args; 
   int bells;
@@ -125,6 +133,7 @@ private:
   bool maintain_r;   // Whether r is valid
   row r;
   scoped_pointer<prover> prv;
+  scoped_pointer<search_profile> prof;
   time_t start;
 };
 
@@ -138,6 +147,9 @@ searcher::searcher( arguments &args )
   if (args.bells)
     args.orig_lead_len = args.lead_len;
 
+  if (args.profile)
+    prof.reset( new search_profile );
+
   reset();
 
   copy( args.startmeth.rbegin(), args.startmeth.rend(), 
@@ -188,7 +200,7 @@ void searcher::reset()
 
 inline void searcher::do_status( method const& m ) {
   if ( node_count % args.status_freq == 0 ) {
-    if ( args.status ) output_status(m);
+    if ( args.status ) output_status( m, prof ? prof->summary() : string() );
     if ( args.timeout && time(NULL) - start > args.timeout ) 
       throw timeout_exception();
   }
@@ -305,6 +317,14 @@ void run_search( arguments &args )
       else if ( args.count ) output_count( cout, s.search_count );
       if ( args.node_count ) output_node_count( cout, s.node_count );
     }
+
+  if ( s.prof ) 
+    {
+      if ( ( s.search_count && !args.quiet )
+           || args.count || args.raw_count || args.node_count ) 
+        cout << "\n";
+      s.prof->output( cout );
+    }
 }
 
 void searcher::output_method( method const& meth )
@@ -652,6 +672,30 @@ inline void searcher::pop_change( row const* r_old )
   }
 }
 
+// Applies one of the try_* tests to CH, recording the result if profiling
+inline bool searcher::profiled( search_profile::constraint c, 
+                                change_test test, const change& ch )
+{
+  if ( !prof ) return (this->*test)( ch );
+
+  size_t const depth = m.length();
+  double const t = clock_seconds();
+  bool const ok = (this->*test)( ch );
+  prof->test( depth, c, ok, clock_seconds() - t );
+  return ok;
+}
+
+inline bool searcher::profiled( search_profile::constraint c, 
+                                method_test test )
+{
+  if ( !prof ) return (this->*test)();
+
+  double const t = clock_seconds();
+  bool const ok = (this->*test)();
+  prof->test( m.length(), c, ok, clock_seconds() - t );
+  return ok;
+}
+
 inline void searcher::call_recurse( const change &ch )
 {
   // Store old value of r -- this is considerably cheaper than calling
@@ -659,7 +703,7 @@ inline void searcher::call_recurse( const change &ch )
   row old;
   if ( maintain_r ) old = r;
 
-  if ( push_change( ch ) )
+  if ( profiled( search_profile::rows, &searcher::push_change, ch ) )
     general_recurse();
 
   pop_change( &old );
@@ -1062,7 +1106,8 @@ cerr << "SOUP: " << ch << " at depth " << m.length() << endl;
 
   if ( ( args.allowed_falseness.size() || args.require_CPS ) 
        && depth - div_start >= 1 && depth - div_start != cur_div_len - 1
-       && ! is_falseness_acceptable( ch ) )
+       && ! profiled( search_profile::falseness, 
+                      &searcher::is_falseness_acceptable, ch ) )
     return false;
 
   return true;
@@ -1181,19 +1226,22 @@ void searcher::new_midlead_change()
         continue;
 
       // Generic tests that apply anywhere:
-      if ( ! try_midlead_change( ch ) )
+      if ( ! profiled( search_profile::midlead,
+                       &searcher::try_midlead_change, ch ) )
         continue;
 
       // XXX ALLIANCE -- locate rotational symmetry point
       // Additional requirements for the rotational symmetry point:
       if ( args.hunt_bells && args.skewsym && lead_len % 4 == 0 
            && depth % (lead_len/2) == lead_len / 4 - args.hunt_bells % 2 &&
-           ! try_quarterlead_change( ch ) )
+           ! profiled( search_profile::quarterlead,
+                       &searcher::try_quarterlead_change, ch ) )
         continue;
 
       // Additional requirements for the half-lead:
       if ( depth == lead_len/2-1 )
-        if ( ! try_halflead_change( ch ) )
+        if ( ! profiled( search_profile::halflead,
+                         &searcher::try_halflead_change, ch ) )
           continue;
 
       // Additional requirements for the palindromic symmetry point of the 
@@ -1202,12 +1250,14 @@ void searcher::new_midlead_change()
       if ( args.hunt_bells % 2 == 1 && depth == lead_len/2 - 1 ||
            args.hunt_bells && 
            args.hunt_bells % 2 == 0 && depth == lead_len/2 + cur_div_len/2 - 1 )
-        if ( ! try_halflead_sym_change( ch ) )
+        if ( ! profiled( search_profile::halflead_sym,
+                         &searcher::try_halflead_sym_change, ch ) )
           continue;
      
       // Additional requirements for the lead-end: 
       if ( depth == size_t(lead_len-1) )
-        if ( ! try_leadend_change( ch ) )
+        if ( ! profiled( search_profile::leadend,
+                         &searcher::try_leadend_change, ch ) )
           continue;
       
       // Additional requirements for the palindromic symmetry point of the
@@ -1216,13 +1266,15 @@ void searcher::new_midlead_change()
       // the lead (e.g. in Grandsire, it is the 3 at the start of the lead).
       if ( !sym_offset && depth == lead_len-1 ||
            sym_offset && depth == sym_offset-1 )
-        if ( ! try_leadend_sym_change( ch ) )
+        if ( ! profiled( search_profile::leadend_sym,
+                         &searcher::try_leadend_sym_change, ch ) )
           continue;
       
       if ( args.hunt_bells && args.require_offset_cyclic 
            // XXX ALLIANCE -- First division
            && div_start == 0 && cur_div_len > 3 && depth == cur_div_len-3 )
-        if ( ! try_offset_start_change( ch ) )
+        if ( ! profiled( search_profile::offset_start,
+                         &searcher::try_offset_start_change, ch ) )
           continue;
 
       call_recurse( ch );
@@ -1364,7 +1416,8 @@ void searcher::general_recurse()
     {
       if ( filter_method.size() && filter_method != m )
         ;
-      else if ( is_acceptable_method() ) {
+      else if ( profiled( search_profile::method,
+                          &searcher::is_acceptable_method ) ) {
         if ( !args.invert_filter ) 
           output_method(m);
 
@@ -33,6 +33,7 @@
 #include <ringing/print_ps.h>
 #include <ringing/print_pdf.h>
 #include <ringing/mslib.h>
+#include <ringing/binlib.h>
 #include <ringing/cclib.h>
 #include <ringing/streamutils.h>
 #include "args.h"
@@ -642,6 +643,7 @@ int main(int argc, char *argv[])
   {
     if(!args.method_name.empty()) {
       // Load the method
+      binlib::registerlib();
       mslib::registerlib();
       cclib::registerlib();
       library l(args.library_name);
@@ -20,6 +20,7 @@
 // Turn this on for debugging:
 #define RINGING_DEBUG_FILE 0
 
+#include <ringing/exact_cover.h>
 #include <ringing/extent.h>
 #include <ringing/falseness.h>
 #include <ringing/group.h>
@@ -43,6 +44,13 @@
 
 #include <cassert>
 
+#if RINGING_USE_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#endif
+
 #if RINGING_DEBUG_FILE
 #define DEBUG( expr ) (void)((cout << expr) << endl)
 #else
@@ -233,6 +241,8 @@ struct arguments
 
   init_val<bool,false> in_course; 
   init_val<bool,false> prune_rotations;
+  init_val<bool,false> exact_cover;
+  init_val<int,1>      threads;
 
   init_val<int,0>      verbosity;
   init_val<bool,false> quiet;
@@ -285,6 +295,17 @@ void arguments::bind( arg_parser& p )
            "Filter out touches only differing by a rotation",
            prune_rotations ) );
 
+  p.add( new boolean_opt
+         ( 'x', "exact-cover",
+           "Find plans with an exact cover solver instead of searching "
+           "lead head by lead head",
+           exact_cover ) );
+
+  p.add( new integer_opt
+         ( 'j', "threads",
+           "Search subtrees on NUM threads at once", "NUM",
+           threads ) );
+
   p.add( new strings_opt
          ( 'P', "part-end",
            "Specify a part end",  "ROW",
@@ -330,6 +351,24 @@ bool arguments::validate( arg_parser& ap )
       return false;
     }
 
+  if ( threads < 1 )
+    {
+      ap.error( "The number of threads must be at least one" );
+      return false;
+    }
+
+  if ( exact_cover && threads > 1 )
+    {
+      ap.error( "The exact cover solver cannot use more than one thread" );
+      return false;
+    }
+
+#if !RINGING_USE_THREADS
+  if ( threads > 1 )
+    ap.error( "Warning: threads are not supported in this build, "
+              "so the search will use one thread" );
+#endif
+
   return true;
 }
 
@@ -357,11 +396,111 @@ bool arguments::generate_pends( arg_parser& ap )
 }
 
 
+// The methods that can still be rung at each lead head, held as a 
+// bitset over the method list.  The lead heads are bucketed by how many
+// methods they have, so that the most constrained can be found without
+// scanning every lead head.
+class possibles_table {
+public:
+  possibles_table( size_t lhs, size_t meths );
+
+  bool contains( size_t lh, size_t m ) const 
+    { return cands[ lh*cw + m/word_bits ] & bit(m); }
+  size_t count( size_t lh ) const { return counts[lh]; }
+
+  void insert( size_t lh, size_t m );
+  void erase( size_t lh, size_t m );
+
+  // Finds the lead head with the fewest methods, other than those with
+  // none, preferring the first if there are several.  Returns false if
+  // every lead head has no methods.
+  bool select( size_t& lh ) const;
+
+  void methods( size_t lh, vector<size_t>& meths ) const;
+
+private:
+  typedef unsigned long word;
+  static const size_t word_bits = sizeof(word) * 8;
+  static word bit( size_t i ) { return word(1) << (i % word_bits); }
+
+  void bucket_insert( size_t lh );
+  void bucket_erase( size_t lh );
+
+  size_t cw, bw;  // words per candidate set and per bucket
+  vector<word> cands;
+  vector<size_t> counts;
+  vector<word> buckets;  // a bitset of lead heads for each count
+  vector<size_t> bucket_sizes;
+};
+
+possibles_table::possibles_table( size_t lhs, size_t meths )
+  : cw( (meths + word_bits - 1) / word_bits ), 
+    bw( (lhs + word_bits - 1) / word_bits ),
+    cands( lhs * cw ), counts( lhs ), 
+    buckets( (meths + 1) * bw ), bucket_sizes( meths + 1 )
+{
+}
+
+void possibles_table::bucket_insert( size_t lh )
+{
+  size_t n = counts[lh];
+  buckets[ n*bw + lh/word_bits ] |= bit(lh);
+  ++bucket_sizes[n];
+}
+
+void possibles_table::bucket_erase( size_t lh )
+{
+  size_t n = counts[lh];
+  buckets[ n*bw + lh/word_bits ] &= ~bit(lh);
+  --bucket_sizes[n];
+}
+
+void possibles_table::insert( size_t lh, size_t m )
+{
+  assert( !contains(lh, m) );
+  cands[ lh*cw + m/word_bits ] |= bit(m);
+  if ( counts[lh] ) bucket_erase(lh);
+  ++counts[lh];
+  bucket_insert(lh);
+}
+
+void possibles_table::erase( size_t lh, size_t m )
+{
+  assert( contains(lh, m) );
+  cands[ lh*cw + m/word_bits ] &= ~bit(m);
+  bucket_erase(lh);
+  if ( --counts[lh] ) bucket_insert(lh);
+}
+
+bool possibles_table::select( size_t& lh ) const
+{
+  for ( size_t n = 1; n < bucket_sizes.size(); ++n ) 
+    if ( bucket_sizes[n] ) {
+      size_t i = n*bw;
+      while ( !buckets[i] ) ++i;
+      word w = buckets[i];
+      lh = (i - n*bw) * word_bits;
+      while ( !(w & 1) ) w >>= 1, ++lh;
+      return true;
+    }
+
+  return false;
+}
+
+void possibles_table::methods( size_t lh, vector<size_t>& meths ) const
+{
+  for ( size_t i = 0; i < cw; ++i )
+    for ( word w = cands[ lh*cw + i ], m = i * word_bits; w; w >>= 1, ++m )
+      if ( w & 1 ) meths.push_back(m);
+}
+
 class searcher {
 public:
   searcher( arguments const& args );
 
   void recurse();
+  void search( int threads );
+  void solve_exact_cover();
 
 private:
   typedef sqmulttab::row_t row_t;
@@ -369,8 +508,7 @@ private:
   typedef method_list::const_iterator method_ptr;
   typedef pair<method_ptr, method_ptr> method_pair;
   typedef vector<row_t> falseness_tab;
-  //typedef map<row_t, method_ptr, row_t::cmp> composition;
-  typedef multimap<row_t, method_ptr, row_t::cmp> pos_map;
+  typedef pair<size_t, size_t> possible; // lead head and method indices
 
   sqmulttab* make_multtab();
   void init_pends();
@@ -379,39 +517,95 @@ private:
   void select_possibles( row_t& lh, vector<method_ptr>& meths ) const;
   bool is_possible( row_t const& lh, method_ptr const& m ) const;
   void found( unsigned rotn_count );
+  void output( spliced_plan const& plan, unsigned rotn_count ) const;
+  void complete();
   void set_method( row_t const& lh, method_ptr const& m );
   void unset_method( row_t const& lh, method_ptr const& m );
-  void recheck_pos_map( row_t const& lh, method_ptr const& m,
-                        vector<pair<row_t, method_ptr> >& backtrack );
+  void recheck_pos_map( row_t const& lh, method_ptr const& m );
+  void remove_possible( row_t const& lh, size_t m );
+  void restore_possibles( size_t n );
   bool are_false( row_t const& lh1, method_ptr const& m1, 
                   row_t const& lh2, method_ptr const& m2 ) const;
   void done_with_method( method_ptr const& m );
   bool is_rotational_standard_form( unsigned& rotn_count ) const;
+  void lead_rows( row_t const& lh, method_ptr const& m, 
+                  vector<row_t>& rows ) const;
+
+  class cover_outputer;
+  friend class cover_outputer;
+
+  struct found_plan {
+    found_plan( spliced_plan const& plan, unsigned rotn_count )
+      : plan(plan), rotn_count(rotn_count) {}
+    spliced_plan plan;
+    unsigned rotn_count;
+  };
+
+  // A subtree of the search, reached by choosing each lead in PATH.  
+  // With -r, the first DONE start methods have already been searched.
+  struct job {
+    job() : done(0), finished(false) {}
+    vector< pair<row_t, method_ptr> > path;
+    size_t done;
+    vector<found_plan> plans;
+    bool finished;
+  };
+
+  void plan_jobs( size_t levels, vector<method_ptr>& starts,
+                  vector<job>& jobs, job& j );
+  void run_job( job const& j, vector<method_ptr> const& starts );
+  void reset( searcher const& s );
+
+#if RINGING_USE_THREADS
+  class job_queue;
+  void search_threads( int threads );
+  static void run_worker( searcher& w, searcher const& s, job_queue& q );
+#endif
 
   arguments const& args;
 
   RINGING_ULLONG node_count;
 
-  scoped_pointer<sqmulttab> mt;
+  // Copies of the searcher share the multiplication table and methods,
+  // as method_ptrs are iterators into the method list.
+  shared_pointer<sqmulttab> mt;
+  shared_pointer<method_list> ml;
 
-  method_list meths; 
+  method_list const& meths; 
   map<method_pair, falseness_tab> false_data;
+
+  // For the lead of method i at lh1, the lead heads lh2 = lh1 * x at 
+  // which method j is false against it, for x in inv_false[i*N+j], and 
+  // at which a lead of method j would have the same lead end, for x in 
+  // inv_les[j].  (Part ends are not included.)
+  vector<falseness_tab> inv_false;
+  vector<row_t> inv_les;
   vector<row_t> pends;
 
   set<row_t, row_t::cmp> free_lhs;
 
   spliced_plan comp;
-  pos_map possibles;
+  vector<row_t> lhs;  // indexed by row_t::index()
+  possibles_table possibles;
+  vector<possible> undo;
+
+  vector<found_plan>* results;  // where a worker puts the plans it finds
 };
 
 searcher::searcher( arguments const& args )
   : args(args),
     node_count(0), mt(make_multtab()), 
-    meths(litelib(args.bells, cin), *mt), comp(*mt)
+    ml( new method_list(litelib(args.bells, cin), *mt) ), meths(*ml), 
+    comp(*mt), possibles( mt->size(), meths.end() - meths.begin() ),
+    results(NULL)
 {
   init_pends();
   init_falseness();
   init_search();
+
+  // This is only needed to find the initial possibilities, and would
+  // otherwise be copied for every thread
+  false_data.clear();
 }
 
 sqmulttab* searcher::make_multtab()
@@ -444,6 +638,21 @@ void searcher::init_falseness()
       ft2.push_back( mt->find(*fi) );
     false_data[ make_pair(i,j) ] = ft2;
   }
+
+  // Lead heads at which a lead is false against one at rounds
+  size_t const n = meths.end() - meths.begin();
+  inv_false.resize( n*n );
+  inv_les.reserve( n );
+  for ( method_ptr i=meths.begin(), e=meths.end(); i != e; ++i ) {
+    inv_les.push_back( mt->find( mt->find(i->le).inverse() ) );
+    for ( method_ptr j=meths.begin(); j != e; ++j ) {
+      falseness_tab const& ft = false_data[ make_pair(j,i) ];
+      falseness_tab& inv = inv_false[ (i-meths.begin())*n + (j-meths.begin()) ];
+      for ( falseness_tab::const_iterator fi=ft.begin(), fe=ft.end(); 
+            fi != fe; ++fi )
+        inv.push_back( mt->find( mt->find(*fi).inverse() ) );
+    }
+  }
 }
 
 bool searcher::is_possible( row_t const& lh, 
@@ -477,11 +686,14 @@ void searcher::init_search()
 
   DEBUG( "Have " << free_lhs.size() << " lead heads and ends" );
 
+  lhs.resize( mt->size() );
   for ( set<row_t>::const_iterator 
-          li = free_lhs.begin(), le = free_lhs.end(); li != le; ++li ) 
+          li = free_lhs.begin(), le = free_lhs.end(); li != le; ++li ) {
+    lhs[ li->index() ] = *li;
     for ( method_ptr mi=meths.begin(), me=meths.end(); mi != me; ++mi ) 
       if ( is_possible( *li, mi ) )
-        possibles.insert( make_pair( *li, mi ) );
+        possibles.insert( li->index(), mi - meths.begin() );
+  }
 }
 
 bool searcher::are_false( row_t const& lh1, method_ptr const& m1, 
@@ -510,25 +722,42 @@ bool searcher::are_false( row_t const& lh1, method_ptr const& m1,
   return false;
 }
 
-void searcher::recheck_pos_map( row_t const& lh, method_ptr const& m,
-                                vector<pair<row_t,method_ptr> >& backtrack )
+// Removes a possibility, recording it in the undo log
+inline void searcher::remove_possible( row_t const& lh, size_t m )
+{
+  if ( possibles.contains( lh.index(), m ) ) {
+    possibles.erase( lh.index(), m );
+    undo.push_back( possible( lh.index(), m ) );
+  }
+}
+
+// Puts back the possibilities removed since the undo log had N entries
+void searcher::restore_possibles( size_t n )
+{
+  while ( undo.size() > n ) {
+    possibles.insert( undo.back().first, undo.back().second );
+    undo.pop_back();
+  }
+}
+
+// Removes the possibilities which have the same lead end as the lead
+// of M at LH, or are false against it.  Rather than checking each 
+// possibility, this looks up the lead heads where each method would 
+// be a problem.  This is equivalent to calling are_false on each.
+void searcher::recheck_pos_map( row_t const& lh, method_ptr const& m )
 {
   row_t const le = lh * m->le;
+  size_t const n = inv_les.size(), mi = m - meths.begin();
 
-  for ( pos_map::iterator j=possibles.begin(), e=possibles.end(); j != e; ) 
-  {
-    pos_map::iterator i = j++;  // This allows us to erase i
+  for ( size_t j = 0; j < n; ++j ) {
+    remove_possible( le * inv_les[j], j );
 
-    if ( i->first * i->second->le == le ) {
-      backtrack.push_back(*i);
-      possibles.erase(i);
-      continue;
-    }
-  
-    if ( are_false( lh, m, i->first, i->second ) ) { 
-      backtrack.push_back(*i);
-      possibles.erase(i);
-    }
+    falseness_tab const& ft = inv_false[ mi*n + j ];
+    for ( falseness_tab::const_iterator fi=ft.begin(), fe=ft.end(); 
+          fi != fe; ++fi )
+      for ( vector<row_t>::const_iterator
+              pi=pends.begin(), pe=pends.end(); pi!=pe; ++pi )
+        remove_possible( *pi * lh * *fi, j );
   }
 }
 
@@ -554,11 +783,9 @@ bool searcher::is_rotational_standard_form( unsigned& rotn_count ) const
 
 void searcher::done_with_method( method_ptr const& m ) 
 {
-  pos_map::iterator i = possibles.begin(), e = possibles.end();
-  while ( i != e ) {
-    pos_map::iterator j = i;  ++i;  // We can now call erase(j) safely
-    if ( j->second == m ) possibles.erase(j);
-  }
+  for ( size_t i = 0; i < lhs.size(); ++i )
+    if ( possibles.contains( i, m - meths.begin() ) )
+      possibles.erase( i, m - meths.begin() );
 }
 
 void searcher::select_possibles( searcher::row_t& lh,
@@ -566,39 +793,29 @@ void searcher::select_possibles( searcher::row_t& lh,
 {
   // First, lets choose which lead head to look at.  Our strategy is to
   // choose the l.h. with the fewest possible methods available.
-  pos_map::const_iterator i = possibles.begin(), e = possibles.end();
-
-  pair< pos_map::const_iterator, pos_map::const_iterator > best(i, i);
-  unsigned best_sz = unsigned(-1);  
-
-  while ( i != e ) {
-    unsigned sz = 0;
-    pos_map::const_iterator j = i;
-    for ( ; j != e; ++j, ++sz )
-      if ( j->first != i->first )
-        break;
-    if ( sz < best_sz ) {
-      best_sz = sz;
-      best = make_pair( i, j );
-    }
-    i = j;
-  }
-
-  // BEST is the range in POSSIBLES where the l.h. has the fewest possible
-  // methods, and BEST_SZ is the number of methods.
-
-  if ( best.first == best.second ) {
+  size_t i;
+  if ( !possibles.select(i) ) {
     try_meths.clear();
-  } 
-  else {
-    lh = best.first->first;
-    for ( ; best.first != best.second; ++best.first )
-      try_meths.push_back( best.first->second );
+    return;
   }
-  const int depth = comp.size() / 2;
+
+  lh = lhs[i];
+  vector<size_t> ms;
+  possibles.methods( i, ms );
+  for ( vector<size_t>::const_iterator mi = ms.begin(), me = ms.end(); 
+        mi != me; ++mi )
+    try_meths.push_back( meths.begin() + *mi );
 }
 
 void searcher::found( unsigned rotn_count )
+{
+  if ( results ) 
+    results->push_back( found_plan( comp, rotn_count ) );
+  else
+    output( comp, rotn_count );
+}
+
+void searcher::output( spliced_plan const& plan, unsigned rotn_count ) const
 {
   static int plan_n = 0;
   ++plan_n;
@@ -616,13 +833,13 @@ void searcher::found( unsigned rotn_count )
     }
 
     ofstream os( filename.c_str() );
-    comp.write_plan(os);
+    plan.write_plan(os);
     os.close();
   }
 
   map< method_ptr, unsigned > counts;
 
-  for ( spliced_plan::const_iterator ci = comp.begin(), ce = comp.end();
+  for ( spliced_plan::const_iterator ci = plan.begin(), ce = plan.end();
           ci != ce; ++ci ) {
     counts[ ci->second ]++;
   }
@@ -705,7 +922,9 @@ void searcher::recurse()
   vector<method_ptr> try_meths;
   select_possibles( lh, try_meths );
 
-  possibles.erase(lh);
+  for ( vector<method_ptr>::const_iterator 
+          i = try_meths.begin(), e = try_meths.end(); i != e; ++i )
+    possibles.erase( lh.index(), *i - meths.begin() );
 
   const int depth = comp.size() / 2;
 
@@ -715,22 +934,16 @@ void searcher::recurse()
     if (args.verbosity && depth == 0)
       cerr << "Trying start method: " << (*i)->meth.name() << endl;
 
-    if (depth && depth < args.verbosity)
+    if (depth && depth < args.verbosity && !results)
       cerr << string(depth, ' ') << string(depth, ' ') << mt->find(lh) 
            << " -> " << (*i)->meth.name() << endl;
 
-    vector<pair<row_t, method_ptr> > undo;
+    size_t const mark = undo.size();
     set_method(lh, *i);
-    recheck_pos_map(lh, *i, undo);
-    if ( free_lhs.empty() ) {
-      unsigned rotn_count = 0;
-      bool canonical_rotn = is_rotational_standard_form(rotn_count);
-      if ( !args.prune_rotations || canonical_rotn ) 
-        found( rotn_count );  
-    }
-    else recurse();
+    recheck_pos_map(lh, *i);
+    complete();
     unset_method(lh, *i);
-    copy( undo.begin(), undo.end(), inserter(possibles, possibles.begin()) );
+    restore_possibles(mark);
 
     // Poor man's rotational pruning
     if (depth == 0 && args.prune_rotations) 
@@ -739,13 +952,335 @@ void searcher::recurse()
 
   for ( vector<method_ptr>::const_iterator 
           i = try_meths.begin(), e = try_meths.end(); i != e; ++i )
-    possibles.insert( make_pair(lh, *i) );
+    possibles.insert( lh.index(), *i - meths.begin() );
 
   ++node_count;
   if (depth == 0 && args.verbosity) 
     cerr << "Searched " << node_count << " nodes\n";
 }
 
+// Called once a lead has been chosen: either every lead head has been
+// used, or the search continues
+void searcher::complete()
+{
+  if ( free_lhs.empty() ) {
+    unsigned rotn_count = 0;
+    bool canonical_rotn = is_rotational_standard_form(rotn_count);
+    if ( !args.prune_rotations || canonical_rotn ) 
+      found( rotn_count );  
+  }
+  else recurse();
+}
+
+// Splits the search into subtrees, by following recurse down LEVELS 
+// levels.  STARTS is set to the methods tried at the first lead head.
+void searcher::plan_jobs( size_t levels, vector<method_ptr>& starts,
+                          vector<job>& jobs, job& j )
+{
+  if ( free_lhs.empty() || j.path.size() == levels ) {
+    jobs.push_back(j);
+    return;
+  }
+
+  row_t lh;
+  vector<method_ptr> try_meths;
+  select_possibles( lh, try_meths );
+  if ( j.path.empty() ) starts = try_meths;
+
+  for ( vector<method_ptr>::const_iterator 
+          i = try_meths.begin(), e = try_meths.end(); i != e; ++i )
+    possibles.erase( lh.index(), *i - meths.begin() );
+
+  for ( vector<method_ptr>::const_iterator 
+          i = try_meths.begin(), e = try_meths.end(); i != e; ++i )
+  {
+    size_t const mark = undo.size();
+    set_method(lh, *i);
+    recheck_pos_map(lh, *i);
+    j.path.push_back( make_pair(lh, *i) );
+    plan_jobs( levels, starts, jobs, j );
+    j.path.pop_back();
+    unset_method(lh, *i);
+    restore_possibles(mark);
+
+    if (j.path.empty() && args.prune_rotations) {
+      done_with_method(*i);
+      ++j.done;
+    }
+  }
+
+  for ( vector<method_ptr>::const_iterator 
+          i = try_meths.begin(), e = try_meths.end(); i != e; ++i )
+    possibles.insert( lh.index(), *i - meths.begin() );
+
+  ++node_count;
+}
+
+// Searches a subtree by making the same choices as recurse did to 
+// reach it.  The searcher must be in its initial state.
+void searcher::run_job( job const& j, vector<method_ptr> const& starts )
+{
+  for ( size_t k = 0; k < j.path.size(); ++k ) {
+    row_t const& lh = j.path[k].first;
+    method_ptr const& m = j.path[k].second;
+
+    vector<size_t> ms;
+    possibles.methods( lh.index(), ms );
+    for ( vector<size_t>::const_iterator mi = ms.begin(), me = ms.end(); 
+          mi != me; ++mi )
+      possibles.erase( lh.index(), *mi );
+
+    if ( k == 0 )
+      for ( size_t i = 0; i < j.done; ++i )
+        done_with_method( starts[i] );
+
+    set_method(lh, m);
+    recheck_pos_map(lh, m);
+  }
+
+  complete();
+}
+
+// Returns to the state of S, which must share this searcher's tables
+void searcher::reset( searcher const& s )
+{
+  free_lhs = s.free_lhs;
+  comp = s.comp;
+  possibles = s.possibles;
+  undo.clear();
+}
+
+void searcher::search( int threads )
+{
+#if RINGING_USE_THREADS
+  if ( threads > 1 ) {
+    search_threads( threads );
+    return;
+  }
+#endif
+  recurse();
+}
+
+#if RINGING_USE_THREADS
+// Hands out jobs to the worker threads in order, and lets the main 
+// thread wait for each to finish
+class searcher::job_queue {
+public:
+  job_queue( vector<job>& jobs, vector<method_ptr> const& starts ) 
+    : jobs(jobs), starts(starts), next(0) {}
+
+  job* take() {
+    lock_guard<mutex> l(m);
+    return next < jobs.size() ? &jobs[next++] : NULL;
+  }
+
+  void finish( job& j ) {
+    { lock_guard<mutex> l(m); j.finished = true; }
+    cv.notify_all();
+  }
+
+  void wait( job const& j ) {
+    unique_lock<mutex> l(m);
+    while ( !j.finished ) cv.wait(l);
+  }
+
+  vector<method_ptr> const& start_methods() const { return starts; }
+
+private:
+  vector<job>& jobs;
+  vector<method_ptr> const& starts;
+  size_t next;
+  mutex m;
+  condition_variable cv;
+};
+
+void searcher::run_worker( searcher& w, searcher const& s, job_queue& q )
+{
+  while ( job* j = q.take() ) {
+    w.reset(s);
+    w.results = &j->plans;
+    w.run_job( *j, q.start_methods() );
+    q.finish( *j );
+  }
+}
+
+// The subtrees are searched in parallel, but the plans found in each
+// are output in the order that recurse would find them, so the output
+// is the same as with one thread.
+void searcher::search_threads( int threads )
+{
+  // Split the search finely enough that the threads finish together
+  vector<job> jobs;
+  vector<method_ptr> starts;
+  RINGING_ULLONG nodes = 0;
+  for ( size_t levels = 1; jobs.size() < 8 * size_t(threads) && levels <= 4; 
+        ++levels ) {
+    searcher p(*this);
+    job j;
+    jobs.clear();
+    p.plan_jobs( levels, starts, jobs, j );
+    nodes = p.node_count;
+  }
+
+  if (args.verbosity)
+    cerr << "Searching " << jobs.size() << " subtrees on " 
+         << threads << " threads" << endl;
+
+  // Copies must be made on this thread, as shared_pointer is not 
+  // thread-safe
+  vector< shared_pointer<searcher> > workers;
+  for ( int k = 0; k < threads; ++k )
+    workers.push_back( shared_pointer<searcher>( new searcher(*this) ) );
+
+  job_queue q( jobs, starts );
+  vector<thread> ts;
+  for ( int k = 0; k < threads; ++k )
+    ts.push_back( thread( &run_worker, ref(*workers[k]), cref(*this), 
+                          ref(q) ) );
+
+  for ( vector<job>::iterator i = jobs.begin(), e = jobs.end(); i != e; ++i ) {
+    q.wait( *i );
+    for ( vector<found_plan>::const_iterator 
+            pi = i->plans.begin(), pe = i->plans.end(); pi != pe; ++pi )
+      output( pi->plan, pi->rotn_count );
+    vector<found_plan>().swap( i->plans );
+  }
+
+  for ( int k = 0; k < threads; ++k ) {
+    ts[k].join();
+    nodes += workers[k]->node_count;
+  }
+
+  if (args.verbosity) 
+    cerr << "Searched " << nodes << " nodes\n";
+}
+#endif
+
+// The lead heads set by a lead of M at LH
+void searcher::lead_rows( row_t const& lh1, method_ptr const& m,
+                          vector<row_t>& rows ) const
+{
+  row_t const le1 = lh1 * m->le;
+  for ( vector<row_t>::const_iterator
+          pi=pends.begin(), pe=pends.end(); pi!=pe; ++pi ) {
+    rows.push_back( *pi * lh1 );
+    rows.push_back( *pi * le1 );
+  }
+
+  sort( rows.begin(), rows.end(), row_t::cmp() );
+  rows.erase( unique( rows.begin(), rows.end() ), rows.end() );
+}
+
+class searcher::cover_outputer : public exact_cover::outputer {
+public:
+  cover_outputer( searcher& s, vector<possible> const& opts ) 
+    : s(s), opts(opts) {}
+
+  virtual bool operator()( vector<size_t> const& soln ) {
+    for ( vector<size_t>::const_iterator i=soln.begin(), e=soln.end(); 
+          i != e; ++i )
+      s.set_method( s.lhs[ opts[*i].first ], 
+                    s.meths.begin() + opts[*i].second );
+    assert( s.free_lhs.empty() );
+
+    unsigned rotn_count = 0;
+    bool canonical_rotn = s.is_rotational_standard_form(rotn_count);
+    if ( !s.args.prune_rotations || canonical_rotn ) 
+      s.found( rotn_count );  
+
+    for ( vector<size_t>::const_iterator i=soln.begin(), e=soln.end(); 
+          i != e; ++i )
+      s.unset_method( s.lhs[ opts[*i].first ], 
+                      s.meths.begin() + opts[*i].second );
+    return false;
+  }
+
+private:
+  searcher& s;
+  vector<possible> const& opts;
+};
+
+// Each lead head is an item which must be covered exactly once, and
+// each possible lead is an option covering the lead heads it sets.  A
+// lead sets the same lead heads as its images under the part ends and
+// (for symmetric methods) as the lead rung from its lead end, so these 
+// are one option.  Every row of the extent is a secondary item, and 
+// each option contains the rows of its leads, so that two false leads
+// cannot both be chosen.
+void searcher::solve_exact_cover()
+{
+  size_t const npos = size_t(-1), nm = inv_les.size();
+  map<row, size_t> row_items;
+
+  vector<size_t> items( lhs.size(), npos );
+  size_t nitems = 0;
+  for ( set<row_t, row_t::cmp>::const_iterator 
+          li = free_lhs.begin(), le = free_lhs.end(); li != le; ++li ) 
+    items[ li->index() ] = nitems++;
+
+  vector<possible> opts;
+  vector< vector<size_t> > opt_items;
+  vector<size_t> opt_at( lhs.size() * nm, npos );
+  for ( set<row_t, row_t::cmp>::const_iterator 
+          li = free_lhs.begin(), le = free_lhs.end(); li != le; ++li ) 
+    for ( size_t m = 0; m < nm; ++m ) {
+      size_t const i = li->index();
+      if ( !possibles.contains(i, m) || opt_at[ i*nm + m ] != npos ) 
+        continue;
+
+      method_ptr const mp = meths.begin() + m;
+      vector<row_t> rows;
+      lead_rows( *li, mp, rows );
+
+      opt_at[ i*nm + m ] = opts.size();
+      opt_items.push_back( vector<size_t>() );
+      for ( vector<row_t>::const_iterator ri = rows.begin(), re = rows.end();
+            ri != re; ++ri ) {
+        opt_items.back().push_back( items[ ri->index() ] );
+
+        // Is the lead of M from this lead head the same option?
+        vector<row_t> rows2;
+        lead_rows( *ri, mp, rows2 );
+        if ( rows2 == rows && possibles.contains( ri->index(), m ) ) 
+          opt_at[ ri->index()*nm + m ] = opts.size();
+      }
+
+      // The rows of the lead in each part, numbered after the lead heads.
+      // A lead which is false against itself in another part can still
+      // be used, as in recurse.
+      vector<size_t> rs;
+      for ( vector<row_t>::const_iterator
+              pi=pends.begin(), pe=pends.end(); pi!=pe; ++pi ) {
+        row r( mt->find( *pi * *li ) );
+        for ( method::const_iterator ci = mp->meth.begin(), 
+                ce = mp->meth.end(); ci != ce; r *= *ci++ )
+          rs.push_back( row_items.insert
+            ( make_pair( r, nitems + row_items.size() ) ).first->second );
+      }
+      sort( rs.begin(), rs.end() );
+      rs.erase( unique( rs.begin(), rs.end() ), rs.end() );
+      copy( rs.begin(), rs.end(), back_inserter( opt_items.back() ) );
+
+      opts.push_back( possible(i, m) );
+    }
+
+  if (args.verbosity)
+    cerr << "Exact cover with " << nitems << " lead heads, " 
+         << opts.size() << " leads and " << row_items.size() 
+         << " rows" << endl;
+
+  exact_cover ec( nitems, row_items.size() );
+  for ( size_t a = 0; a < opts.size(); ++a )
+    ec.add_option( opt_items[a] );
+  opt_items.clear();
+
+  cover_outputer out( *this, opts );
+  ec.solve( out );
+
+  if (args.verbosity) 
+    cerr << "Searched " << ec.node_count() << " nodes\n";
+}
+
 class analyser
 {
 private:
@@ -874,8 +1409,11 @@ int main(int argc, char const* argv[] )
 
   const bool search = true;
 
-  if (search)
-    searcher(args).recurse();
+  if (search) {
+    searcher s(args);
+    if (args.exact_cover) s.solve_exact_cover();
+    else s.search( args.threads );
+  }
   else {
     analyser a(args);
     for ( int i=1; i<argc; ++i )
@@ -27,12 +27,19 @@
 #include <ringing/falseness.h>
 #include "args.h"
 
+#include <algorithm>
 #include <iostream>
 #include <list>
 #include <set>
 #include <map>
 #include <utility>
 #include <fstream>
+#if RINGING_USE_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#endif
 
 RINGING_USING_NAMESPACE
 RINGING_USING_STD
@@ -57,6 +64,8 @@ struct arguments
   init_val<bool,false> filter_mode;
   init_val<bool,false> read_rows;
 
+  init_val<int,1>      threads;
+
   vector<string>       meth_str;
   vector<method>       meth;
 
@@ -169,6 +178,11 @@ void arguments::bind( arg_parser& p )
          ( '\0', "rows-file",
            "Read the rows of a method from FILE", "FILE",
            rows_file ) );
+
+  p.add( new integer_opt
+         ( 'j', "threads",
+           "Test pairs of methods on NUM threads at once", "NUM",
+           threads ) );
 }
 
 bool arguments::validate( arg_parser& ap )
@@ -260,6 +274,18 @@ bool arguments::validate( arg_parser& ap )
      return false;
    }
 
+  if ( threads < 1 )
+    {
+      ap.error( "The number of threads must be at least one" );
+      return false;
+    }
+
+#if !RINGING_USE_THREADS
+  if ( threads > 1 )
+    ap.error( "Warning: threads are not supported in this build, "
+              "so the methods will be tested on one thread" );
+#endif
+
   return true;
 }
 
@@ -272,10 +298,26 @@ public:
 private:
   static string name_or_pn( arguments const& args, method const& m );
   class sort_function;
-
+  struct lead_info;
+  struct lead_order;
+  struct lead_info_init;
+  struct pair_search;
+  class job_queue;
+
+  int falseness_flags() const;
+  size_t max_group_size() const;
   bool test_splice( method const& a, method const& b );
   string test_splice( method const& a, vector<row> const& b, 
                       string const& b_name = string() );
+  string report_splice( method const& a, group const& sg,
+                        string const& b_name );
+  void find_all_splices( library const& lib );
+  void init_lead_info( lead_info& li ) const;
+  bool is_null_splice( lead_info const& a, lead_info const& b ) const;
+  template <class Task> void run_in_order( Task& t, size_t n ) const;
+#if RINGING_USE_THREADS
+  template <class Task> static void run_jobs( Task& t, job_queue& q );
+#endif
   bell get_pivot( group const& sg ) const;
   pair<bell, bell> get_swapping_pair( group const& sg ) const;
   string describe_splice( group const& sg ) const;
@@ -513,24 +555,31 @@ string splices::describe_splice( group const& sg ) const
   return os;
 }
 
-string splices::test_splice( method const& a, vector<row> const& b,
-                             string const& b_name )
-{ 
-  size_t max_size = factorial(args.bells-1);
-
+int splices::falseness_flags() const
+{
   int flags = 0; 
-  if ( args.in_course ) {
+  if ( args.in_course )
     flags |= falseness_table::in_course_only;
-    max_size /= 2;
-  }
-  else if ( args.out_of_course ) {
+  else if ( args.out_of_course )
     flags |= falseness_table::out_of_course_only;
-    max_size /= 2;
-  }
   if ( args.half_leads ) 
     flags |= falseness_table::half_lead_only;
+  return flags;
+}
 
-  falseness_table ft( a, b, flags );
+// The size of the splice group when there is no splice
+size_t splices::max_group_size() const
+{
+  size_t max_size = factorial(args.bells-1);
+  if ( args.in_course || args.out_of_course )
+    max_size /= 2;
+  return max_size;
+}
+
+string splices::test_splice( method const& a, vector<row> const& b,
+                             string const& b_name )
+{ 
+  falseness_table ft( a, b, falseness_flags() );
   if ( args.print_falseness ) {
     copy( ft.begin(), ft.end(), ostream_iterator<row>(cout, "\n") );
     return string();
@@ -542,7 +591,13 @@ string splices::test_splice( method const& a, vector<row> const& b,
     return string();
   }
 
-  if ( !args.null_splices && sg.size() == max_size )
+  return report_splice( a, sg, b_name );
+}
+
+string splices::report_splice( method const& a, group const& sg,
+                               string const& b_name )
+{
+  if ( !args.null_splices && sg.size() == max_group_size() )
     return string();
 
   if ( args.only_n_leads != -1 && sg.size() != args.only_n_leads * 2 &&
@@ -597,8 +652,269 @@ method splices::get_method( library_entry const& e )
   return m;
 }
 
+// A method from the library, with the rows of its lead and a 
+// signature used to rule out pairs of methods without a splice.  
+//
+// If two rows, a and a', of one method have the treble in the same
+// place, and the other method has a row b with the treble in that
+// place, then a/b and a'/b are in the falseness table, and so a/a' is
+// in the splice group.  (With -i, a/b and a'/b must both be in course,
+// so b must have the same parity as a and a'; with -o, it must have
+// the opposite parity.)  The rows are divided into classes by the 
+// place of the treble, and with -i and -o by their parity as well.  
+// NEED is the set of classes with more than one row, and PROVIDE the
+// set of classes in which a row of the other method would put a/a' 
+// in the splice group.  If FULL, the differences within each class
+// generate every lead head, and there is no splice with any method 
+// that provides every class this one needs.
+struct splices::lead_info {
+  method meth;
+  vector<row> rows;
+  RINGING_ULLONG need, provide;
+  bool full;
+};
+
+void splices::init_lead_info( lead_info& li ) const
+{
+  int rb_flags = row_block::no_final_lead_head; 
+  if ( args.half_leads ) 
+    rb_flags |= row_block::half_lead_only;
+
+  row_block const rb( li.meth, rb_flags );
+  li.rows.assign( rb.begin(), rb.end() );
+  li.need = li.provide = 0;
+  li.full = false;
+
+  bool const parity = args.in_course || args.out_of_course;
+  size_t const classes = ( parity ? 2 : 1 ) * args.bells;
+  if ( classes > sizeof(RINGING_ULLONG) * 8 ) 
+    return;
+
+  // falseness_table only uses the first half of a half-lead block
+  size_t const n = args.half_leads ? li.rows.size() / 2 : li.rows.size();
+
+  size_t const npos = size_t(-1);
+  vector<size_t> first( classes, npos );
+  vector<row> gens;
+  for ( size_t k = 0; k < n; ++k ) {
+    row const& r = li.rows[k];
+    size_t c = r.find( bell(0) );
+    if ( parity ) c = 2*c + ( r.sign() == -1 );
+
+    if ( first[c] == npos ) 
+      first[c] = k;
+    else {
+      gens.push_back( r / li.rows[ first[c] ] );
+      li.need |= (RINGING_ULLONG)1 << c;
+    }
+    li.provide |= (RINGING_ULLONG)1 << ( args.out_of_course ? c ^ 1 : c );
+  }
+
+  li.full = !gens.empty() && group(gens).size() == max_group_size();
+}
+
+// Is it certain that A and B, with A the method whose lead heads are 
+// being tested, have no splice?
+bool splices::is_null_splice( lead_info const& a, lead_info const& b ) const
+{
+  if ( args.null_splices ) 
+    return false;
+
+  if ( a.full && !( a.need & ~b.provide ) ) 
+    return true;
+
+  // With -o, the splice group is only generated by pairs of elements 
+  // of the falseness table, which need not include b/b'.
+  if ( !args.out_of_course && b.full && !( b.need & ~a.provide ) ) 
+    return true;
+
+  return false;
+}
+
+struct splices::pair_search {
+  pair_search( splices& s, vector<lead_info> const& leads, 
+               vector<size_t> const& order )
+    : s(s), leads(leads), order(order), found( leads.size() ) {}
+
+  // Finds the splices between method I and each earlier method
+  void compute( size_t i ) {
+    lead_info const& a = leads[i];
+    for ( vector<size_t>::const_iterator 
+            oi = order.begin(), oe = order.end(); oi != oe; ++oi ) {
+      size_t const j = *oi;
+      if ( j >= i ) continue;
+
+      lead_info const& b = leads[j];
+      if ( !s.args.group_splices && s.args.same_le 
+           && a.meth.back() != b.meth.back() )
+        continue;
+
+      if ( s.is_null_splice( a, b ) )
+        continue;
+
+      falseness_table ft( a.rows, b.rows, s.falseness_flags() );
+      group sg( ft.generate_group() );
+      if ( !s.args.null_splices && sg.size() == s.max_group_size() )
+        continue;
+
+      found[i].push_back( make_pair( j, group() ) );
+      found[i].back().second.swap(sg);
+    }
+  }
+
+  // Prints them, exactly as test_splice would have done
+  void report( size_t i ) {
+    method const& a = leads[i].meth;
+    for ( vector< pair<size_t, group> >::const_iterator 
+            fi = found[i].begin(), fe = found[i].end(); fi != fe; ++fi ) {
+      method const& b = leads[fi->first].meth;
+      string desc = s.report_splice( a, fi->second, name_or_pn(s.args, b) );
+      if ( desc.size() && ( s.args.group_splices || s.args.filter_mode ) )
+        s.save_splice( a, b, desc );
+    }
+    vector< pair<size_t, group> >().swap( found[i] );
+
+    if ( s.args.filter_mode && !s.has_lead_splices(a) )
+      cout << a.format( method::M_FULL_SYMMETRY | method::M_DASH )
+           << "\t" << a.name() << "\n";
+  }
+
+  splices& s;
+  vector<lead_info> const& leads;
+  vector<size_t> const& order;
+  vector< vector< pair<size_t, group> > > found;
+};
+
+struct splices::lead_order {
+  explicit lead_order( vector<lead_info> const& leads, bool equal = false )
+    : leads(leads), equal(equal) {}
+
+  bool operator()( size_t i, size_t j ) const {
+    return equal ? leads[i].meth == leads[j].meth 
+                 : leads[i].meth < leads[j].meth;
+  }
+
+  vector<lead_info> const& leads;
+  bool equal;
+};
+
+struct splices::lead_info_init {
+  lead_info_init( splices const& s, vector<lead_info>& leads ) 
+    : s(s), leads(leads) {}
+
+  void compute( size_t i ) { s.init_lead_info( leads[i] ); }
+  void report( size_t ) {}
+
+  splices const& s;
+  vector<lead_info>& leads;
+};
+
+#if RINGING_USE_THREADS
+// Hands out the jobs in order, and lets the main thread wait for each
+// to finish
+class splices::job_queue {
+public:
+  explicit job_queue( size_t n ) : next(0), done(n) {}
+
+  bool take( size_t& i ) {
+    lock_guard<mutex> l(m);
+    if ( next == done.size() ) return false;
+    i = next++;
+    return true;
+  }
+
+  void finish( size_t i ) {
+    { lock_guard<mutex> l(m); done[i] = true; }
+    cv.notify_all();
+  }
+
+  void wait( size_t i ) {
+    unique_lock<mutex> l(m);
+    while ( !done[i] ) cv.wait(l);
+  }
+
+private:
+  mutex m;
+  condition_variable cv;
+  size_t next;
+  vector<bool> done;
+};
+
+template <class Task>
+void splices::run_jobs( Task& t, job_queue& q )
+{
+  size_t i;
+  while ( q.take(i) ) {
+    t.compute(i);
+    q.finish(i);
+  }
+}
+#endif
+
+// Computes each of N jobs, possibly in parallel, and reports them in
+// order on this thread
+template <class Task>
+void splices::run_in_order( Task& t, size_t n ) const
+{
+#if RINGING_USE_THREADS
+  if ( args.threads > 1 ) {
+    job_queue q(n);
+    vector<thread> ts;
+    for ( int k = 0; k < args.threads; ++k )
+      ts.push_back( thread( &run_jobs<Task>, ref(t), ref(q) ) );
+    for ( size_t i = 0; i < n; ++i ) {
+      q.wait(i);
+      t.report(i);
+    }
+    for ( size_t k = 0; k < ts.size(); ++k )
+      ts[k].join();
+    return;
+  }
+#endif
+  for ( size_t i = 0; i < n; ++i ) {
+    t.compute(i);
+    t.report(i);
+  }
+}
+
+// Finds the splices between every pair of methods in the library.  
+// This gives the same output as testing each method against every 
+// earlier method in turn, but skips pairs which is_null_splice rules
+// out, and tests the rest in parallel.
+void splices::find_all_splices( library const& lib )
+{
+  vector<lead_info> leads;
+  for ( library::const_iterator i=lib.begin(), e=lib.end(); i!=e; ++i ) {
+    leads.push_back( lead_info() );
+    leads.back().meth = get_method(*i);
+  }
+
+  // Each method is tested against the earlier methods in the order 
+  // that a methodset would hold them, which is sorted and without 
+  // duplicates (keeping the first)
+  vector<size_t> order;
+  for ( size_t i = 0; i < leads.size(); ++i ) 
+    order.push_back(i);
+  stable_sort( order.begin(), order.end(), lead_order(leads) );
+  order.erase( unique( order.begin(), order.end(), lead_order(leads, true) ),
+               order.end() );
+
+  { lead_info_init t( *this, leads ); run_in_order( t, leads.size() ); }
+  { pair_search t( *this, leads, order ); run_in_order( t, leads.size() ); }
+
+  if ( args.group_splices ) 
+    print_splice_groups();
+}
+
 void splices::find_splices( library const& lib )
 {
+  // -F and -G print the table or group for each pair as it is tested
+  if ( !args.read_rows && args.rows_file.empty() && args.meth.size() != 1
+       && !args.print_falseness && !args.print_group ) {
+    find_all_splices( lib );
+    return;
+  }
+
   // The source library may not support restarting (e.g. if its 
   // a litelib on stdin), so load them into a methodset as we 
   // find them.
@@ -29,6 +29,13 @@
 #else
 #include <vector>
 #endif
+#if RINGING_USE_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#endif
 #include <ringing/search_base.h>
 #include <ringing/falseness.h>
 #include <ringing/multtab.h>
@@ -55,7 +62,7 @@ join_plan_search::join_plan_search( unsigned int bells,
                                     vector<change> const& calls,
                                     join_plan_search::flags f )
   : plan(plan), calls(calls), lenrange( size_t(0), size_t(-1) ), 
-    f(f), bells(bells)
+    f(f), bells(bells), threads(1)
 {}
 
 join_plan_search::join_plan_search( unsigned int bells, 
@@ -64,7 +71,7 @@ join_plan_search::join_plan_search( unsigned int bells,
                                     pair<size_t, size_t> lenrange,
                                     join_plan_search::flags f )
   : plan(plan), calls(calls), lenrange(lenrange), 
-    f(f), bells(bells)
+    f(f), bells(bells), threads(1)
 {}
 
 class join_plan_search::context : public search_base::context_base
@@ -72,6 +79,7 @@ class join_plan_search::context : public search_base::context_base
 public:
   context( const join_plan_search* s ) 
     : lenrange( s->lenrange ),
+      threads( s->threads ),
       table( make_table(s) )
   {
     DEBUG( "Constructing context: table size " << table.size() );
@@ -89,6 +97,50 @@ private:
   typedef multtab::post_col_t post_col_t;
   typedef multtab::row_t row_t;
 
+  // Logically this is a vector<bool>, but the C++ standard mandates 
+  // that that should be a packed structure.  Changing to vector<char>
+  // makes a small but significant speed improvement.
+  typedef vector<char> lead_vector_t;
+
+  struct job;
+  class job_queue;
+
+  // The state of the search on one thread.  Touches are either passed
+  // to OUTPUT, or on a worker thread, their calls are added to the
+  // current job through the queue.
+  struct state {
+    explicit state( size_t n ) 
+      : leads( n, false ), halt(false), nodes(0ul), stats(NULL), 
+        output(NULL)
+    {
+#if RINGING_USE_THREADS
+      queue = NULL;  current = NULL;  cancel = NULL;
+#endif
+    }
+
+    lead_vector_t leads;                // The leads had so far
+    vector< size_t > comp;              // The calls we've had so far
+    bool halt;                          // Are we terminating the search?
+    RINGING_ULLONG nodes;               // Node count
+    search_stats* stats;                // Or NULL if not wanted
+
+    outputer* output;
+#if RINGING_USE_THREADS
+    job_queue* queue;
+    job* current;
+    atomic<bool> const* cancel;         // Set when the search has halted
+#endif
+  };
+
+  // A subtree of the search, reached by following CALLS from rounds
+  struct job {
+    job() : finished(false) {}
+    vector< size_t > calls;             // Indices into call_les
+    vector< vector<size_t> > found;
+    bool finished;
+    search_stats stats;
+  };
+
   static bool is_in_course( const join_plan_search *s )
   {
     int const psign 
@@ -168,13 +220,19 @@ private:
 
   virtual void run( outputer &output ) 
   {
-    force_halt = false;
-    nodes = 0ul;
-    lead_vector_t( table.size(), false ).swap( leads );
-    run_recursive( output, row_t(), 0 );
+#if RINGING_USE_THREADS
+    if ( threads > 1 ) {
+      run_threads( output );
+      return;
+    }
+#endif
+    state st( table.size() );
+    st.output = &output;
+    st.stats = stats;
+    run_recursive( st, row_t(), 0 );
   }
 
-  void output_touch( outputer& output )
+  bool output_touch( outputer& output, vector<size_t> const& comp )
   {
     list< touch_child_list::entry > &ch = tl->children();
     ch.clear();
@@ -183,18 +241,29 @@ private:
       tl->push_back( 1, t.get_node(comp[i]) );
 
     DEBUG( "Have touch" );
-    force_halt = output( t );
+    return output( t );
   }
 
   // The main loop of the algorithm   
-  void run_recursive( outputer &output, const row_t &lh, size_t depth )
+  void run_recursive( state& st, const row_t &lh, size_t depth )
   {
 #if DEBUG_LEVEL > 1
-    IF_DEBUG( copy( comp.begin(), comp.end(), ostream_iterator<int>(cout) ));
+    IF_DEBUG( copy( st.comp.begin(), st.comp.end(), 
+                    ostream_iterator<int>(cout) ));
     DEBUG( " at depth " << depth );
 #endif 
       
-    IF_DEBUG( (++nodes % 1000000 == 0) && (cout << "Node: " << nodes << "\n") );
+    IF_DEBUG( (++st.nodes % 1000000 == 0) 
+              && (cout << "Node: " << st.nodes << "\n") );
+
+#if RINGING_USE_THREADS
+    if ( st.queue && *st.cancel ) {
+      st.halt = true;
+      return;
+    }
+#endif
+
+    if ( st.stats ) st.stats->node( st.comp.size() );
 
     int meth_n = plan[ lh.index() ];
     if ( meth_n == -1 ) return;  // We're outside of the plan.
@@ -202,35 +271,249 @@ private:
     row_t const le( lh * les[meth_n] );
 
     // Is it going to repeat?
-    if ( leads[lh.index()] || leads[le.index()] ) 
+    if ( st.leads[lh.index()] || st.leads[le.index()] ) 
       {
         // Has it come round, and is it in it's canonical form?
-        if ( depth >= lenrange.first && lh.isrounds() )
-          output_touch( output );
+        if ( !lh.isrounds() )
+          prune( st, search_stats::false_prune );
+        else if ( depth < lenrange.first )
+          prune( st, search_stats::length_prune );
+#if RINGING_USE_THREADS
+        else if ( st.queue ) 
+          st.queue->add( *st.current, st.comp );
+#endif
+        else
+          st.halt = output_touch( *st.output, st.comp );
       }
     else if ( depth < lenrange.second )
       {
         const int num_meths = les.size();
 
-        leads[lh.index()] = true;
-        leads[le.index()] = true;
-        comp.push_back( num_meths + meth_n + 1 );
+        st.leads[lh.index()] = true;
+        st.leads[le.index()] = true;
+        st.comp.push_back( num_meths + meth_n + 1 );
 
-        for ( int i = 0, n = call_les.size(); !force_halt && i < n; ++i )
+        for ( int i = 0, n = call_les.size(); !st.halt && i < n; ++i )
           {
-            run_recursive( output, le * call_les[i], depth + lens[meth_n] );
-            comp.back() += num_meths + 1;
+            run_recursive( st, le * call_les[i], depth + lens[meth_n] );
+            st.comp.back() += num_meths + 1;
           }
 
-        comp.pop_back();
-        leads[le.index()] = false;
-        leads[lh.index()] = false;
+        st.comp.pop_back();
+        st.leads[le.index()] = false;
+        st.leads[lh.index()] = false;
       }
+    else
+      prune( st, search_stats::length_prune );
+  }
+
+  static void prune( state& st, search_stats::prune_reason r )
+  {
+    if ( st.stats ) st.stats->prune(r);
+  }
+
+  // Splits the search into jobs by following run_recursive down LEVELS
+  // leads.  A job is made for each node at that depth, and for each 
+  // touch that comes round sooner.  Sets CUT if any subtree was cut 
+  // off at that depth.  Nodes which are not the root of a job are 
+  // counted in ST's statistics.
+  void plan_jobs( state& st, const row_t &lh, size_t depth, size_t levels,
+                  job& j, vector<job>& jobs, bool& cut ) const
+  {
+    int meth_n = plan[ lh.index() ];
+    if ( meth_n == -1 ) {
+      if ( st.stats ) st.stats->node( j.calls.size() );
+      return;
+    }
+
+    row_t const le( lh * les[meth_n] );
+
+    if ( st.leads[lh.index()] || st.leads[le.index()] ) {
+      if ( depth >= lenrange.first && lh.isrounds() ) 
+        jobs.push_back(j);
+      else {
+        if ( st.stats ) st.stats->node( j.calls.size() );
+        prune( st, lh.isrounds() ? search_stats::length_prune 
+                                 : search_stats::false_prune );
+      }
+    }
+    else if ( j.calls.size() == levels ) {
+      jobs.push_back(j);
+      cut = true;
+    }
+    else if ( depth < lenrange.second ) {
+      if ( st.stats ) st.stats->node( j.calls.size() );
+
+      st.leads[lh.index()] = true;
+      st.leads[le.index()] = true;
+
+      for ( size_t i = 0, n = call_les.size(); i < n; ++i ) {
+        j.calls.push_back(i);
+        plan_jobs( st, le * call_les[i], depth + lens[meth_n], levels, 
+                   j, jobs, cut );
+        j.calls.pop_back();
+      }
+
+      st.leads[le.index()] = false;
+      st.leads[lh.index()] = false;
+    }
+    else {
+      if ( st.stats ) st.stats->node( j.calls.size() );
+      prune( st, search_stats::length_prune );
+    }
+  }
+
+  // Searches a job's subtree, after making the same calls as 
+  // run_recursive would have made to reach it
+  void run_job( state& st, job const& j )
+  {
+    const int num_meths = les.size();
+    row_t lh;  size_t depth = 0;
+    vector<row_t> marked;
+
+    for ( size_t k = 0; k < j.calls.size(); ++k ) {
+      int const meth_n = plan[ lh.index() ];
+      row_t const le( lh * les[meth_n] );
+      st.leads[lh.index()] = true;
+      st.leads[le.index()] = true;
+      marked.push_back(lh);  marked.push_back(le);
+      st.comp.push_back( num_meths + meth_n + 1 
+                         + j.calls[k] * (num_meths + 1) );
+      depth += lens[meth_n];
+      lh = le * call_les[ j.calls[k] ];
+    }
+
+    run_recursive( st, lh, depth );
+
+    st.comp.clear();
+    for ( vector<row_t>::const_iterator i=marked.begin(), e=marked.end();
+          i != e; ++i )
+      st.leads[i->index()] = false;
   }
 
+#if RINGING_USE_THREADS
+  // Hands out the jobs in order, and passes the touches they find to
+  // the outputting thread.  Jobs are not started too far ahead of the 
+  // output, and stop while they have too many touches waiting, so that 
+  // not too many touches are held at once.
+  class job_queue {
+  public:
+    job_queue( vector<job>& jobs, size_t window ) 
+      : jobs(jobs), next(0), done(0), window(window), halted(false) {}
+
+    job* take() {
+      unique_lock<mutex> l(m);
+      while ( !halted && next >= done + window ) cv.wait(l);
+      return !halted && next < jobs.size() ? &jobs[next++] : NULL;
+    }
+
+    void add( job& j, vector<size_t> const& comp ) {
+      unique_lock<mutex> l(m);
+      while ( !halted && j.found.size() >= max_found ) cv.wait(l);
+      j.found.push_back( comp );
+      cv.notify_all();
+    }
+
+    void finish( job& j ) {
+      { lock_guard<mutex> l(m); j.finished = true; }
+      cv.notify_all();
+    }
+
+    // Takes the touches found so far by job I, waiting if there are
+    // none.  Returns false once the job has finished and all of its
+    // touches have been taken.
+    bool take_found( size_t i, vector< vector<size_t> >& found ) {
+      unique_lock<mutex> l(m);
+      done = i;
+      cv.notify_all();
+      while ( jobs[i].found.empty() && !jobs[i].finished ) cv.wait(l);
+      found.clear();
+      found.swap( jobs[i].found );
+      return !found.empty();
+    }
+
+    void halt() {
+      { lock_guard<mutex> l(m); halted = true; }
+      cv.notify_all();
+    }
+
+  private:
+    static const size_t max_found = 4096;
+
+    vector<job>& jobs;
+    size_t next, done, window;
+    bool halted;
+    mutex m;
+    condition_variable cv;
+  };
+
+  static void run_worker( context& c, job_queue& q, 
+                          atomic<bool> const& cancel )
+  {
+    state st( c.table.size() );
+    st.queue = &q;
+    st.cancel = &cancel;
+    while ( job* j = q.take() ) {
+      st.current = j;
+      if ( c.stats ) st.stats = &j->stats;
+      c.run_job( st, *j );
+      q.finish( *j );
+    }
+  }
+
+  // The threads share the tables, which are only read, and each has its
+  // own state.  The touches are output here, in the order run_recursive
+  // would have found them, so the outputer sees exactly the same touches 
+  // as it would with one thread.  Each job gathers its own statistics,
+  // which are added to ours once it has finished.
+  void run_threads( outputer& output )
+  {
+    vector<job> jobs;
+    search_stats planned;
+    bool cut = true;
+    for ( size_t levels = 1; cut && jobs.size() < 8 * threads; ++levels ) {
+      state st( table.size() );
+      st.stats = &planned;
+      job j;
+      jobs.clear();  cut = false;  planned.clear();
+      plan_jobs( st, row_t(), 0, levels, j, jobs, cut );
+    }
+    if ( stats ) stats->merge( planned );
+
+    atomic<bool> cancel( false );
+    job_queue q( jobs, 4 * threads );
+    vector<thread> ts;
+    for ( unsigned k = 0; k < threads; ++k )
+      ts.push_back( thread( &run_worker, ref(*this), ref(q), cref(cancel) ) );
+
+    vector< vector<size_t> > found;
+    size_t i = 0;
+    for ( ; i < jobs.size(); ++i ) {
+      while ( !cancel && q.take_found( i, found ) )
+        for ( vector< vector<size_t> >::const_iterator 
+                fi = found.begin(), fe = found.end(); fi != fe; ++fi )
+          if ( output_touch( output, *fi ) ) {
+            cancel = true;
+            break;
+          }
+      if ( cancel ) break;
+      if ( stats ) stats->merge( jobs[i].stats );
+    }
+
+    q.halt();
+    for ( size_t k = 0; k < ts.size(); ++k )
+      ts[k].join();
+
+    // Include the parts of the search done by jobs that were cut short
+    if ( stats ) 
+      for ( ; i < jobs.size(); ++i )
+        stats->merge( jobs[i].stats );
+  }
+#endif
+
   // Data members
   pair< size_t, size_t > lenrange;      // The min & max lengths (in leads)
-  bool force_halt;                      // Are we terminating the search?
+  unsigned threads;
   multtab table;                        // A precomputed multiplication table
 
   touch t;                              // The current touch
@@ -239,16 +522,6 @@ private:
   vector< size_t > lens;                // lengths for each method
   vector< int > plan;                   // Map multtab::row_t => index into les
   vector< post_col_t > call_les;
-
-  RINGING_ULLONG nodes;                 // Node count
-
-  // Logically this is a vector<bool>, but the C++ standard mandates 
-  // that that should be a packed structure.  Changing to vector<char>
-  // makes a small but significant speed improvement.
-  typedef vector<char> lead_vector_t;
-  lead_vector_t leads;                  // The leads had so far
-
-  vector< size_t > comp;                // The calls we've had so far
 };
 
 search_base::context_base *join_plan_search::new_context() const
@@ -63,6 +63,11 @@ public:
                     vector<change> const& calls, pair<size_t, size_t> lenrange,
                     flags = no_flags );
 
+  // Search subtrees on N threads.  The touches are still output in the 
+  // same order, on the thread calling run, and none are output after 
+  // the outputer asks the search to halt.
+  void set_threads( unsigned n ) { threads = n; }
+
 private:
   // The implementation
   class context;
@@ -75,6 +80,7 @@ private:
   pair< size_t, size_t > lenrange;
   flags                  f;
   unsigned               bells;
+  unsigned               threads;
 };
 
 RINGING_END_NAMESPACE
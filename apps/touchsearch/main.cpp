@@ -44,6 +44,7 @@
 #else
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #endif
 #include <cassert>
 
@@ -145,6 +146,36 @@ private:
   shared_pointer<size_t> i;
 };
 
+// Prints a line every so often while searching with --stats
+class print_progress : public search_stats::progress
+{
+public:
+  virtual void operator()( search_stats const& s )
+  {
+    cerr << "Searched " << s.nodes() << " nodes to depth " 
+         << s.max_depth() << ", found " << s.touches() << " touches ("
+         << (RINGING_ULLONG) s.nodes_per_second() << " nodes/s)" << endl;
+  }
+};
+
+void print_stats( ostream& os, search_stats const& s )
+{
+  os << "Searched " << s.nodes() << " nodes in " 
+     << fixed << setprecision(2) << s.seconds() << " seconds ("
+     << (RINGING_ULLONG) s.nodes_per_second() << " nodes/s)\n"
+     << "Found " << s.touches() << " touches\n"
+     << "Pruned " << s.pruned( search_stats::false_prune ) << " false, "
+     << s.pruned( search_stats::non_canonical_prune ) << " non-canonical, "
+     << s.pruned( search_stats::length_prune ) << " by length\n";
+
+  if ( s.max_depth() ) {
+    os << "Leads        Nodes\n";
+    for ( size_t d = 0; d < s.max_depth(); ++d )
+      os << setw(5) << d << setw(13) << s.nodes(d) << "\n";
+  }
+  os << flush;
+}
+
 void read_plan( int bells, istream& in, map<row, method>& plan )
 {
   string line;  
@@ -180,8 +211,10 @@ void search( arguments const& args, method const& meth,
 
     map<row, method> plan;  read_plan( args.bells, cin, plan );
 
-    searcher.reset
-      ( new join_plan_search( args.bells, plan, args.calls, args.length, f ) );
+    join_plan_search* s 
+      = new join_plan_search( args.bells, plan, args.calls, args.length, f );
+    searcher.reset(s);
+    s->set_threads( args.threads );
   } 
   else {
     table_search::flags f = static_cast<table_search::flags>( 
@@ -194,7 +227,16 @@ void search( arguments const& args, method const& meth,
                                      f, args.extents) );
   }
 
-  touch_search_until( *searcher, iter_from_fun(printer), have_finished(args) );
+  if ( args.stats ) {
+    print_progress progress;
+    search_stats stats( &progress );
+    touch_search_until( *searcher, iter_from_fun(printer), 
+                        have_finished(args), stats );
+    print_stats( cerr, stats );
+  }
+  else
+    touch_search_until( *searcher, iter_from_fun(printer), 
+                        have_finished(args) );
 }
 
 void filter( arguments const& args )
@@ -141,6 +141,17 @@ void arguments::bind( arg_parser& p )
          ( '\0', "filter",
            "Run as a filter on a method library",
            filter_mode ) );
+
+  p.add( new integer_opt
+         ( 'j', "threads",
+           "Search a plan on NUM threads at once", "NUM",
+           threads ) );
+
+  p.add( new boolean_opt
+         ( '\0', "stats",
+           "Print statistics on the search to standard error, "
+           "both while it runs and when it finishes",
+           stats ) );
 }
 
 bool arguments::validate( arg_parser& ap )
@@ -188,6 +199,22 @@ bool arguments::validate( arg_parser& ap )
     }
   }
 
+  if ( threads < 1 ) {
+    ap.error( "The number of threads must be at least one" );
+    return false;
+  }
+
+  if ( threads > 1 && !use_plan ) {
+    ap.error( "Only searches using a plan can use more than one thread" );
+    return false;
+  }
+
+#if !RINGING_USE_THREADS
+  if ( threads > 1 )
+    ap.error( "Warning: threads are not supported in this build, "
+              "so the search will use one thread" );
+#endif
+
   if ( plain_name.empty() ) 
     plain_name = comma_separate ? 'p' : '.';
  
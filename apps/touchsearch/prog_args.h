@@ -53,6 +53,8 @@ struct arguments
   init_val<bool,false> comma_separate;
   init_val<bool,false> use_plan;
   init_val<bool,true>  round_blocks;
+  init_val<int,1>      threads;
+  init_val<bool,false> stats;
 
   string               plain_name;
   string               meth_str;
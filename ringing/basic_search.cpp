@@ -185,17 +185,27 @@ private:
   // The main loop of the algorithm   
   void run_recursive( outputer &output, const row &r, size_t depth, size_t cur ) 
   {
+    if ( stats ) stats->node( depth );
+
     // Is the touch lexicographically no greater than any of it's rotations?
     if ( !is_possibly_canonical( cur ) )
-      return;
+      {
+	prune( search_stats::non_canonical_prune );
+	return;
+      }
 
     // Is the going to repeat?
     if ( is_row_false( r ) )
       {
 	// Has it come round, and is it in it's canonical form?
-	if ( depth >= lenrange.first && r.isrounds() && is_really_canonical() )
+	if ( !r.isrounds() )
+	  prune( search_stats::false_prune );
+	else if ( depth < lenrange.first )
+	  prune( search_stats::length_prune );
+	else if ( !is_really_canonical() )
+	  prune( search_stats::non_canonical_prune );
+	else
 	  output_touches( output, cur );
-
       }
     else if ( depth < lenrange.second )
       {
@@ -211,6 +221,13 @@ private:
 	calls.pop_back();
 	leads.erase( r );
       }
+    else
+      prune( search_stats::length_prune );
+  }
+
+  void prune( search_stats::prune_reason r )
+  {
+    if ( stats ) stats->prune(r);
   }
   
 private:
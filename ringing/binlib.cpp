@@ -0,0 +1,749 @@
+// -*- C++ -*- binlib.cpp - A compact binary method library format
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#include <map.h>
+#include <fstream.h>
+#include <stdexcept.h>
+#else
+#include <vector>
+#include <map>
+#include <fstream>
+#include <stdexcept>
+#endif
+#if RINGING_OLD_C_INCLUDES
+#include <string.h>
+#include <ctype.h>
+#else
+#include <cstring>
+#include <cctype>
+#endif
+#include <stdint.h>
+#if !RINGING_WINDOWS
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <ringing/binlib.h>
+#include <ringing/lexical_cast.h>
+#include <ringing/litelib.h>
+#include <ringing/peal.h>
+#include <ringing/pointers.h>
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+// The file starts with this header.  All offsets are in bytes from the
+// start of the file, and every section starts on a four byte boundary.
+struct file_header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t count;                // Number of methods
+  uint32_t hash_size;            // Slots in each hash table; a power of 2
+  uint32_t nfacets;              // Number of facet columns
+  uint32_t strings;              // The string table
+  uint32_t strings_size;
+  uint32_t name, base_name;      // uint32_t[count] string offsets
+  uint32_t title;                // uint32_t[count] string offsets
+  uint32_t stage;                // uint8_t[count]
+  uint32_t pn_index;             // uint32_t[count+1] indices into pn
+  uint32_t pn;                   // uint32_t per change
+  uint32_t title_hash, pn_hash;  // uint32_t[hash_size]: 0 or entry+1
+  uint32_t facets;               // facet_header[nfacets]
+};
+
+// Each facet column is either uint32_t[count] string offsets, or for
+// peals, uint32_t[2*count] pairs of a packed date and a location.
+struct facet_header {
+  uint32_t kind;
+  uint32_t data;
+};
+
+enum facet_kind {
+  fk_payload, fk_cc_id, fk_rw_ref, fk_tower_peal, fk_hand_peal, fk_count
+};
+
+char const magic[8] = { 'R', 'N', 'G', 'B', 'L', 'I', 'B', '\0' };
+const uint32_t version = 2;
+const uint32_t byte_order_mark = 0x01020304u;
+
+// Marks a missing string
+const uint32_t absent = 0xFFFFFFFFu;
+
+bool is_peal_facet( uint32_t kind )
+{
+  return kind == fk_tower_peal || kind == fk_hand_peal;
+}
+
+// Changes are stored as a bitmask with bit i set if bells i and i+1 swap,
+// which limits the stage to 33 bells.
+const int max_bells = 33;
+
+uint32_t pack_change( change const& ch )
+{
+  uint32_t s = 0;
+  for ( int i = 0; i+1 < ch.bells(); ++i )
+    if ( ch.findswap(i) ) s |= uint32_t(1) << i;
+  return s;
+}
+
+change unpack_change( int bells, uint32_t s )
+{
+  change ch(bells);
+  for ( int i = 0; i+1 < bells; ++i )
+    if ( s & (uint32_t(1) << i) ) ch.swappair(i);
+  return ch;
+}
+
+// FNV-1a
+uint32_t hash_bytes( void const* p, size_t n, uint32_t h = 2166136261u )
+{
+  unsigned char const* c = static_cast<unsigned char const*>(p);
+  for ( size_t i = 0; i < n; ++i )
+    h = (h ^ c[i]) * 16777619u;
+  return h;
+}
+
+// The title hash ignores case, though find() requires an exact match.
+uint32_t title_key( string const& title )
+{
+  string t(title);
+  for ( string::iterator i=t.begin(), e=t.end(); i!=e; ++i )
+    *i = tolower(*i);
+  return hash_bytes( t.data(), t.size() );
+}
+
+uint32_t pn_key( uint32_t stage, uint32_t const* pn, size_t n )
+{
+  return hash_bytes( pn, n * sizeof(uint32_t),
+                     hash_bytes( &stage, sizeof(stage) ) );
+}
+
+void pack_method( method const& m, vector<uint32_t>& pn )
+{
+  for ( method::const_iterator i=m.begin(), e=m.end(); i!=e; ++i )
+    pn.push_back( pack_change(*i) );
+}
+
+uint32_t pack_date( peal::date const& d )
+{
+  return d.year * 10000 + d.month * 100 + d.day;
+}
+
+peal::date unpack_date( uint32_t d )
+{
+  return peal::date( d % 100, d / 100 % 100, d / 10000 );
+}
+
+RINGING_END_ANON_NAMESPACE
+
+class binlib::impl : public library_base {
+public:
+  class mapping;
+  class entry_type;
+
+  explicit impl( const string& filename );
+
+private:
+  virtual bool good() const;
+  virtual const_iterator begin() const;
+  virtual library_entry find( const method& pn ) const;
+  virtual library_entry find( const string& title ) const;
+  virtual bool indexed() const { return true; }
+
+  shared_pointer<mapping> file;
+};
+
+// The mapped file.  This is shared with the library entries so that 
+// they remain valid after the library has been destroyed.
+class binlib::impl::mapping {
+public:
+  explicit mapping( const string& filename );
+ ~mapping();
+
+  bool good() const { return hdr; }
+  uint32_t size() const { return hdr->count; }
+
+  string get_string( uint32_t col, uint32_t i ) const;
+  string name( uint32_t i ) const { return get_string( hdr->name, i ); }
+  string base_name( uint32_t i ) const
+    { return get_string( hdr->base_name, i ); }
+  string title( uint32_t i ) const { return get_string( hdr->title, i ); }
+  int bells( uint32_t i ) const { return bytes( hdr->stage )[i]; }
+  method meth( uint32_t i ) const;
+
+  bool same_method( uint32_t i, uint32_t stage,
+                    vector<uint32_t> const& pn ) const;
+
+  uint32_t const* title_hash() const { return words( hdr->title_hash ); }
+  uint32_t const* pn_hash() const { return words( hdr->pn_hash ); }
+  uint32_t hash_mask() const { return hdr->hash_size - 1; }
+
+  facet_header const* find_facet( uint32_t kind ) const;
+  string facet_string( facet_header const* f, uint32_t i ) const;
+  bool facet_peal( facet_header const* f, uint32_t i, peal& p ) const;
+
+private:
+  bool validate() const;
+  bool in_range( uint32_t off, uint32_t n, uint32_t sz ) const;
+
+  uint32_t const* words( uint32_t off ) const
+    { return reinterpret_cast<uint32_t const*>( data + off ); }
+  uint8_t const* bytes( uint32_t off ) const
+    { return reinterpret_cast<uint8_t const*>( data + off ); }
+
+  char const* data;
+  size_t len;
+  file_header const* hdr;
+
+#if RINGING_WINDOWS
+  vector<char> buffer;
+#endif
+};
+
+binlib::impl::mapping::mapping( const string& filename )
+  : data(NULL), len(0), hdr(NULL)
+{
+#if RINGING_WINDOWS
+  ifstream in( filename.c_str(), ios::in | ios::binary );
+  if (!in) return;
+  in.seekg( 0, ios::end );
+  buffer.resize( in.tellg() );
+  in.seekg( 0, ios::beg );
+  if ( buffer.empty() || !in.read( &buffer[0], buffer.size() ) ) return;
+  data = &buffer[0]; len = buffer.size();
+#else
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) return;
+
+  struct stat st;
+  if ( fstat( fd, &st ) == 0 && st.st_size > 0 ) {
+    void* p = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    if ( p != MAP_FAILED ) {
+      data = static_cast<char const*>(p);
+      len = st.st_size;
+    }
+  }
+  close(fd);
+  if (!data) return;
+#endif
+
+  if ( len >= sizeof(file_header) ) {
+    hdr = reinterpret_cast<file_header const*>(data);
+    if ( !validate() ) hdr = NULL;
+  }
+}
+
+binlib::impl::mapping::~mapping()
+{
+#if !RINGING_WINDOWS
+  if (data) munmap( const_cast<char*>(data), len );
+#endif
+}
+
+bool binlib::impl::mapping::in_range( uint32_t off, uint32_t n,
+                                      uint32_t sz ) const
+{
+  return off % 4 == 0 && off <= len && n <= (len - off) / sz;
+}
+
+bool binlib::impl::mapping::validate() const
+{
+  if ( memcmp( hdr->magic, magic, sizeof(magic) ) != 0
+       || hdr->version != version || hdr->byte_order != byte_order_mark )
+    return false;
+
+  uint32_t n = hdr->count;
+  if ( !in_range( hdr->strings, hdr->strings_size, 1 )
+       || !in_range( hdr->name, n, 4 ) || !in_range( hdr->base_name, n, 4 )
+       || !in_range( hdr->title, n, 4 ) || !in_range( hdr->stage, n, 1 )
+       || !in_range( hdr->pn_index, n+1, 4 )
+       || hdr->hash_size == 0 || ( hdr->hash_size & (hdr->hash_size-1) )
+       || !in_range( hdr->title_hash, hdr->hash_size, 4 )
+       || !in_range( hdr->pn_hash, hdr->hash_size, 4 )
+       || !in_range( hdr->facets, hdr->nfacets, sizeof(facet_header) ) )
+    return false;
+
+  // Strings must be terminated so we can use them in place.
+  if ( hdr->strings_size && data[ hdr->strings + hdr->strings_size - 1 ] )
+    return false;
+
+  uint8_t const* st = bytes( hdr->stage );
+  for ( uint32_t i = 0; i < n; ++i )
+    if ( st[i] > max_bells ) return false;
+
+  uint32_t const* idx = words( hdr->pn_index );
+  for ( uint32_t i = 0; i < n; ++i )
+    if ( idx[i] > idx[i+1] ) return false;
+  if ( idx[0] != 0 || !in_range( hdr->pn, idx[n], 4 ) )
+    return false;
+
+  facet_header const* f
+    = reinterpret_cast<facet_header const*>( data + hdr->facets );
+  for ( uint32_t i = 0; i < hdr->nfacets; ++i )
+    if ( !in_range( f[i].data, is_peal_facet(f[i].kind) ? 2*n : n, 4 ) )
+      return false;
+
+  return true;
+}
+
+string binlib::impl::mapping::get_string( uint32_t col, uint32_t i ) const
+{
+  uint32_t off = words(col)[i];
+  if ( off == absent || off >= hdr->strings_size ) return string();
+  return string( data + hdr->strings + off );
+}
+
+method binlib::impl::mapping::meth( uint32_t i ) const
+{
+  int b = bells(i);
+  string n( base_name(i) );
+  method m( 0, b, n.c_str() );
+  uint32_t const* idx = words( hdr->pn_index );
+  uint32_t const* pn = words( hdr->pn );
+  m.reserve( idx[i+1] - idx[i] );
+  for ( uint32_t j = idx[i]; j < idx[i+1]; ++j )
+    m.push_back( unpack_change( b, pn[j] ) );
+  return m;
+}
+
+bool binlib::impl::mapping::same_method( uint32_t i, uint32_t stage,
+                                         vector<uint32_t> const& pn ) const
+{
+  uint32_t const* idx = words( hdr->pn_index );
+  return bytes( hdr->stage )[i] == stage
+    && idx[i+1] - idx[i] == pn.size()
+    && ( pn.empty() || memcmp( words( hdr->pn ) + idx[i], &pn[0],
+                               pn.size() * sizeof(uint32_t) ) == 0 );
+}
+
+facet_header const* binlib::impl::mapping::find_facet( uint32_t kind ) const
+{
+  facet_header const* f
+    = reinterpret_cast<facet_header const*>( data + hdr->facets );
+  for ( uint32_t i = 0; i < hdr->nfacets; ++i )
+    if ( f[i].kind == kind ) return f+i;
+  return NULL;
+}
+
+string binlib::impl::mapping::facet_string( facet_header const* f,
+                                            uint32_t i ) const
+{
+  return get_string( f->data, i );
+}
+
+bool binlib::impl::mapping::facet_peal( facet_header const* f, uint32_t i,
+                                        peal& p ) const
+{
+  uint32_t const* d = words( f->data ) + 2*i;
+  if ( d[0] == 0 && d[1] == absent ) return false;
+  p = peal( unpack_date( d[0] ), get_string( f->data, 2*i+1 ) );
+  return true;
+}
+
+class binlib::impl::entry_type : public library_entry::impl
+{
+public:
+  explicit entry_type( shared_pointer<mapping> const& file,
+                       uint32_t i = absent )
+    : file(file), i(i) {}
+
+private:
+  virtual string name() const { return file->name(i); }
+  virtual string base_name() const { return file->base_name(i); }
+  virtual string pn() const
+    { return meth().format( method::M_SYMMETRY | method::M_DASH ); }
+  virtual int bells() const { return file->bells(i); }
+  virtual method meth() const { return file->meth(i); }
+
+  virtual bool readentry( library_base &lb );
+  virtual library_entry::impl *clone() const { return new entry_type(*this); }
+
+  virtual bool has_facet( const library_facet_id& id ) const;
+  virtual shared_pointer< library_facet_base >
+    get_facet( const library_facet_id& id ) const;
+
+  static uint32_t facet_kind( const library_facet_id& id );
+
+  shared_pointer<mapping> file;
+  uint32_t i;
+};
+
+bool binlib::impl::entry_type::readentry( library_base &lb )
+{
+  i = ( i == absent ? 0 : i+1 );
+  return i < file->size();
+}
+
+uint32_t binlib::impl::entry_type::facet_kind( const library_facet_id& id )
+{
+  if ( id == litelib::payload::id )     return fk_payload;
+  if ( id == cc_collection_id::id )     return fk_cc_id;
+  if ( id == rw_ref::id )               return fk_rw_ref;
+  if ( id == first_tower_peal::id )     return fk_tower_peal;
+  if ( id == first_hand_peal::id )      return fk_hand_peal;
+  return absent;
+}
+
+bool binlib::impl::entry_type::has_facet( const library_facet_id& id ) const
+{
+  facet_header const* f = file->find_facet( facet_kind(id) );
+  if ( !f ) return false;
+
+  peal p;
+  if ( is_peal_facet( f->kind ) )
+    return file->facet_peal( f, i, p );
+  else
+    return file->facet_string( f, i ).size();
+}
+
+shared_pointer< library_facet_base >
+binlib::impl::entry_type::get_facet( const library_facet_id& id ) const
+{
+  shared_pointer< library_facet_base > result;
+
+  facet_header const* f = file->find_facet( facet_kind(id) );
+  if ( !f ) return result;
+
+  peal p;
+  if ( is_peal_facet( f->kind ) ) {
+    if ( file->facet_peal( f, i, p ) ) {
+      if ( f->kind == fk_tower_peal ) result.reset( new first_tower_peal(p) );
+      else result.reset( new first_hand_peal(p) );
+    }
+  }
+  else {
+    string s( file->facet_string( f, i ) );
+    if ( s.size() ) switch ( f->kind ) {
+      case fk_payload: result.reset( new litelib::payload(s) );  break;
+      case fk_cc_id:   result.reset( new cc_collection_id(s) );  break;
+      case fk_rw_ref:  result.reset( new rw_ref(s) );            break;
+    }
+  }
+
+  return result;
+}
+
+binlib::impl::impl( const string& filename )
+  : file( new mapping(filename) )
+{
+}
+
+bool binlib::impl::good() const
+{
+  return file->good();
+}
+
+library_base::const_iterator binlib::impl::begin() const
+{
+  if ( !good() ) return end();
+  return const_iterator( const_cast<binlib::impl*>(this),
+                         new entry_type(file) );
+}
+
+library_entry binlib::impl::find( const method& m ) const
+{
+  if ( !good() || m.bells() > max_bells ) return library_entry();
+
+  vector<uint32_t> pn;  pack_method( m, pn );
+  uint32_t stage = m.bells();
+  uint32_t const* table = file->pn_hash();
+  uint32_t s = pn_key( stage, pn.empty() ? NULL : &pn[0], pn.size() );
+  for ( uint32_t n = 0; n <= file->hash_mask(); ++n, ++s ) {
+    uint32_t i = table[ s & file->hash_mask() ];
+    if ( i == 0 || i > file->size() ) break;
+    if ( file->same_method( i-1, stage, pn ) )
+      return library_entry( new entry_type( file, i-1 ) );
+  }
+
+  return library_entry();
+}
+
+library_entry binlib::impl::find( const string& title ) const
+{
+  if ( !good() ) return library_entry();
+
+  uint32_t const* table = file->title_hash();
+  uint32_t s = title_key( title );
+  for ( uint32_t n = 0; n <= file->hash_mask(); ++n, ++s ) {
+    uint32_t i = table[ s & file->hash_mask() ];
+    if ( i == 0 || i > file->size() ) break;
+    if ( file->title( i-1 ) == title )
+      return library_entry( new entry_type( file, i-1 ) );
+  }
+
+  return library_entry();
+}
+
+binlib::binlib( const string& filename )
+  : library( new impl(filename) )
+{
+}
+
+library_base *binlib::canread( const string& filename )
+{
+  scoped_pointer<library_base> ptr( new impl(filename) );
+  if ( ptr->good() )
+    return ptr.release();
+  else
+    return NULL;
+}
+
+// ---------------------------------------------------------------------
+
+class binout::impl : public libout::interface {
+public:
+  explicit impl( const string& filename );
+ ~impl();
+
+  virtual void append( library_entry const& entry );
+  virtual void flush();
+
+private:
+  uint32_t add_string( string const& s );
+  template <class Facet>
+  void add_string_facet( library_entry const& entry, facet_kind k );
+  template <class Facet>
+  void add_peal_facet( library_entry const& entry, facet_kind k );
+
+  static void build_hash( vector<uint32_t>& table,
+                          vector<uint32_t> const& keys );
+
+  string filename;
+  bool dirty;
+
+  // The string table, with duplicates shared
+  string strings;
+  RINGING_PREFIX_STD map<string, uint32_t> string_offsets;
+
+  vector<uint32_t> names, base_names, titles;
+  vector<uint8_t> stages;
+  vector<uint32_t> pn_index, pn;
+  vector<uint32_t> title_keys, pn_keys;
+
+  // Columns are only written if at least one method has the facet
+  vector<uint32_t> facets[fk_count];
+  bool have_facet[fk_count];
+};
+
+binout::impl::impl( const string& filename )
+  : filename(filename), dirty(false)
+{
+  pn_index.push_back(0);
+  for ( int k = 0; k < fk_count; ++k ) have_facet[k] = false;
+}
+
+binout::impl::~impl()
+{
+  try {
+    if (dirty) flush();
+  } catch (...) {}
+}
+
+uint32_t binout::impl::add_string( string const& s )
+{
+  RINGING_PREFIX_STD map<string, uint32_t>::const_iterator
+    i = string_offsets.find(s);
+  if ( i != string_offsets.end() ) return i->second;
+
+  uint32_t off = strings.size();
+  strings.append( s.c_str(), s.size() + 1 );
+  string_offsets[s] = off;
+  return off;
+}
+
+template <class Facet>
+void binout::impl::add_string_facet( library_entry const& entry, 
+                                     facet_kind k )
+{
+  shared_pointer< library_facet_base > f( entry.get_facet( Facet::id ) );
+  string s;
+  if (f) {
+    s = static_cast<Facet const&>(*f);
+    have_facet[k] = true;
+  }
+  facets[k].push_back( s.size() ? add_string(s) : absent );
+}
+
+template <class Facet>
+void binout::impl::add_peal_facet( library_entry const& entry, facet_kind k )
+{
+  shared_pointer< library_facet_base > f( entry.get_facet( Facet::id ) );
+  if (f) {
+    peal const& p = static_cast<Facet const&>(*f);
+    facets[k].push_back( pack_date( p.when() ) );
+    facets[k].push_back( p.where().size() ? add_string( p.where() ) : absent );
+    have_facet[k] = true;
+  }
+  else {
+    facets[k].push_back( 0 );
+    facets[k].push_back( absent );
+  }
+}
+
+void binout::impl::append( library_entry const& entry )
+{
+  method m( entry.meth() );
+  string title( m.fullname() );
+
+  if ( m.bells() > max_bells )
+    throw runtime_error( make_string() << title << " has more than "
+                           << max_bells << " bells, the most a binary "
+                           "library can store" );
+
+  dirty = true;
+  names.push_back( add_string( entry.name() ) );
+  base_names.push_back( add_string( entry.base_name() ) );
+  titles.push_back( add_string( title ) );
+  stages.push_back( m.bells() );
+
+  size_t start = pn.size();
+  pack_method( m, pn );
+  pn_index.push_back( pn.size() );
+
+  title_keys.push_back( title_key( title ) );
+  pn_keys.push_back( pn_key( m.bells(), pn.empty() ? NULL : &pn[start],
+                             pn.size() - start ) );
+
+  add_string_facet<litelib::payload>( entry, fk_payload );
+  add_string_facet<cc_collection_id>( entry, fk_cc_id );
+  add_string_facet<rw_ref>( entry, fk_rw_ref );
+  add_peal_facet<first_tower_peal>( entry, fk_tower_peal );
+  add_peal_facet<first_hand_peal>( entry, fk_hand_peal );
+}
+
+void binout::impl::build_hash( vector<uint32_t>& table,
+                               vector<uint32_t> const& keys )
+{
+  // Linear probing; entries are stored as index+1 so that 0 is empty.
+  uint32_t mask = table.size() - 1;
+  for ( uint32_t i = 0; i < keys.size(); ++i ) {
+    uint32_t s = keys[i];
+    while ( table[ s & mask ] ) ++s;
+    table[ s & mask ] = i+1;
+  }
+}
+
+void binout::impl::flush()
+{
+  uint32_t n = stages.size();
+
+  // Keep the load factor below a half
+  uint32_t hash_size = 2;
+  while ( hash_size < 2*n ) hash_size *= 2;
+
+  vector<uint32_t> title_hash( hash_size ), pn_hash( hash_size );
+  build_hash( title_hash, title_keys );
+  build_hash( pn_hash, pn_keys );
+
+  vector<facet_header> facet_hdrs;
+  for ( int k = 0; k < fk_count; ++k )
+    if ( have_facet[k] ) {
+      facet_header fh = { uint32_t(k), 0 };
+      facet_hdrs.push_back(fh);
+    }
+
+  // Lay out the file
+  file_header hdr;
+  memset( &hdr, 0, sizeof(hdr) );
+  memcpy( hdr.magic, magic, sizeof(magic) );
+  hdr.version = version;
+  hdr.byte_order = byte_order_mark;
+  hdr.count = n;
+  hdr.hash_size = hash_size;
+  hdr.nfacets = facet_hdrs.size();
+
+  uint32_t off = sizeof(hdr);
+#define RINGING_BINLIB_SECTION( field, bytes ) \
+  hdr.field = off; off += ( (bytes) + 3 ) & ~3u
+
+  RINGING_BINLIB_SECTION( facets, facet_hdrs.size() * sizeof(facet_header) );
+  RINGING_BINLIB_SECTION( name, 4*n );
+  RINGING_BINLIB_SECTION( base_name, 4*n );
+  RINGING_BINLIB_SECTION( title, 4*n );
+  RINGING_BINLIB_SECTION( stage, n );
+  RINGING_BINLIB_SECTION( pn_index, 4*(n+1) );
+  RINGING_BINLIB_SECTION( pn, 4*pn.size() );
+  RINGING_BINLIB_SECTION( title_hash, 4*hash_size );
+  RINGING_BINLIB_SECTION( pn_hash, 4*hash_size );
+  for ( vector<facet_header>::iterator i = facet_hdrs.begin(),
+          e = facet_hdrs.end(); i != e; ++i ) {
+    i->data = off;
+    off += 4 * facets[i->kind].size();
+  }
+  RINGING_BINLIB_SECTION( strings, strings.size() );
+  hdr.strings_size = strings.size();
+#undef RINGING_BINLIB_SECTION
+
+  ofstream out( filename.c_str(), ios::out | ios::binary | ios::trunc );
+  if (!out)
+    throw runtime_error( "Unable to open " + filename + " for writing" );
+
+  char const zeros[4] = { 0, 0, 0, 0 };
+#define RINGING_BINLIB_WRITE( ptr, bytes )                              \
+  do {                                                                  \
+    size_t sz = (bytes);                                                \
+    if (sz) out.write( reinterpret_cast<char const*>(ptr), sz );        \
+    out.write( zeros, (4 - sz % 4) % 4 );                               \
+  } while (false)
+#define RINGING_BINLIB_WRITE_VEC( v ) \
+  RINGING_BINLIB_WRITE( v.empty() ? NULL : &v[0], v.size() * sizeof(v[0]) )
+
+  RINGING_BINLIB_WRITE( &hdr, sizeof(hdr) );
+  RINGING_BINLIB_WRITE_VEC( facet_hdrs );
+  RINGING_BINLIB_WRITE_VEC( names );
+  RINGING_BINLIB_WRITE_VEC( base_names );
+  RINGING_BINLIB_WRITE_VEC( titles );
+  RINGING_BINLIB_WRITE_VEC( stages );
+  RINGING_BINLIB_WRITE_VEC( pn_index );
+  RINGING_BINLIB_WRITE_VEC( pn );
+  RINGING_BINLIB_WRITE_VEC( title_hash );
+  RINGING_BINLIB_WRITE_VEC( pn_hash );
+  for ( vector<facet_header>::const_iterator i = facet_hdrs.begin(),
+          e = facet_hdrs.end(); i != e; ++i )
+    RINGING_BINLIB_WRITE_VEC( facets[i->kind] );
+  RINGING_BINLIB_WRITE( strings.data(), strings.size() );
+#undef RINGING_BINLIB_WRITE_VEC
+#undef RINGING_BINLIB_WRITE
+
+  out.close();
+  if (!out)
+    throw runtime_error( "Error writing " + filename );
+  dirty = false;
+}
+
+binout::binout( const string& filename )
+  : libout( new impl(filename) )
+{
+}
+
+RINGING_END_NAMESPACE
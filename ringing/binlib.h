@@ -0,0 +1,80 @@
+// -*- C++ -*- binlib.h - A compact binary method library format
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#ifndef RINGING_BINLIB_H
+#define RINGING_BINLIB_H
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+
+#include <ringing/library.h>
+#include <ringing/libout.h>
+#include <string>
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+// binlib : A binary method library designed to be memory-mapped rather
+// than parsed.  Data is stored in columns (names, stages, place
+// notation and a few common facets), together with hash tables on the
+// full title and on the place notation so that find() does not need to
+// look at every entry.  The file is written in the native byte order,
+// and is not portable between machines with a different one.  Methods
+// on more than 33 bells cannot be stored.
+// Use binout to create one from any other library.
+class RINGING_API binlib : public library
+{
+public:
+  binlib() {}
+  explicit binlib( const string& filename );
+
+  static void registerlib(void) {
+    library::addtype(&canread);
+  }
+
+private:
+  // Is this file in the right format?
+  static library_base *canread(const string& filename);
+
+  class impl;
+};
+
+// binout : Write a binlib.  The file is written when the output is
+// flushed or destroyed.  The payload, cc_collection_id, rw_ref and
+// first peal facets are copied if present.
+class RINGING_API binout : public libout
+{
+public:
+  explicit binout( const string& filename );
+
+private:
+  class impl;
+};
+
+RINGING_END_NAMESPACE
+
+#endif // RINGING_BINLIB_H
@@ -32,18 +32,23 @@
 #else
 #include <algorithm>
 #include <fstream>
+#include <map>
 #endif
 #if RINGING_OLD_C_INCLUDES
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <ctype.h>
 #else
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <cassert>
 #include <cctype>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <ringing/method.h>
 #include <ringing/pointers.h>
 #include <ringing/peal.h>
@@ -59,6 +64,19 @@ class cclib::impl : public library_base {
 private:
   ifstream f;                   // The file stream we're using
   int _good;                    // If we have a good filename or not.
+  string filename;              // Used to locate the index file
+
+  // The sidecar index maps normalised titles and canonical place notation
+  // to the file offsets needed to re-read a single entry.  It is loaded
+  // (or built) on the first call to find().
+  struct index_entry {
+    streamoff title, header, line;
+  };
+  typedef multimap<string, index_entry> index_map;
+
+  mutable bool have_index;
+  mutable index_map titles, pns;
+  mutable ifstream seek_f;      // Separate stream so as not to disturb f
 
 public:
   // Is this file in the right format?
@@ -77,6 +95,21 @@ private:
 
   // Is the library in a usable state?
   virtual bool good(void) const { return _good; }
+
+  // Indexed lookups
+  virtual library_entry find(const method& pn) const;
+  virtual library_entry find(const string& title) const;
+  virtual bool indexed() const { return true; }
+
+  // Index handling
+  void load_index() const;
+  bool read_index( const string& idxname, off_t size, time_t mtime ) const;
+  void build_index() const;
+  void write_index( const string& idxname, off_t size, time_t mtime ) const;
+  library_entry read_at( const index_entry& e ) const;
+
+  static string normalise_title( const string& title );
+  static string canonical_pn( const method& m );
 };
 
 void cclib::registerlib(void) 
@@ -115,6 +148,11 @@ class cclib::impl::entry_type : public library_entry::impl
   virtual bool readentry( library_base &lb );
   virtual library_entry::impl *clone() const { return new entry_type(*this); }
 
+  bool readentry( istream &ifs );
+  bool read_at( istream &ifs, const cclib::impl::index_entry& e );
+
+  // Offsets of the current table title, table header and entry
+  streamoff title_pos, header_pos, line_pos;
 
   // The current line
   string linebuf;
@@ -164,7 +202,10 @@ library_base::const_iterator cclib::impl::begin() const
 }
  
 cclib::impl::entry_type::entry_type()
-  : meth_name_starts( string::npos ),
+  : title_pos       ( -1           ),
+    header_pos      ( -1           ),
+    line_pos        ( -1           ),
+    meth_name_starts( string::npos ),
     meth_name_ends  ( string::npos ),
     meth_hl         ( string::npos ),
     meth_le         ( string::npos ),
@@ -188,18 +229,23 @@ cclib::impl::entry_type::entry_type()
 
 bool cclib::impl::entry_type::readentry( library_base &lb )
 {
-  ifstream &ifs = dynamic_cast<cclib::impl&>(lb).f;
+  return readentry( dynamic_cast<cclib::impl&>(lb).f );
+}
 
+bool cclib::impl::entry_type::readentry( istream &ifs )
+{
   // Go through a line at a time.
   while ( ifs )
     {
       wrapped_name = "";
+      streamoff pos = ifs.tellg();
       getline( ifs, linebuf );
       
       // The second check for No. is used as an extra insurance check...
       if ( linebuf.find("Name") != string::npos
 	   && linebuf.find("No.") != string::npos )
 	{
+	  header_pos = pos;
 	  parse_header();
 	}
       else if (meth_name_starts != meth_name_ends
@@ -211,6 +257,7 @@ bool cclib::impl::entry_type::readentry( library_base &lb )
 	       && atoi( string(linebuf, 0, meth_name_starts).c_str() ) )
 	{
 	  bool is_wrapped(true);
+	  line_pos = pos;
 	  
 	  {
 
@@ -234,12 +281,32 @@ bool cclib::impl::entry_type::readentry( library_base &lb )
 		linebuf.find( "differentials" ) != string::npos ||
 		linebuf.find( "blocks" ) != string::npos )
 	{
+	  title_pos = pos;
 	  parse_title();
 	}
     }
   return bool(ifs);
 }
 
+bool cclib::impl::entry_type::read_at( istream &ifs, 
+                                       const cclib::impl::index_entry& e )
+{
+  // Re-establish the table title and header before reading the entry
+  ifs.clear();
+  ifs.seekg( e.title );
+  if ( !getline( ifs, linebuf ) ) return false;
+  title_pos = e.title;
+  parse_title();
+
+  ifs.seekg( e.header );
+  if ( !getline( ifs, linebuf ) ) return false;
+  header_pos = e.header;
+  parse_header();
+
+  ifs.seekg( e.line );
+  return readentry( ifs ) && line_pos == e.line;
+}
+
 void cclib::impl::entry_type::parse_title()
 {
   // True if it's a method, false if it's a principle
@@ -498,6 +565,10 @@ string cclib::impl::entry_type::base_name() const
   if(block)
     maybe_strip_class( newname, "Block" );
 
+  // name() adds the class of the table, which method::fullname adds again
+  if(main_class)
+    maybe_strip_class( newname, method::classname( main_class ) );
+
   if(plain)
     maybe_strip_class( newname, method::classname( method::M_BOB ) ) ||
       maybe_strip_class( newname, method::classname( method::M_PLACE ) ) ||
@@ -573,7 +644,7 @@ string cclib::impl::entry_type::pn() const
 // ---------------------------------------------------------------------
 
 cclib::impl::impl(const string& filename)
-  : f(filename.c_str()), _good(0)
+  : f(filename.c_str()), _good(0), filename(filename), have_index(false)
 {
   if(f.good()) {
     string s;
@@ -584,6 +655,192 @@ cclib::impl::impl(const string& filename)
   }
 }
 
+// ---------------------------------------------------------------------
+// The sidecar index.  
+//
+// This is a text file stored alongside the library with an ".idx" suffix.
+// The first line identifies the format, and the second gives the size
+// and modification time of the library when the index was built.  Each
+// subsequent line describes one entry with the offsets of its table
+// title, table header and entry line, followed by the normalised title
+// and canonical place notation, tab separated.  If the library changes,
+// or the index cannot be read, it is rebuilt; if the index cannot be 
+// written, it is only kept in memory.
+
+RINGING_START_ANON_NAMESPACE
+char const* const index_magic = "ringing-lib cclib index 1";
+RINGING_END_ANON_NAMESPACE
+
+string cclib::impl::normalise_title( const string& title )
+{
+  string n(title);
+  for ( string::iterator i=n.begin(), e=n.end(); i!=e; ++i )
+    *i = tolower(*i);
+  return n;
+}
+
+string cclib::impl::canonical_pn( const method& m )
+{
+  // All changes in full, so that equal methods give equal strings
+  string key( method::stagename( m.bells() ) );
+  key += ':';
+  key += m.format( method::M_DASH | method::M_EXTERNAL );
+  return key;
+}
+
+void cclib::impl::load_index() const
+{
+  if (have_index) return;
+  have_index = true;
+
+  struct stat st;
+  if ( stat( filename.c_str(), &st ) != 0 ) {
+    build_index();
+    return;
+  }
+
+  string idxname( filename + ".idx" );
+  if ( !read_index( idxname, st.st_size, st.st_mtime ) ) {
+    build_index();
+    write_index( idxname, st.st_size, st.st_mtime );
+  }
+}
+
+bool cclib::impl::read_index( const string& idxname, 
+                              off_t size, time_t mtime ) const
+{
+  ifstream in( idxname.c_str() );
+  string line;
+  if ( !getline( in, line ) || line != index_magic ) 
+    return false;
+
+  RINGING_LLONG isize, imtime;
+  if ( !( in >> isize >> imtime ) || isize != size || imtime != mtime )
+    return false;
+  getline( in, line );
+
+  while ( getline( in, line ) ) {
+    string::size_type t1 = line.find('\t'), t2 = line.find('\t', t1+1);
+    if ( t1 == string::npos || t2 == string::npos ) {
+      titles.clear(); pns.clear();
+      return false;
+    }
+
+    index_entry e;
+    char* end = const_cast<char*>( line.c_str() );
+    e.title  = strtol( end, &end, 10 );
+    e.header = strtol( end, &end, 10 );
+    e.line   = strtol( end, &end, 10 );
+
+    titles.insert( make_pair( line.substr(t1+1, t2-t1-1), e ) );
+    if ( t2+1 < line.size() )
+      pns.insert( make_pair( line.substr(t2+1), e ) );
+  }
+
+  return true;
+}
+
+void cclib::impl::build_index() const
+{
+  titles.clear(); pns.clear();
+  if (!_good) return;
+
+  ifstream in( filename.c_str() );
+  entry_type ent;
+  while ( ent.readentry(in) ) {
+    index_entry e;
+    e.title = ent.title_pos; e.header = ent.header_pos; e.line = ent.line_pos;
+
+    // Entries that don't parse can still be found by title; but as the
+    // full title depends on the method's classification, we only index 
+    // names we can calculate.
+    try {
+      method m( ent.meth() );
+      titles.insert( make_pair( normalise_title( m.fullname() ), e ) );
+      pns.insert( make_pair( canonical_pn(m), e ) );
+    }
+    catch ( const exception& ) {}
+  }
+}
+
+void cclib::impl::write_index( const string& idxname, 
+                               off_t size, time_t mtime ) const
+{
+  // Invert the title map so that each entry is written once, in order
+  map< streamoff, pair<string, string> > entries;
+  map< streamoff, index_entry > offsets;
+  for ( index_map::const_iterator i=titles.begin(), e=titles.end(); 
+        i!=e; ++i ) {
+    entries[i->second.line].first = i->first;
+    offsets[i->second.line] = i->second;
+  }
+  for ( index_map::const_iterator i=pns.begin(), e=pns.end(); i!=e; ++i )
+    entries[i->second.line].second = i->first;
+
+  ofstream out( idxname.c_str() );
+  if (!out) return;
+
+  out << index_magic << "\n" 
+      << static_cast<RINGING_LLONG>(size) << ' ' 
+      << static_cast<RINGING_LLONG>(mtime) << "\n";
+  for ( map< streamoff, pair<string, string> >::const_iterator 
+          i=entries.begin(), e=entries.end(); i!=e; ++i ) {
+    index_entry const& ie = offsets[i->first];
+    out << static_cast<RINGING_LLONG>(ie.title) << ' ' 
+        << static_cast<RINGING_LLONG>(ie.header) << ' '
+        << static_cast<RINGING_LLONG>(ie.line) << '\t' 
+        << i->second.first << '\t' 
+        << i->second.second << '\n';
+  }
+
+  // Don't leave a truncated index around
+  out.close();
+  if (!out) remove( idxname.c_str() );
+}
+
+library_entry cclib::impl::read_at( const index_entry& e ) const
+{
+  if ( !seek_f.is_open() ) 
+    seek_f.open( filename.c_str() );
+
+  entry_type* ent = new entry_type;
+  library_entry le( ent );
+  if ( !ent->read_at( seek_f, e ) )
+    return library_entry();
+  return le;
+}
+
+library_entry cclib::impl::find( const method& pn ) const
+{
+  load_index();
+
+  pair< index_map::const_iterator, index_map::const_iterator > 
+    r = pns.equal_range( canonical_pn(pn) );
+  for ( ; r.first != r.second; ++r.first ) {
+    library_entry le( read_at( r.first->second ) );
+    if ( !le.null() && le.meth() == pn ) 
+      return le;
+  }
+  return library_entry();
+}
+
+library_entry cclib::impl::find( const string& title ) const
+{
+  load_index();
+
+  // Several titles may differ only in case, so check the exact title
+  pair< index_map::const_iterator, index_map::const_iterator > 
+    r = titles.equal_range( normalise_title(title) );
+  for ( ; r.first != r.second; ++r.first ) {
+    library_entry le( read_at( r.first->second ) );
+    if ( !le.null() && le.fullname() == title ) 
+      return le;
+  }
+  return library_entry();
+}
+
+// ---------------------------------------------------------------------
+
 // Is this file in the right format?
 library_base *cclib::impl::canread(const string& filename)
 {
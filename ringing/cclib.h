@@ -38,6 +38,10 @@ RINGING_START_NAMESPACE
 RINGING_USING_STD
 
 // cclib : Implement Central Council Method libraries
+//
+// Lookups with find() use an index stored alongside the library with an
+// ".idx" suffix.  This is built the first time it is needed, and rebuilt
+// whenever the size or modification time of the library changes.
 class RINGING_API cclib : public library {
 public:
   // cclib::ref is (effectively) the line number in the current version
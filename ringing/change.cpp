@@ -227,6 +227,16 @@ vector<bell> change::places() const {
   return pl;
 } 
 
+size_t change::hash() const
+{
+  // The same FNV variant as row::hash
+  size_t h = n;
+  for ( vector<bell>::const_iterator i=swaps.begin(), e=swaps.end(); 
+        i != e; ++i )
+    h = 31*h + *i;
+  return h;
+}
+
 // Return whether it's odd or even
 int change::sign(void) const {
   if(n == 0) return 1;
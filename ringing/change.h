@@ -87,6 +87,7 @@ public:
   bool internal() const;               // Does it contain internal places?
   int count_places() const;            // Count the number of places made
   vector<bell> places() const;         // Return the places made
+  size_t hash() const;                 // Hash consistent with operator==
 
   // So that we can put changes into containers
   bool operator<(const change& c) const {
@@ -139,5 +140,6 @@ RINGING_END_NAMESPACE
 
 // specialise std::swap
 RINGING_DELEGATE_STD_SWAP( change )
+RINGING_DELEGATE_STD_HASH( change )
 
 #endif
@@ -92,4 +92,7 @@
 // *** Define this to be 1 if you have long long
 #define RINGING_HAVE_LONG_LONG 1
 
+// *** Define this to be 1 if you have std::thread
+#define RINGING_USE_THREADS 1
+
 #endif // RINGING_COMMON_MSVC_H
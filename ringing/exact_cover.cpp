@@ -0,0 +1,194 @@
+// -*- C++ -*- exact_cover.cpp - Solve exact cover problems
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+
+#include <ringing/exact_cover.h>
+#if RINGING_OLD_INCLUDES
+#include <stdexcept.h>
+#else
+#include <stdexcept>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+exact_cover::exact_cover( size_t primary, size_t secondary )
+  : primary(primary), nopts(0),
+    nodes_v( primary + secondary + 2 ),
+    llink( primary + secondary + 1 ), rlink( primary + secondary + 1 ),
+    len( primary + secondary + 1 ), out(0), nodes(0)
+{
+  size_t const n = primary + secondary;
+
+  // The primary items are in a circular list with the root, 0.  The
+  // secondary items are never chosen, so each is in a list of its own.
+  for ( size_t i = 0; i <= n; ++i ) {
+    llink[i] = i <= primary ? ( i ? i-1 : primary ) : i;
+    rlink[i] = i <= primary ? ( i < primary ? i+1 : 0 ) : i;
+    nodes_v[i].top = 0;
+    nodes_v[i].up = nodes_v[i].down = i;
+  }
+
+  last_spacer = n + 1;
+  nodes_v[last_spacer].top = 0;
+  nodes_v[last_spacer].up = nodes_v[last_spacer].down = 0;
+}
+
+size_t exact_cover::add_option( size_t const* first, size_t const* last )
+{
+  if ( first == last )
+    throw runtime_error( "An option must contain at least one item" );
+
+  size_t const start = nodes_v.size(), n = llink.size() - 1;
+  for ( ; first != last; ++first ) {
+    if ( *first >= n )
+      throw runtime_error( "Item out of range in exact cover option" );
+
+    size_t const i = *first + 1, x = nodes_v.size();
+    node nd = { long(i), nodes_v[i].up, i };
+    nodes_v.push_back(nd);
+    nodes_v[ nodes_v[i].up ].down = x;
+    nodes_v[i].up = x;
+    ++len[i];
+  }
+
+  nodes_v[last_spacer].down = nodes_v.size() - 1;
+  last_spacer = nodes_v.size();
+  node spacer = { -long(nopts+1), start, 0 };
+  nodes_v.push_back(spacer);
+
+  return nopts++;
+}
+
+// Chooses the primary item with the fewest options, or the first of
+// them if there are several
+inline void exact_cover::choose( size_t& best ) const
+{
+  best = rlink[0];
+  for ( size_t i = rlink[best]; i != 0 && len[best]; i = rlink[i] )
+    if ( len[i] < len[best] ) best = i;
+}
+
+// Removes the other nodes of the option containing P from their items
+inline void exact_cover::hide( size_t p )
+{
+  for ( size_t q = p+1; q != p; ) {
+    node const& nd = nodes_v[q];
+    if ( nd.top <= 0 )
+      q = nd.up;
+    else {
+      nodes_v[nd.up].down = nd.down;
+      nodes_v[nd.down].up = nd.up;
+      --len[nd.top];
+      ++q;
+    }
+  }
+}
+
+inline void exact_cover::unhide( size_t p )
+{
+  for ( size_t q = p-1; q != p; ) {
+    node const& nd = nodes_v[q];
+    if ( nd.top <= 0 )
+      q = nd.down;
+    else {
+      nodes_v[nd.up].down = q;
+      nodes_v[nd.down].up = q;
+      ++len[nd.top];
+      --q;
+    }
+  }
+}
+
+void exact_cover::cover( size_t i )
+{
+  for ( size_t p = nodes_v[i].down; p != i; p = nodes_v[p].down )
+    hide(p);
+  rlink[ llink[i] ] = rlink[i];
+  llink[ rlink[i] ] = llink[i];
+}
+
+void exact_cover::uncover( size_t i )
+{
+  rlink[ llink[i] ] = i;
+  llink[ rlink[i] ] = i;
+  for ( size_t p = nodes_v[i].up; p != i; p = nodes_v[p].up )
+    unhide(p);
+}
+
+size_t exact_cover::option_of( size_t x ) const
+{
+  while ( nodes_v[x].top > 0 ) ++x;
+  return size_t( -nodes_v[x].top ) - 1;
+}
+
+bool exact_cover::search()
+{
+  ++nodes;
+
+  if ( rlink[0] == 0 ) {
+    soln.clear();
+    for ( vector<size_t>::const_iterator i = chosen.begin(),
+            e = chosen.end(); i != e; ++i )
+      soln.push_back( option_of(*i) );
+    return !(*out)( soln );
+  }
+
+  size_t i;
+  choose(i);
+  if ( len[i] == 0 ) return true;
+
+  cover(i);
+
+  bool cont = true;
+  for ( size_t x = nodes_v[i].down; cont && x != i; x = nodes_v[x].down ) {
+    chosen.push_back(x);
+    for ( size_t p = x+1; p != x; ) {
+      long j = nodes_v[p].top;
+      if ( j <= 0 ) p = nodes_v[p].up;
+      else cover(j), ++p;
+    }
+
+    cont = search();
+
+    for ( size_t p = x-1; p != x; ) {
+      long j = nodes_v[p].top;
+      if ( j <= 0 ) p = nodes_v[p].down;
+      else uncover(j), --p;
+    }
+    chosen.pop_back();
+  }
+
+  uncover(i);
+  return cont;
+}
+
+bool exact_cover::solve( outputer& o )
+{
+  out = &o;
+  nodes = 0;
+  chosen.clear();
+  return search();
+}
+
+RINGING_END_NAMESPACE
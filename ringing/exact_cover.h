@@ -0,0 +1,112 @@
+// -*- C++ -*- exact_cover.h - Solve exact cover problems
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef RINGING_EXACT_COVER_H
+#define RINGING_EXACT_COVER_H
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#else
+#include <vector>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+// --------------------------------------------------------------
+//
+// An exact cover problem, solved with Knuth's Algorithm X using
+// dancing links.  The problem has a number of items, and a number of
+// options, each of which is a set of items.  A solution is a set of
+// options which contains each primary item exactly once, and each
+// secondary item at most once.  Secondary items are a convenient way
+// of saying that two options cannot both be chosen.
+//
+class RINGING_API exact_cover
+{
+public:
+  // Items [0, primary) are primary, and the next SECONDARY are secondary
+  exact_cover( size_t primary, size_t secondary = 0 );
+
+  // Adds an option containing the items [first, last), which must be
+  // distinct, and returns its index.  Options are numbered from zero.
+  size_t add_option( size_t const* first, size_t const* last );
+  size_t add_option( vector<size_t> const& items ) {
+    size_t const* p = items.empty() ? 0 : &items[0]; 
+    return add_option( p, p + items.size() ); 
+  }
+
+  size_t options() const { return nopts; }
+
+  class outputer
+  {
+  public:
+    virtual ~outputer() {}
+
+    // Called with the indices of the options in each solution, in the
+    // order they were chosen.  Returns true if the search should halt.
+    virtual bool operator()( vector<size_t> const& solution ) = 0;
+  };
+
+  // Finds every solution, or until the outputer asks to halt.  Returns
+  // false if it halted.  The problem is unchanged afterwards, so it can
+  // be solved again.
+  bool solve( outputer& o );
+
+  // The number of nodes in the search tree visited by solve
+  RINGING_ULLONG node_count() const { return nodes; }
+
+private:
+  // The links for items (which are in [1, N]) and options, stored
+  // as in TAOCP 7.2.2.1.  The spacer between two options has a top of
+  // minus the index of the option before it, plus one.
+  struct node {
+    long top;
+    size_t up, down;
+  };
+
+  bool search();
+  void choose( size_t& best ) const;
+  void cover( size_t i );
+  void uncover( size_t i );
+  void hide( size_t p );
+  void unhide( size_t p );
+  size_t option_of( size_t x ) const;
+
+  size_t primary, nopts, last_spacer;
+  vector<node> nodes_v;
+  vector<size_t> llink, rlink, len;
+  vector<size_t> chosen;
+  vector<size_t> soln;
+  outputer* out;
+  RINGING_ULLONG nodes;
+};
+
+RINGING_END_NAMESPACE
+
+#endif // RINGING_EXACT_COVER_H
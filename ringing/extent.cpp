@@ -26,8 +26,10 @@
 
 #if RINGING_OLD_C_INCLUDES
 #include <assert.h>
+#include <string.h>
 #else
 #include <cassert>
+#include <cstring>
 #endif
 #if RINGING_OLD_INCLUDES
 #include <algo.h>
@@ -97,6 +99,128 @@ extent_iterator extent_iterator::end( unsigned nw, unsigned nh, unsigned nt )
   return e;
 }
 
+RINGING_START_ANON_NAMESPACE
+
+// The number of bits set in each ten bit number
+#define RINGING_BITS2(n) n, n+1, n+1, n+2
+#define RINGING_BITS4(n) \
+  RINGING_BITS2(n), RINGING_BITS2(n+1), RINGING_BITS2(n+1), RINGING_BITS2(n+2)
+#define RINGING_BITS6(n) \
+  RINGING_BITS4(n), RINGING_BITS4(n+1), RINGING_BITS4(n+1), RINGING_BITS4(n+2)
+#define RINGING_BITS8(n) \
+  RINGING_BITS6(n), RINGING_BITS6(n+1), RINGING_BITS6(n+1), RINGING_BITS6(n+2)
+
+unsigned char const bits_set[1024] = { 
+  RINGING_BITS8(0), RINGING_BITS8(1), RINGING_BITS8(1), RINGING_BITS8(2) 
+};
+
+#undef RINGING_BITS2
+#undef RINGING_BITS4
+#undef RINGING_BITS6
+#undef RINGING_BITS8
+
+// The number of bits set in X, which is less than 2^20.  This is 
+// considerably quicker than the usual bit-twiddling unless the hardware
+// has a popcount instruction that the compiler has been told it can use.
+inline unsigned count_bits( unsigned long x )
+{
+  return bits_set[ x & 1023u ] + bits_set[ x >> 10 ];
+}
+
+RINGING_END_ANON_NAMESPACE
+
+extent_ranker::extent_ranker( unsigned nw, unsigned nh, unsigned nt )
+  : nw(nw), nh(nh), nt(nt)
+{
+  if ( nw > max_working_bells )
+    throw out_of_range( "Too many working bells to rank the extent" );
+  if ( nh + nw > nt )
+    throw out_of_range( "Too few bells to rank the extent" );
+
+  fact[0] = 1;
+  for ( unsigned i = 1; i <= nw; ++i ) fact[i] = fact[i-1] * i;
+}
+
+extent_ranker::extent_ranker( unsigned nw, unsigned nh )
+  : nw(nw), nh(nh), nt(nw+nh)
+{
+  if ( nw > max_working_bells )
+    throw out_of_range( "Too many working bells to rank the extent" );
+
+  fact[0] = 1;
+  for ( unsigned i = 1; i <= nw; ++i ) fact[i] = fact[i-1] * i;
+}
+
+RINGING_ULLONG extent_ranker::rank( row const& r ) const
+{
+  // The digits of the rank in the factorial number system are the
+  // number of later working bells that are smaller than each bell,
+  // which is the number of smaller bells that haven't been seen yet.
+  unsigned const e = min( unsigned(r.bells()), nh + nw );
+  unsigned long seen = 0;
+  RINGING_ULLONG x = 0;
+  for ( unsigned i = nh; i < e; ++i ) {
+    unsigned const b = r[i] - nh;
+    assert( b < nw );
+    unsigned long const bit = 1ul << b;
+    x = x * (nh + nw - i) + b - count_bits( seen & (bit - 1) );
+    seen |= bit;
+  }
+  // Any missing tenors contribute zeros
+  return e > nh ? x * fact[nh + nw - e] : x;
+}
+
+int extent_ranker::unrank( RINGING_ULLONG n, bell* out ) const
+{
+  assert( n < size() );
+
+  // The working bells not yet used, in order
+  unsigned char left[max_working_bells];
+  for ( unsigned i = 0; i < nw; ++i ) left[i] = nh + i;
+
+  unsigned inversions = 0;
+  for ( unsigned i = 0; i < nh; ++i ) out[i] = i;
+
+  // Each digit in the factorial number system picks one of the bells
+  // not yet used
+  for ( unsigned i = nh; i < nh + nw; ++i ) {
+    unsigned const k = nh + nw - i;
+    RINGING_ULLONG const f = fact[k-1];
+    unsigned const d = unsigned( n / f );
+    n -= d * f;
+    inversions += d;
+    out[i] = left[d];
+    memmove( left + d, left + d + 1, k - 1 - d );
+  }
+  for ( unsigned i = nh + nw; i < nt; ++i ) out[i] = i;
+
+  return inversions % 2 ? -1 : +1;
+}
+
+row extent_ranker::unrank( RINGING_ULLONG n ) const
+{
+  vector<bell> v(nt);
+  unrank( n, &v[0] );
+  row r; r.swap(v);
+  return r;
+}
+
+void extent_ranker::unrank_incourse( RINGING_ULLONG n, bell* out ) const
+{
+  // Rows 2n and 2n+1 differ only in their last two working bells, 
+  // so if 2n is out of course, 2n+1 is the in-course one
+  if ( unrank( n*2, out ) < 0 ) 
+    RINGING_PREFIX_STD swap( out[nh+nw-2], out[nh+nw-1] );
+}
+
+row extent_ranker::unrank_incourse( RINGING_ULLONG n ) const
+{
+  vector<bell> v(nt);
+  unrank_incourse( n, &v[0] );
+  row r; r.swap(v);
+  return r;
+}
+
 RINGING_API size_t
 position_in_extent( row const& r, unsigned nw, unsigned nh, unsigned nt )
 {
@@ -111,6 +235,9 @@ position_in_extent( row const& r, unsigned nw, unsigned nh, unsigned nt )
     if ( r[i] != i )
       throw out_of_range( "Row does not have fixed tenors" );
 
+  if ( nw <= extent_ranker::max_working_bells )
+    return extent_ranker( nw, nh, nt ).rank(r);
+
   size_t x = 0u;
   for ( size_t i=nh; i<nw+nh; ++i )
   {
@@ -126,6 +253,9 @@ position_in_extent( row const& r, unsigned nw, unsigned nh, unsigned nt )
 RINGING_API row
 nth_row_of_extent( size_t n, unsigned nw, unsigned nh, unsigned nt )
 {
+  if ( nw <= extent_ranker::max_working_bells )
+    return extent_ranker( nw, nh, nt ).unrank(n);
+
   vector<bell> v(nt);
 
   for ( unsigned i=0; i<nh; ++i ) v[i] = i;
@@ -188,6 +318,9 @@ size_t extent::size() const
 RINGING_API row
 nth_row_of_incourse_extent( size_t n, unsigned nw, unsigned nh, unsigned nt )
 {
+  if ( nw <= extent_ranker::max_working_bells )
+    return extent_ranker( nw, nh, nt ).unrank_incourse(n);
+
   row r( nth_row_of_extent( n*2, nw, nh, nt ) );
   if ( r.sign() < 0 ) {
     change c(nt); 
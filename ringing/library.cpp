@@ -59,8 +59,7 @@ void library::setpath_from_env()
     setpath( methlibpath );
 }
 
-RINGING_START_ANON_NAMESPACE
-list<string> split_path( string const& p )
+list<string> library::split_path( string const& p )
 {
   list<string> pp;
   string::size_type i=0;
@@ -77,8 +76,6 @@ list<string> split_path( string const& p )
   return pp;
 }
 
-RINGING_END_ANON_NAMESPACE
-
 #if RINGING_USE_EXCEPTIONS
 library_base::invalid_name::invalid_name() 
   : invalid_argument("The method name supplied could not be found in the library file") {}
@@ -92,6 +92,9 @@ public:
   virtual const_iterator begin() const = 0;
   const_iterator end() const;
 
+  // Are the find functions faster than a linear search?
+  virtual bool indexed() const { return false; }
+
 #if RINGING_USE_EXCEPTIONS
   struct invalid_name : public invalid_argument {
     invalid_name();
@@ -186,6 +189,7 @@ public:
   // Library status
   bool good() { return bool(lb()) && lb()->good(); }
   bool writeable() { return bool(lb()) && lb()->writeable(); }
+  bool indexed() const { return bool(lb()) && lb()->indexed(); }
 
   // New style, iterator based interface
   typedef library_base::const_iterator const_iterator;
@@ -206,6 +210,9 @@ public:
   // Set the path from $METHOD_LIBRARY_PATH or $METHLIBPATH
   static void setpath_from_env();
 
+  // Split a colon delimited path into its parts
+  static list<string> split_path( string const& p );
+
 private:
   library_base* lb()
     { return this->libbase::get_impl<library_base>(); }
@@ -138,6 +138,45 @@ double random_uniform_deviate( double min, double max )
   return min + random_uniform_deviate( max-min );
 }
 
+void random_source::set_seed( unsigned long seed )
+{
+  // Use a round of splitmix64 so that similar seeds give unrelated
+  // sequences.  The state must not be zero.
+  unsigned RINGING_LLONG z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  s = z ^ (z >> 31);
+  if (!s) s = 0x9E3779B97F4A7C15ULL;
+}
+
+unsigned RINGING_LLONG random_source::next()
+{
+  s ^= s >> 12; 
+  s ^= s << 25; 
+  s ^= s >> 27;
+  return s * 0x2545F4914F6CDD1DULL;
+}
+
+double random_source::random_uniform_deviate( double max )
+{
+  assert( max > 0 );
+  // The top 53 bits make a double in [0,1)
+  return max * ( (next() >> 11) * (1.0 / 9007199254740992.0) );
+}
+
+unsigned random_source::random_int( unsigned max )
+{
+  assert( max );
+  unsigned r = (unsigned) random_uniform_deviate( max );
+  return r < max ? r : max-1;
+}
+
+bool random_source::random_bool( double ptrue )
+{
+  assert( ptrue <= 1 );
+  return random_uniform_deviate() < ptrue;
+}
+
 // This follows the Box-Muller method to generate pairs of random numbers 
 // avoiding any complex trig functions.  See p289-90 of Press et al (2nd ed.).
 double random_normal_deviate( double mean, double stddev )
@@ -76,6 +76,33 @@ RINGING_API double random_normal_deviate( double mean, double stddev );
 // If rand is NULL, then just return the existing one
 RINGING_API pair<int (*)(), int> random_fn( int (*randfn)(), int max_rand );
 
+// A seedable random number generator with its own state, for use
+// when several generators are needed at once (for example, one per
+// thread) or when a sequence must be reproducible.  The generator
+// is xorshift64*, which is fast and statistically reasonable, but
+// not cryptographically secure.
+class RINGING_API random_source
+{
+public:
+  explicit random_source( unsigned long seed = 1 ) { set_seed(seed); }
+  void set_seed( unsigned long seed );
+
+  // As the free functions of the same names
+  unsigned random_int( unsigned max );
+  bool random_bool( double ptrue = 0.5 );
+  double random_uniform_deviate( double max = 1.0 );
+
+  // The raw generator state, so that a long search can be checkpointed
+  // and resumed.  The state must not be zero.
+  unsigned RINGING_LLONG get_state() const { return s; }
+  void set_state( unsigned RINGING_LLONG state ) { s = state; }
+
+private:
+  unsigned RINGING_LLONG next();
+
+  unsigned RINGING_LLONG s;
+};
+
 
 // Return base raised to the power of exp
 RINGING_API RINGING_LLONG ipower( int base, int exp );
@@ -678,6 +678,15 @@ int method::maxblows(void) const
   return maxn - 1;
 }
 
+size_t method::hash() const
+{
+  // As equality only considers the changes, so must the hash
+  size_t h = size();
+  for ( const_iterator i(begin()), e(end()); i != e; ++i )
+    h = 31*h + i->hash();
+  return h;
+}
+
 bool method::ispalindromic() const
 {
   return symmetry_point() != -1;
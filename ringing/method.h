@@ -124,6 +124,7 @@ class RINGING_API method : public vector<change> {
   int symmetry_point() const;   // Point of palindromic symmetry (or -1)
   int symmetry_point(bell b) const;   // Point of palindromic symmetry (or -1)
   int maxblows(void) const;     // Counts the maximum blows in one place
+  size_t hash() const;          // Hash of the changes, ignoring the name
 
   bool is_palindromic_about(int i) const;
   bool is_palindromic_about(bell b, int i) const;
@@ -160,6 +161,7 @@ class RINGING_API method : public vector<change> {
 RINGING_END_NAMESPACE
 
 RINGING_DELEGATE_STD_SWAP( method )
+RINGING_DELEGATE_STD_HASH( method )
 
 #endif
 
@@ -43,29 +43,20 @@ class methodset::impl : public library_base, public libout::interface
 public:
   class entry : public method {
   public:
-    explicit entry( method const& m ) : method(m) {}
-    explicit entry( library_entry const& src,
-                    vector<library_facet_id> const& ids );
+    entry( method const& m, size_t id ) : method(m), id(id) {}
     
     // Inherit comparison operators from method, so will work fine in a set
 
-    shared_pointer< library_facet_base > 
-      get_facet( const library_facet_id& id ) const;
-    void set_facet( shared_pointer< library_facet_base > const& facet ) 
-      { facets[ facet->get_id() ] = facet; }
- 
-  private:
-    typedef map< library_facet_id, shared_pointer< library_facet_base > > 
-      facet_map;
-   
-    facet_map facets;
+    // Index into the facet columns
+    size_t id;
   };
  
   class entry_ref : public library_entry::impl
   {
   public:
-    entry_ref() : valid(false) {}
-    explicit entry_ref( set<entry>::iterator i ) : valid(true), i(i) {}
+    entry_ref() : valid(false), ms(NULL) {}
+    entry_ref( methodset::impl const* ms, set<entry>::const_iterator i ) 
+      : valid(true), ms(ms), i(i) {}
 
     virtual library_entry::impl *clone() const { 
       return new entry_ref(*this); 
@@ -79,77 +70,224 @@ public:
     virtual method meth() const { return *i; }
     virtual bool readentry( library_base &lb );
     virtual shared_pointer< library_facet_base > 
-      get_facet( const library_facet_id& id ) const { return i->get_facet(id); }
+      get_facet( const library_facet_id& id ) const 
+      { return ms->get_facet( i->id, id ); }
     virtual void set_facet( shared_pointer<library_facet_base> const& f )
-      { return const_cast<entry&>(*i).set_facet(f); }
+      { return const_cast<methodset::impl*>(ms)->set_facet( i->id, f ); }
 
  private:
     bool valid;
-    set<entry>::iterator i;
+    methodset::impl const* ms;
+    set<entry>::const_iterator i;
 
     friend class methodset::impl;
   };
 
+  impl() : have_title_index(false) {}
+
   virtual bool good() const { return true; }
   virtual void flush() {}
   virtual library_entry find( method const& pn ) const;
+  virtual library_entry find( string const& title ) const;
+  virtual bool indexed() const { return true; }
   virtual library_base::const_iterator begin() const;
   virtual void append( library_entry const& e );
   virtual void append( method const& e );
   
-  void clear() { data.clear(); }
+  void clear();
   size_t size() const { return data.size(); }
 
   void store_facet( library_facet_id id ) { facet_ids.push_back(id); }
 
+  shared_pointer< library_facet_base > 
+    get_facet( size_t n, const library_facet_id& id ) const;
+  void set_facet( size_t n, shared_pointer< library_facet_base > const& f );
+
 private:
+  set<entry>::const_iterator insert( method const& m, bool& inserted );
+  static size_t title_hash( string const& title );
+
+  // An open-addressed hash table of entries.  Not all of the compilers
+  // we support have a hashed container, and this only needs to store 
+  // a hash and a pointer per slot.
+  class entry_index {
+  public:
+    entry_index() : count(0) {}
+
+    void clear() { slots.clear(); count = 0; }
+    void insert( size_t h, entry const* e );
+
+    // Call p(e) on each entry with hash h until it returns true
+    template <class Pred> entry const* find( size_t h, Pred p ) const {
+      if ( slots.empty() ) return NULL;
+      size_t mask = slots.size() - 1;
+      for ( size_t s = h & mask; slots[s].e; s = (s+1) & mask )
+        if ( slots[s].hash == h && p( *slots[s].e ) ) 
+          return slots[s].e;
+      return NULL;
+    }
+
+    // As find, but if several entries match, the first in the set
+    template <class Pred> entry const* find_first( size_t h, Pred p ) const {
+      entry const* r = NULL;
+      if ( slots.empty() ) return r;
+      size_t mask = slots.size() - 1;
+      for ( size_t s = h & mask; slots[s].e; s = (s+1) & mask )
+        if ( slots[s].hash == h && p( *slots[s].e ) 
+             && ( !r || *slots[s].e < *r ) ) 
+          r = slots[s].e;
+      return r;
+    }
+
+  private:
+    struct slot { size_t hash; entry const* e; };
+    vector<slot> slots;
+    size_t count;
+  };
+
+  struct same_method {
+    explicit same_method( method const& m ) : m(m) {}
+    bool operator()( entry const& e ) const { return e == m; }
+    method const& m;
+  };
+
+  struct same_title {
+    explicit same_title( string const& t ) : t(t) {}
+    bool operator()( entry const& e ) const { return e.fullname() == t; }
+    string const& t;
+  };
+
   // This needs to be something like a list or set that doesn't 
   // invalidate iterators on mutation.
   set<entry> data;
 
+  // Hashed on the changes
+  entry_index pn_index;
+
+  // Hashed on the full title.  As calculating titles requires the 
+  // method to be classified, this isn't built until it is first needed.
+  mutable bool have_title_index;
+  mutable entry_index title_index;
+
+  // Facets are stored in columns indexed by entry::id, rather than in
+  // a map per entry.  Entries which lack the facet hold a null pointer.
+  typedef vector< shared_pointer< library_facet_base > > facet_column;
+  vector< pair< library_facet_id, facet_column > > facets;
+
   // Facets to copy
   vector<library_facet_id> facet_ids;
 };
 
+void methodset::impl::entry_index::insert( size_t h, entry const* e )
+{
+  // Keep the load factor below a half
+  if ( 2*(count+1) > slots.size() ) {
+    vector<slot> old; old.swap(slots);
+    slot empty = { 0, NULL };
+    slots.resize( old.empty() ? 16 : 2*old.size(), empty );
+    count = 0;
+    for ( vector<slot>::const_iterator i=old.begin(), e=old.end(); 
+          i != e; ++i )
+      if ( i->e ) insert( i->hash, i->e );
+  }
+
+  size_t mask = slots.size() - 1, s = h & mask;
+  while ( slots[s].e ) s = (s+1) & mask;
+  slots[s].hash = h; slots[s].e = e;
+  ++count;
+}
+
+size_t methodset::impl::title_hash( string const& title )
+{
+  // The same FNV variant as row::hash
+  size_t h = title.size();
+  for ( string::const_iterator i=title.begin(), e=title.end(); i!=e; ++i )
+    h = 31*h + static_cast<unsigned char>(*i);
+  return h;
+}
+
+set<methodset::impl::entry>::const_iterator
+methodset::impl::insert( method const& m, bool& inserted )
+{
+  size_t h = m.hash();
+  if ( entry const* e = pn_index.find( h, same_method(m) ) ) {
+    inserted = false;
+    return data.find(*e);
+  }
+
+  set<entry>::const_iterator i = data.insert( entry(m, data.size()) ).first;
+  pn_index.insert( h, &*i );
+  if ( have_title_index )
+    title_index.insert( title_hash( i->fullname() ), &*i );
+  inserted = true;
+  return i;
+}
+
 void methodset::impl::append( library_entry const& e ) 
 {
-  data.insert( entry(e, facet_ids) );  
+  bool inserted;
+  set<entry>::const_iterator i = insert( e.meth(), inserted );
+  if (!inserted) return;
+
+  for ( vector<library_facet_id>::const_iterator 
+          fi=facet_ids.begin(), fe=facet_ids.end(); fi != fe; ++fi ) {
+    shared_pointer<library_facet_base> f( e.get_facet(*fi) );
+    if (f) set_facet( i->id, f );
+  }
 }
 
 void methodset::impl::append( method const& m ) 
 {
-  data.insert( entry(m) );  
+  bool inserted;
+  insert( m, inserted );
 }
 
-methodset::impl::entry::entry( library_entry const& src,
-                               vector<library_facet_id> const& ids )
-  : method( src.meth() )
+void methodset::impl::clear()
 {
-  for ( vector<library_facet_id>::const_iterator i=ids.begin(), e=ids.end();
-        i != e; ++i ) {
-    shared_pointer<library_facet_base> f( src.get_facet(*i) );
-    if (f) facets[*i] = f;
-  }
+  pn_index.clear();
+  title_index.clear();
+  have_title_index = false;
+  facets.clear();
+  data.clear();
 }
 
 shared_pointer< library_facet_base >
-methodset::impl::entry::get_facet( const library_facet_id& id ) const
+methodset::impl::get_facet( size_t n, const library_facet_id& id ) const
+{
+  for ( vector< pair< library_facet_id, facet_column > >::const_iterator
+          i=facets.begin(), e=facets.end(); i != e; ++i )
+    if ( i->first == id ) 
+      return n < i->second.size() ? i->second[n] 
+        : shared_pointer< library_facet_base >();
+  return shared_pointer< library_facet_base >();
+}
+
+void methodset::impl::set_facet( size_t n,
+  shared_pointer< library_facet_base > const& f )
 {
-  facet_map::const_iterator i = facets.find(id);
-  if ( i != facets.end() ) return i->second;
-  else return shared_pointer< library_facet_base >();
+  library_facet_id const& id = f->get_id();
+  
+  vector< pair< library_facet_id, facet_column > >::iterator 
+    i=facets.begin(), e=facets.end();
+  while ( i != e && i->first != id ) ++i;
+  if ( i == e ) 
+    i = facets.insert( e, make_pair( id, facet_column() ) );
+
+  if ( i->second.size() <= n ) i->second.resize( data.size() );
+  i->second[n] = f;
 }
 
 bool methodset::impl::entry_ref::readentry( library_base &lb ) 
 {
-  set<entry>& data = dynamic_cast<methodset::impl&>(lb).data;
+  methodset::impl const& m = dynamic_cast<methodset::impl&>(lb);
   if (!valid) {
-    i = data.begin(); 
+    ms = &m;
+    i = m.data.begin(); 
     valid = true;
   } 
   else ++i;
 
-  if (i == data.end()) {
+  if (i == m.data.end()) {
     valid = false;
     return false;
   }
@@ -174,11 +312,30 @@ methodset::methodset()
 
 library_entry methodset::impl::find( method const& pn ) const
 {
-  set<entry>::iterator i = data.find( entry(pn) );
-  if ( i == data.end() )
+  entry const* e = pn_index.find( pn.hash(), same_method(pn) );
+  if ( !e )
+    return library_entry();
+  else
+    return library_entry( new entry_ref( this, data.find(*e) ) );
+}
+
+library_entry methodset::impl::find( string const& title ) const
+{
+  if ( !have_title_index ) {
+    for ( set<entry>::const_iterator i=data.begin(), e=data.end(); 
+          i != e; ++i )
+      title_index.insert( title_hash( i->fullname() ), &*i );
+    have_title_index = true;
+  }
+
+  // Different methods can have the same title: find the one a linear
+  // search would
+  entry const* e 
+    = title_index.find_first( title_hash(title), same_title(title) );
+  if ( !e )
     return library_entry();
   else
-    return library_entry( new entry_ref(i) );
+    return library_entry( new entry_ref( this, data.find(*e) ) );
 }
 
 void methodset::clear() 
@@ -216,21 +373,10 @@ size_t methodset::import_libraries_from_env()
   size_t count = 0u;
 
   if ( char const* const lib_env = getenv("METHOD_LIBRARY") ) {
-    string p(lib_env);
-
-    // XXX: This is basically the split_path function from ringing/library.cpp
-    string::size_type i=0;
-    while (true) {
-      string::size_type j = p.find(':', i);
-      if ( j == string::npos ) {
-        if ( p.size() ) 
-          count += import_library( p.substr(i) );
-        break;
-      }
-    
-      count += import_library( p.substr(i, j-i) );
-      i = j+1;
-    }
+    list<string> names( library::split_path(lib_env) );
+    for ( list<string>::const_iterator i=names.begin(), e=names.end(); 
+          i != e; ++i )
+      count += import_library( *i );
   }
 
   return count;
@@ -25,6 +25,7 @@
 #endif
 
 #include <ringing/multtab.h>
+#include <ringing/extent.h>
 #if RINGING_OLD_INCLUDES
 #include <iostream.h>
 #include <iomanip.h>
@@ -48,6 +49,89 @@ RINGING_START_NAMESPACE
 
 RINGING_USING_STD
 
+RINGING_START_ANON_NAMESPACE
+
+// Finds the index of a row in the table from its rank in the extent.
+// When the extent is small this is a direct lookup, otherwise it is a 
+// binary search of the ranks.  Both are much quicker than a map keyed 
+// on the rows, which is only used with more than 20 bells.  As with
+// the map, unknown rows give rounds.
+class row_finder
+{
+public:
+  explicit row_finder( vector<row> const& rows );
+  multtab::row_t operator()( row const& r ) const;
+
+private:
+  typedef pair< RINGING_ULLONG, size_t > entry;
+
+  // Whether r is a permutation of exactly nt bells, as rk requires
+  bool rankable( row const& r ) const;
+
+  unsigned nt;
+  extent_ranker rk;
+  vector< size_t > direct;
+  vector< entry > ranked;
+  map< row, size_t > mapped;
+};
+
+row_finder::row_finder( vector<row> const& rows )
+  : nt( rows.empty() ? 0 : rows.front().bells() ),
+    rk( nt <= extent_ranker::max_working_bells ? nt : 0 )
+{
+  if ( nt > extent_ranker::max_working_bells ) {
+    for ( size_t i(0); i < rows.size(); ++i )
+      mapped[ rows[i] ] = i;
+  }
+  // Allow the direct table to be a few times larger than the table, 
+  // as on 8 bells, where it is never more than 320KB
+  else if ( rk.size() <= 40320u || rk.size() <= rows.size() * 8 ) {
+    direct.resize( size_t( rk.size() ), 0u );
+    for ( size_t i(0); i < rows.size(); ++i )
+      direct[ size_t( rk.rank( rows[i] ) ) ] = i;
+  }
+  else {
+    ranked.reserve( rows.size() );
+    for ( size_t i(0); i < rows.size(); ++i )
+      ranked.push_back( entry( rk.rank( rows[i] ), i ) );
+    sort( ranked.begin(), ranked.end() );
+  }
+}
+
+bool row_finder::rankable( row const& r ) const
+{
+  if ( unsigned( r.bells() ) != nt ) return false;
+  for ( unsigned i = 0; i < nt; ++i )
+    if ( unsigned( r[i] ) >= nt ) return false;
+  return true;
+}
+
+multtab::row_t row_finder::operator()( row const& r ) const
+{
+  // As with the map, rows not in the table give rounds
+  if ( mapped.empty() && !rankable(r) )
+    return multtab::row_t();
+
+  if ( !direct.empty() )
+    return multtab::row_t::from_index( direct[ size_t( rk.rank(r) ) ] );
+
+  if ( !ranked.empty() ) {
+    vector< entry >::const_iterator i
+      = lower_bound( ranked.begin(), ranked.end(), entry( rk.rank(r), 0u ) );
+    if ( i != ranked.end() && i->first == rk.rank(r) )
+      return multtab::row_t::from_index( i->second );
+  }
+  else {
+    map< row, size_t >::const_iterator i = mapped.find(r);
+    if ( i != mapped.end() )
+      return multtab::row_t::from_index( i->second );
+  }
+
+  return multtab::row_t();
+}
+
+RINGING_END_ANON_NAMESPACE
+
 int multtab::bells() const
 {
   return rows.empty() ? 0 : rows.front().bells();
@@ -175,16 +259,14 @@ multtab::compute_pre_mult( const row &r )
     if ( cols[i].second == pre_mult && cols[i].first == r )
       return pre_col_t( i, this );
 
-  // Build up a map in O(n) to get O(ln n) lookups.
+  // Index the rows by rank in O(n) to get O(1) lookups.
   // The alternative -- doing direct lookups -- is
   // O(n ln n).  For a 1-part table on 8 bells, this
   // improves speed a factor of over 100.
-  map< row, row_t > finder;
-  for ( size_t i(0); i < table.size(); ++i )
-    finder[ rows[i] ] = row_t::from_index(i);
+  row_finder const finder( rows );
 
   for ( size_t i(0); i < table.size(); ++i )
-    table[i].push_back( finder[ make_representative( r * rows[i] ) ] );
+    table[i].push_back( finder( make_representative( r * rows[i] ) ) );
   
   cols.push_back( make_pair( r, pre_mult ) );
   return pre_col_t( cols.size() - 1, this );
@@ -205,16 +287,14 @@ multtab::compute_post_mult( const row &r )
     if ( cols[i].second == post_mult && cols[i].first == r )
       return post_col_t( i, this );
 
-  // Build up a map in O(n) to get O(ln n) lookups.
+  // Index the rows by rank in O(n) to get O(1) lookups.
   // The alternative -- doing direct lookups -- is
   // O(n ln n).  For a 1-part table on 8 bells, this
   // improves speed a factor of over 100.
-  map< row, row_t > finder;
-  for ( size_t i(0); i < table.size(); ++i )
-    finder[ rows[i] ] = row_t::from_index(i);
+  row_finder const finder( rows );
 
   for ( size_t i(0); i < table.size(); ++i )
-    table[i].push_back( finder[ make_representative( rows[i] * r ) ] );
+    table[i].push_back( finder( make_representative( rows[i] * r ) ) );
 
   cols.push_back( make_pair( r, post_mult ) );
   return post_col_t( cols.size() - 1, this );
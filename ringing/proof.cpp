@@ -170,6 +170,52 @@ void prover::remove_row( const row& r )
     }
 }
 
+void prover::truncate( size_t n )
+{
+  if ( n >= (size_t) lineno ) return;
+  if ( chain ) 
+    throw logic_error( "Cannot truncate a chained prover" );
+
+  for ( mmap::iterator i = m.begin(); i != m.end(); )
+    if ( (size_t) i->second > n ) m.erase(i++);
+    else ++i;
+  lineno = n;
+
+  // Recalculate the falseness.  The falseness details are ordered by
+  // the line on which each row first became false, as add_row does.
+  dups = falsec = 0;
+  multimap<int, linedetail> fails;
+  for ( mmap::const_iterator i = m.begin(), e = m.end(); i != e; ) {
+    list<int> lines;
+    mmap::const_iterator j = i;
+    for ( ; j != e && j->first == i->first; ++j )
+      lines.push_back( j->second );
+    
+    size_t count = lines.size();
+    dups += count - 1;
+    if ( max_occurs != -1 && count > (size_t) max_occurs ) {
+      falsec += count - max_occurs;
+      if ( fi ) {
+        lines.sort();
+        linedetail l;
+        l._row = i->first;
+        l._lines = lines;
+        list<int>::const_iterator k = lines.begin(); 
+        advance( k, max_occurs );
+        fails.insert( make_pair( *k, l ) );
+      }
+    }
+    i = j;
+  }
+
+  if ( fi ) {
+    fi->clear();
+    for ( multimap<int, linedetail>::const_iterator i = fails.begin(),
+            e = fails.end(); i != e; ++i )
+      fi->push_back( i->second );
+  }
+}
+
 shared_pointer<prover> 
 prover::create_branch( shared_pointer<prover> const& chain )
 {
@@ -89,6 +89,11 @@ public:
   bool add_row( const row &r );
   void remove_row( const row& r );
 
+  // Removes every row but the first n from the touch, and recalculates
+  // the falseness.  Unlike remove_row, the rows removed are exactly
+  // those added last.  Throws if any of them are in a chained prover.
+  void truncate( size_t n );
+
   // Returns the number of instances of 'r' in the touch.
   size_t count_row( const row& r ) const;
 
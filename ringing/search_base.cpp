@@ -25,15 +25,117 @@
 
 #include <ringing/search_base.h>
 #include <ringing/pointers.h>
+#include <ringing/timing.h>
 
 RINGING_START_NAMESPACE
 
 RINGING_USING_STD
 
+RINGING_START_ANON_NAMESPACE
+
+// Counts the touches on their way to the real outputer
+class counting_outputer : public search_base::outputer
+{
+public:
+  counting_outputer( search_base::outputer& o, search_stats& s ) 
+    : o(o), s(s) {}
+
+  virtual bool operator()( const touch &t ) 
+  { 
+    s.touch(); 
+    return o(t); 
+  }
+
+private:
+  search_base::outputer& o;
+  search_stats& s;
+};
+
+RINGING_END_ANON_NAMESPACE
+
+search_stats::search_stats( progress* p, RINGING_ULLONG freq )
+  : prog(p), freq( freq ? freq : 1ul )
+{
+  clear();
+}
+
+void search_stats::clear()
+{
+  depth_nodes.clear();
+  total = touch_count = 0ul;
+  for ( int i = 0; i < num_prune_reasons; ++i ) prunes[i] = 0ul;
+  started = elapsed = 0.0;
+  running = false;
+  countdown = freq;
+}
+
+double search_stats::seconds() const
+{
+  return running ? elapsed + clock_seconds() - started : elapsed;
+}
+
+double search_stats::nodes_per_second() const
+{
+  double const t = seconds();
+  return t > 0 ? total / t : 0.0;
+}
+
+void search_stats::start()
+{
+  started = clock_seconds();
+  running = true;
+}
+
+void search_stats::finish()
+{
+  elapsed += clock_seconds() - started;
+  running = false;
+}
+
+void search_stats::merge( search_stats const& s )
+{
+  if ( s.depth_nodes.size() > depth_nodes.size() ) 
+    depth_nodes.resize( s.depth_nodes.size(), 0ul );
+  for ( size_t i = 0; i < s.depth_nodes.size(); ++i )
+    depth_nodes[i] += s.depth_nodes[i];
+
+  touch_count += s.touch_count;
+  for ( int i = 0; i < num_prune_reasons; ++i ) prunes[i] += s.prunes[i];
+
+  total += s.total;
+  if ( prog ) {
+    if ( countdown > s.total ) 
+      countdown -= s.total;
+    else
+      report();
+  }
+}
+
+void search_stats::report()
+{
+  countdown = freq;
+  (*prog)( *this );
+}
+
 void search_base::run( search_base::outputer &o ) const
 {
   scoped_pointer< context_base > ctx( new_context() );
   ctx->run( o );
 }
 
+void search_base::run( search_base::outputer &o, search_stats& stats ) const
+{
+  stats.start();
+  try {
+    scoped_pointer< context_base > ctx( new_context() );
+    ctx->stats = &stats;
+    counting_outputer co( o, stats );
+    ctx->run( co );
+  } catch ( ... ) {
+    stats.finish();
+    throw;
+  }
+  stats.finish();
+}
+
 RINGING_END_NAMESPACE
@@ -30,10 +30,84 @@
 #pragma interface
 #endif
 
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#else
+#include <vector>
+#endif
+
 RINGING_START_NAMESPACE
 
+RINGING_USING_STD
+
 class touch;
 
+// Statistics gathered while running a search.  Depths are measured
+// in leads.
+class RINGING_API search_stats
+{
+public:
+  enum prune_reason {
+    false_prune,         // The next lead was false
+    non_canonical_prune, // A rotation of the touch would be found instead
+    length_prune,        // The touch was too short or too long
+    num_prune_reasons
+  };
+
+  class progress
+  {
+  public:
+    virtual ~progress() {}
+
+    // Called every so often while the search is running
+    virtual void operator()( search_stats const& s ) = 0;
+  };
+
+  // If P is given, it is called every FREQ nodes
+  explicit search_stats( progress* p = 0, 
+                         RINGING_ULLONG freq = 10000000ul );
+
+  void clear();
+
+  RINGING_ULLONG nodes() const { return total; }
+  RINGING_ULLONG nodes( size_t depth ) const 
+    { return depth < depth_nodes.size() ? depth_nodes[depth] : 0ul; }
+  size_t max_depth() const { return depth_nodes.size(); }
+
+  RINGING_ULLONG pruned( prune_reason r ) const { return prunes[r]; }
+  RINGING_ULLONG touches() const { return touch_count; }
+
+  // The time spent searching, in seconds, including the time so far
+  // if the search is still running.
+  double seconds() const;
+  double nodes_per_second() const;
+
+  // These are called by the searches
+  void start();
+  void finish();
+  void node( size_t depth ) {
+    if ( depth >= depth_nodes.size() ) depth_nodes.resize( depth+1, 0ul );
+    ++depth_nodes[depth];
+    ++total;
+    if ( prog && --countdown == 0 ) report();
+  }
+  void prune( prune_reason r ) { ++prunes[r]; }
+  void touch() { ++touch_count; }
+
+  // Adds the counts in S to these, as if they had been gathered here
+  void merge( search_stats const& s );
+
+private:
+  void report();
+
+  vector<RINGING_ULLONG> depth_nodes;
+  RINGING_ULLONG total, touch_count, prunes[num_prune_reasons];
+  double started, elapsed;
+  bool running;
+  progress* prog;
+  RINGING_ULLONG freq, countdown;
+};
+
 class RINGING_API search_base
 {
 public:
@@ -50,12 +124,19 @@ public:
 
   void run( outputer &o ) const;
 
+  // As above, and fills in STATS as the search runs.  Searches
+  // that do not support this only count the touches.
+  void run( outputer &o, search_stats& stats ) const;
+
 RINGING_PROTECTED_IMPL:
   class RINGING_API context_base
   {
   public:
+    context_base() : stats(0) {}
     virtual void run( outputer & ) = 0;
     virtual ~context_base() {}
+
+    search_stats* stats; // The statistics to fill in, or NULL
   };
 
 private:
@@ -115,6 +196,16 @@ void touch_search( const search_base &searcher,
   searcher.run( o );
 }
 
+template < class OutputIterator > 
+void touch_search( const search_base &searcher, 
+		   const OutputIterator &iter,
+		   search_stats &stats )
+{
+  RINGING_USING_DETAILS
+  search_output< OutputIterator > o( iter );
+  searcher.run( o, stats );
+}
+
 
 template < class OutputIterator, class UnaryPredicate > 
 void touch_search_until( const search_base &searcher, 
@@ -126,6 +217,17 @@ void touch_search_until( const search_base &searcher,
   searcher.run( o );
 }
 
+template < class OutputIterator, class UnaryPredicate > 
+void touch_search_until( const search_base &searcher, 
+		         const OutputIterator &iter,
+		         const UnaryPredicate &terminate,
+		         search_stats &stats )
+{
+  RINGING_USING_DETAILS
+  search_output_until< OutputIterator, UnaryPredicate > o( iter, terminate );
+  searcher.run( o, stats );
+}
+
 RINGING_END_NAMESPACE
 
 #endif // RINGING_SEARCH_BASE_H
@@ -319,16 +319,22 @@ private:
 
     IF_DEBUG( (++nodes % 1000000 == 0) && (cout << "Node: " << nodes << "\n") );
 
+    if ( stats ) stats->node( depth );
+
     // Is the touch lexicographically no greater than any of it's rotations?
     if ( !is_possibly_canonical( cur ) )
-      return;
+      prune( search_stats::non_canonical_prune );
 
     // Is the going to repeat?
     else if (is_row_false(r)) {
       // Has it come round, and is it in it's canonical form?
-      if ( depth >= lenrange.first 
-           && ( (f & non_round_blocks) || r.isrounds() ) 
-           && is_really_canonical() )
+      if ( !(f & non_round_blocks) && !r.isrounds() )
+        prune( search_stats::false_prune );
+      else if ( depth < lenrange.first )
+        prune( search_stats::length_prune );
+      else if ( !is_really_canonical() )
+        prune( search_stats::non_canonical_prune );
+      else
         output_touch( output, cur );
     }
     else if ( depth < lenrange.second ) {
@@ -341,6 +347,13 @@ private:
       calls.pop_back();
       leads[r.index()]--;
     }
+    else 
+      prune( search_stats::length_prune );
+  }
+
+  void prune( search_stats::prune_reason r )
+  {
+    if ( stats ) stats->prune(r);
   }
  
 private:
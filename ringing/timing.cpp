@@ -0,0 +1,45 @@
+// -*- C++ -*- timing.cpp - Measure elapsed time
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <ringing/common.h>
+
+#include <ringing/timing.h>
+#if RINGING_OLD_C_INCLUDES
+#include <time.h>
+#else
+#include <ctime>
+#endif
+#if RINGING_USE_THREADS
+#include <chrono>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+// Thread support implies C++11, so <chrono> is available
+double clock_seconds()
+{
+#if RINGING_USE_THREADS
+  return chrono::duration<double>
+    ( chrono::steady_clock::now().time_since_epoch() ).count();
+#else
+  return double( clock() ) / CLOCKS_PER_SEC;
+#endif
+}
+
+RINGING_END_NAMESPACE
@@ -0,0 +1,36 @@
+// -*- C++ -*- timing.h - Measure elapsed time
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef RINGING_TIMING_H
+#define RINGING_TIMING_H
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_ONCE
+#pragma once
+#endif
+
+RINGING_START_NAMESPACE
+
+// The time in seconds from an arbitrary origin, for timing things by
+// taking the difference of two calls.  This is a monotonic wall clock
+// if threads are supported, and processor time otherwise.
+RINGING_API double clock_seconds();
+
+RINGING_END_NAMESPACE
+
+#endif // RINGING_TIMING_H
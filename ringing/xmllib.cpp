@@ -29,11 +29,17 @@
 #else
 #include <cstdio>
 #endif
+#if RINGING_OLD_INCLUDES
+#include <fstream.h>
+#else
+#include <fstream>
+#endif
 #include <ringing/xmllib.h>
 #include <ringing/pointers.h>
 #include <ringing/library.h>
 #include <ringing/peal.h>
 #include <ringing/dom.h>
+#include <ringing/xmlreader.h>
 
 // Important note:  DO NOT include <ringing/streamutils.h> from here.  That
 // file includes GPL'd content and this file is only LGPL'd.
@@ -54,248 +60,288 @@ public:
 
 private:
   // Iterators into the library
+  class entry_data;
   class entry_type;
+  struct stream_state;
   friend class entry_type;
   virtual library_base::const_iterator begin() const;
 
   // Library interface
   virtual bool good() const  { return true; } 
 
+  shared_pointer<stream_state> open_stream() const;
+
   // Data members
-  shared_pointer<dom_document> doc;
   bool cc_xml;
-};
 
-xmllib::impl::impl( xmllib::file_arg_type type, const string& url )
-{
-  dom_document::filetype ftype;
+  // Used when reading a URL through the DOM
+  shared_pointer<dom_document> doc;
+
+  // Used when reading a local file.  Each iterator has its own parser, 
+  // so that iterators don't disturb one another.
   string filename;
+};
 
-  switch (type) {
-    case xmllib::filename:
-      ftype = dom_document::file; filename = url;
-      break;
-      
-    case xmllib::default_url:
-      filename = "http://methods.ringing.org/cgi-bin/simple.pl?format=old&";
-  
-    case xmllib::url:
-      ftype = dom_document::url; filename += url;
-      break;
+// The parser used by an iterator over a local file
+struct xmllib::impl::stream_state
+{
+  ifstream f;
+  scoped_pointer<xml_reader> reader;
+  string set_stage;   // The stage of the current <methodSet>
+};
 
-    default:
-      abort();
-  }
-      
-  doc.reset( new dom_document( filename, dom_document::in, ftype ) );
+// The fields of a <method> element that we use.  These are extracted
+// when the entry is read, either from the DOM or directly from the 
+// parser, so that the accessors don't need to know which was used.
+class xmllib::impl::entry_data 
+{
+public:
+  entry_data() : has_pn(false) {}
 
-  if ( doc->get_document().get_name() == "methods" ) 
-    cc_xml = false;
-  else if ( doc->get_document().get_name() == "collection" )
-    cc_xml = true;
-  else
-    throw runtime_error
-      ( "Document root should be a <methods/> or <collection/> element" );
-}
+  // Set the content of the element at path, relative to the <method>
+  void set( vector<string> const& path, string const& content );
 
-class xmllib::impl::entry_type : public library_entry::impl
-{
-  dom_element 
-    next_sibling_element( dom_element start, const string& name) const;
-  string get_field( dom_element const& parent, const string& elt_name ) const;
-  string extract_text( const dom_element& e ) const;
-  peal get_peal( const string& elt_name ) const;
-  string facet_elt( const library_facet_id& id ) const;
-
-  virtual string name() const;
-  virtual string base_name() const;
-  virtual string pn() const;
-  virtual int bells() const;
-  
-  virtual bool has_facet( const library_facet_id& id ) const;
+  string pn() const;
+  int bells() const;
 
-  virtual shared_pointer< library_facet_base >
-    get_facet( const library_facet_id& id ) const;
+  class peal_data {
+  public:
+    peal_data() : present(false) {}
+    void set( vector<string> const& path, string const& content );
+    peal get() const;
 
-  friend class xmllib::impl;
-  explicit entry_type( const shared_pointer<dom_document>& doc, bool cc_xml );
-  virtual bool readentry( library_base &lb );
-  virtual library_entry::impl *clone() const;
+    bool present;
+    string date, location[8];
+  };
 
-  bool cc_xml;
-  shared_pointer<dom_document> doc;  // To deal with persistence
-  dom_element methset, meth;
+  string title, name, stage, set_stage, notation, symmetry, block;
+  vector<string> symblocks;
+  bool has_pn;
+  peal_data tower, hand;
 };
 
-dom_element xmllib::impl::entry_type
-  ::next_sibling_element( dom_element start, const string& name ) const
-{
-  while ( start && start.get_name() != name )
-    start = start.get_next_sibling();
-  return start;
-}
+// The parts of the location, in the order they are joined
+static char const* const location_fields[8] = {
+  "room", "building",       // CC XML only
+  "dedication", "place",    // Our XML only
+  "town",                   // CC XML only
+  "county",                 // Both formats
+  "region",                 // CC XML only
+  "country"                 // Both formats
+};
 
-string xmllib::impl::entry_type::get_field( dom_element const& parent,
-					    const string& name) const
+void xmllib::impl::entry_data::peal_data::set( vector<string> const& path,
+                                               string const& content )
 {
-  if (!parent) return string();
-  dom_element e = next_sibling_element( parent.get_first_child(), name );
-  if (e)  
-    return extract_text( e );
-  else
-    return string();
+  if ( path.size() == 1 ) 
+    present = true;
+  else if ( path.size() == 2 && path[1] == "date" ) {
+    if ( date.empty() ) date = content;
+  }
+  else if ( path.size() == 3 && path[1] == "location" )
+    for ( int i=0; i<8; ++i ) 
+      if ( path[2] == location_fields[i] && location[i].empty() )
+        location[i] = content;
 }
 
-peal xmllib::impl::entry_type::get_peal( const string& name ) const
+peal xmllib::impl::entry_data::peal_data::get() const
 {
-  dom_element e = next_sibling_element( meth.get_first_child(), name );
-  if (!e) return peal();
-
   peal::date dt;
-  if ( sscanf( get_field( e, "date" ).c_str(), "%d-%d-%d", 
+  if ( sscanf( date.c_str(), "%d-%d-%d", 
 	       &dt.year, &dt.month, &dt.day ) != 3 )
     dt.day = dt.month = dt.year = 0;
 
+  // TODO: The peal object should know about the different 
+  // parts of a location
   string loc;
-
-  dom_element l = next_sibling_element( meth.get_first_child(), "location" );
-  if ( l ) {
-    // TODO: The peal object should know about the different 
-    // parts of a location
-    string tmp;
-
-    // CC XML only
-    tmp=get_field( l, "room" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // CC XML only
-    tmp=get_field( l, "building" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // Our XML only
-    tmp=get_field( l, "dedication" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // Our XML only
-    tmp=get_field( l, "place" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // CC XML only
-    tmp=get_field( l, "town" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // Both formats
-    tmp=get_field( l, "county" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // CC XML only
-    tmp=get_field( l, "region" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-
-    // Both formats
-    tmp=get_field( l, "country" );
-    if (tmp.size() && loc.size()) loc += ", ";
-    if (tmp.size()) loc += tmp;
-  }
+  for ( int i=0; i<8; ++i ) 
+    if ( location[i].size() ) {
+      if ( loc.size() ) loc += ", ";
+      loc += location[i];
+    }
 
   return peal( dt, loc );
 }
 
-string xmllib::impl::entry_type::extract_text( const dom_element& e ) const
+void xmllib::impl::entry_data::set( vector<string> const& path,
+                                    string const& content )
 {
-  return e.get_content();
-}
+  string const& elt = path[0];
 
-string xmllib::impl::entry_type::name() const
-{
-  return get_field( meth, "title" );
-}
+  if ( elt == "firstTowerbellPeal" || elt == "first-tower" )
+    tower.set( path, content );
+  else if ( elt == "firstHandbellPeal" || elt == "first-hand" )
+    hand.set( path, content );
 
-string xmllib::impl::entry_type::base_name() const
-{
-  return get_field( meth, "name" );
+  else if ( path.size() == 2 && elt == "pn" ) {
+    if ( path[1] == "block" ) {
+      if ( block.empty() ) block = content;
+    }
+    else if ( path[1] == "symblock" )
+      symblocks.push_back( content );
+  }
+
+  else if ( path.size() != 1 ) 
+    return;
+
+  // The first occurrence of each element is used
+  else if ( elt == "pn" )       has_pn = true;
+  else if ( title.empty()    && elt == "title" )    title = content;
+  else if ( name.empty()     && elt == "name" )     name = content;
+  else if ( stage.empty()    && elt == "stage" )    stage = content;
+  else if ( notation.empty() && elt == "notation" ) notation = content;
+  else if ( symmetry.empty() && elt == "symmetry" ) symmetry = content;
 }
 
-string xmllib::impl::entry_type::pn() const
+string xmllib::impl::entry_data::pn() const
 {
-  if ( dom_element pn_elt
-         = next_sibling_element( meth.get_first_child(), "pn" ) ) {
+  if ( has_pn ) {
+    if ( block.size() )
+      return block;
 
-    if ( dom_element block_elt 
-         = next_sibling_element( pn_elt.get_first_child(), "block" ) )
-      return extract_text( block_elt );
-    
-    else if ( dom_element sym_elt
-              = next_sibling_element( pn_elt.get_first_child(), "symblock" ) ) {
-      string value( 1u, '&' );
-      value.append( extract_text( sym_elt ) );
-      value.append( 1u, ',');
-        
-      sym_elt = next_sibling_element( sym_elt.get_next_sibling(), "symblock" );
-  
-      if ( !sym_elt )
+    else if ( symblocks.size() ) {
+      if ( symblocks.size() == 1 )
         throw runtime_error
           ( "XML <pn> element has only one <symblock> element" );
   
+      string value( 1u, '&' );
+      value.append( symblocks[0] );
+      value.append( 1u, ',');
       value.append( 1u, '&' );
-      value.append( extract_text( sym_elt ) );
-  
+      value.append( symblocks[1] );
       return value;
     }
     else 
       throw runtime_error
         ( "XML <pn> element has unrecognised content" );
   }
-  else if ( dom_element notn_elt
-            = next_sibling_element( meth.get_first_child(), "notation" ) ) {
-
-    dom_element sym_elt = next_sibling_element( meth.get_first_child(), 
-                                                "symmetry" );
-
-    if ( !sym_elt || sym_elt.get_content().find("palindromic") == string::npos )
-      return extract_text( notn_elt );
+  else if ( notation.size() ) {
+    if ( symmetry.find("palindromic") == string::npos )
+      return notation;
 
     else {
-      string notn( extract_text( notn_elt ) );
-      size_t i = notn.find(',');
+      size_t i = notation.find(',');
 
-      if ( i == string::npos || i == 0 || i == notn.size()-1)
-        return notn;
+      if ( i == string::npos || i == 0 || i == notation.size()-1)
+        return notation;
      
       string value( 1u, '&' );
-      value.append( notn, 0, i+1 );
+      value.append( notation, 0, i+1 );
       value.append( 1u, '&' );
-      value.append( notn, i+1, string::npos );
+      value.append( notation, i+1, string::npos );
       return value;
     }
   }
   else
     throw runtime_error
       ( "XML method element has no <pn> or <notation> element" );
-
 }
 
-int xmllib::impl::entry_type::bells() const 
+int xmllib::impl::entry_data::bells() const 
 {
-  string stage( get_field(meth, "stage") );
-  if (stage.empty() && methset)
-    stage = get_field( next_sibling_element( methset.get_first_child(), 
-                                             "properties" ), "stage" );
-  
-  int b = atoi( stage.c_str() );
+  int b = atoi( stage.empty() ? set_stage.c_str() : stage.c_str() );
   if ( b == 0 )
     throw runtime_error
       ( "Invalid or missing stage specified" );
   return b;
 }
 
+xmllib::impl::impl( xmllib::file_arg_type type, const string& url )
+{
+  string name;
+
+  switch (type) {
+    case xmllib::filename:
+      filename = url;
+      name = open_stream()->reader->name();
+      break;
+      
+    case xmllib::default_url:
+      name = "http://methods.ringing.org/cgi-bin/simple.pl?format=old&";
+  
+    case xmllib::url:
+      name += url;
+      doc.reset( new dom_document( name, dom_document::in, 
+                                   dom_document::url ) );
+      name = doc->get_document().get_name();
+      break;
+
+    default:
+      abort();
+  }
+      
+  if ( name == "methods" ) 
+    cc_xml = false;
+  else if ( name == "collection" )
+    cc_xml = true;
+  else
+    throw runtime_error
+      ( "Document root should be a <methods/> or <collection/> element" );
+}
+
+// Open the file and read up to the start of the document element
+shared_pointer<xmllib::impl::stream_state> xmllib::impl::open_stream() const
+{
+  shared_pointer<stream_state> s( new stream_state );
+  s->f.open( filename.c_str(), ios::in | ios::binary );
+  if ( !s->f )
+    throw runtime_error( "Unable to open " + filename );
+
+  s->reader.reset( new xml_reader(s->f) );
+  if ( s->reader->next() != xml_reader::start_element ) 
+    throw runtime_error( "XML document has no document element" );
+  return s;
+}
+
+class xmllib::impl::entry_type : public library_entry::impl
+{
+  dom_element 
+    next_sibling_element( dom_element start, const string& name) const;
+  void read_dom( dom_element const& parent, vector<string>& path );
+  bool readentry_dom( xmllib::impl const& xl );
+  bool readentry_stream( xmllib::impl const& xl );
+
+  virtual string name() const { return data.title; }
+  virtual string base_name() const { return data.name; }
+  virtual string pn() const { return data.pn(); }
+  virtual int bells() const { return data.bells(); }
+  
+  virtual bool has_facet( const library_facet_id& id ) const;
+
+  virtual shared_pointer< library_facet_base >
+    get_facet( const library_facet_id& id ) const;
+
+  friend class xmllib::impl;
+  entry_type( const shared_pointer<dom_document>& doc,
+              const shared_pointer<stream_state>& stream );
+  virtual bool readentry( library_base &lb );
+  virtual library_entry::impl *clone() const;
+
+  shared_pointer<dom_document> doc;  // To deal with persistence
+  dom_element methset, meth;
+  shared_pointer<stream_state> stream;  // Shared only by copies
+  entry_data data;
+};
+
+dom_element xmllib::impl::entry_type
+  ::next_sibling_element( dom_element start, const string& name ) const
+{
+  while ( start && start.get_name() != name )
+    start = start.get_next_sibling();
+  return start;
+}
+
+void xmllib::impl::entry_type::read_dom( dom_element const& parent,
+                                         vector<string>& path )
+{
+  for ( dom_element e = parent.get_first_child(); e; 
+        e = e.get_next_sibling() ) {
+    path.push_back( e.get_name() );
+    read_dom( e, path );
+    data.set( path, e.get_content() );
+    path.pop_back();
+  }
+}
 
 library_entry::impl *xmllib::impl::entry_type::clone() const
 {
@@ -303,10 +349,16 @@ library_entry::impl *xmllib::impl::entry_type::clone() const
 }
 
 bool xmllib::impl::entry_type::readentry( library_base& lb )
+{
+  xmllib::impl const& xl = dynamic_cast<xmllib::impl const&>(lb);
+  return stream ? readentry_stream(xl) : readentry_dom(xl);
+}
+
+bool xmllib::impl::entry_type::readentry_dom( xmllib::impl const& xl )
 {
   if (meth)
     meth = meth.get_next_sibling();
-  else if (cc_xml) {
+  else if (xl.cc_xml) {
     methset = next_sibling_element( doc->get_document().get_first_child(),
                                     "methodSet" );
     meth = methset.get_first_child();
@@ -316,7 +368,7 @@ bool xmllib::impl::entry_type::readentry( library_base& lb )
 
   while (true) {
     meth = next_sibling_element( meth, "method" );
-    if (meth) return true;
+    if (meth) break;
 
     if (methset)
       methset = next_sibling_element( methset.get_next_sibling(), "methodSet" );
@@ -324,24 +376,80 @@ bool xmllib::impl::entry_type::readentry( library_base& lb )
     if (!methset) return false;
     meth = methset.get_first_child();
   }
+
+  data = entry_data();
+  if (methset)
+    if ( dom_element props = next_sibling_element( methset.get_first_child(),
+                                                   "properties" ) )
+      if ( dom_element s = next_sibling_element( props.get_first_child(),
+                                                 "stage" ) )
+        data.set_stage = s.get_content();
+
+  vector<string> path;
+  read_dom( meth, path );
+  return true;
 }
 
-string xmllib::impl::entry_type::facet_elt( const library_facet_id& id ) const
+bool xmllib::impl::entry_type::readentry_stream( xmllib::impl const& xl )
 {
-  if ( id == first_tower_peal::id )
-    return cc_xml ? "firstTowerbellPeal" : "first-tower";
+  xml_reader& r = *stream->reader;
+  string& set_stage = stream->set_stage;
+  size_t const method_depth = xl.cc_xml ? 3 : 2;
 
-  else if ( id == first_hand_peal::id ) 
-    return cc_xml ? "firstHandbellPeal" : "first-hand";
+  // Find the next <method>, noting the stage of each <methodSet> 
+  // along the way.
+  while (true) {
+    xml_reader::token_type t = r.next();
+    if ( t == xml_reader::end_of_document ) 
+      return false;
+    else if ( t != xml_reader::start_element )
+      continue;
+
+    if ( r.depth() == method_depth && r.name() == "method" ) 
+      break;
+    else if ( xl.cc_xml && r.depth() == 2 && r.name() == "methodSet" )
+      set_stage.erase();
+    else if ( xl.cc_xml && r.depth() == 4 && r.name() == "stage" 
+              && set_stage.empty() ) {
+      while ( r.next() == xml_reader::text )
+        set_stage += r.value();
+    }
+  }
 
-  else return string();
+  data = entry_data();
+  data.set_stage = set_stage;
+
+  // Only the content of the current element is held in memory
+  vector<string> path, content;
+  while (true) {
+    switch ( r.next() ) {
+    case xml_reader::start_element:
+      path.push_back( r.name() );
+      content.push_back( string() );
+      break;
+
+    case xml_reader::text:
+      if ( content.size() ) content.back() += r.value();
+      break;
+
+    case xml_reader::end_element:
+      if ( path.empty() ) return true;
+      data.set( path, content.back() );
+      path.pop_back(); content.pop_back();
+      break;
+
+    case xml_reader::end_of_document:
+      return false;
+    }
+  }
 }
 
 bool xmllib::impl::entry_type::has_facet( const library_facet_id& id ) const
 {
-  string elt( facet_elt(id) );
-  if (elt.size())
-    return next_sibling_element( meth.get_first_child(), elt );
+  if ( id == first_tower_peal::id )
+    return data.tower.present;
+  else if ( id == first_hand_peal::id ) 
+    return data.hand.present;
   else 
     return false;
 }
@@ -350,27 +458,29 @@ shared_pointer< library_facet_base >
 xmllib::impl::entry_type::get_facet( const library_facet_id& id ) const
 {
   shared_pointer< library_facet_base > result;
-  string elt( facet_elt(id) );
 
-  if (elt.size()) {
-    if ( next_sibling_element( meth.get_first_child(), elt ) ) 
-      result.reset( new first_tower_peal( get_peal(elt) ) );
-  }
+  if ( id == first_tower_peal::id && data.tower.present )
+    result.reset( new first_tower_peal( data.tower.get() ) );
+  else if ( id == first_hand_peal::id && data.hand.present )
+    result.reset( new first_hand_peal( data.hand.get() ) );
 
   return result;
 }
 
 
-xmllib::impl::entry_type::entry_type( const shared_pointer<dom_document>& doc,
-                                      bool cc_xml )
-  : doc(doc), cc_xml(cc_xml)
+xmllib::impl::entry_type
+  ::entry_type( const shared_pointer<dom_document>& doc,
+                const shared_pointer<stream_state>& stream )
+  : doc(doc), stream(stream)
 {
 }
 
 library_base::const_iterator xmllib::impl::begin() const
 {
+  shared_pointer<stream_state> stream;
+  if ( !doc ) stream = open_stream();
   return const_iterator( const_cast<xmllib::impl*>(this), 
-			 new entry_type(doc, cc_xml) );
+			 new entry_type(doc, stream) );
 }
 
 xmllib::xmllib( xmllib::file_arg_type type, const string& url )
@@ -388,4 +498,3 @@ library_base *xmllib::canread( const string& name )
 }
 
 RINGING_END_NAMESPACE
-
@@ -0,0 +1,316 @@
+// -*- C++ -*- xmlreader.cpp - A minimal streaming XML pull parser
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma implementation
+#endif
+
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+#if RINGING_OLD_INCLUDES
+#include <stdexcept.h>
+#else
+#include <stdexcept>
+#endif
+#include <ringing/xmlreader.h>
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+xml_reader::xml_reader( istream& in )
+  : buf( in.rdbuf() ), tok( end_of_document ),
+    pending_end(false), seen_root(false)
+{
+  // Skip a UTF-8 byte order mark
+  if ( peek() == 0xEF ) {
+    get();
+    if ( get() != 0xBB || get() != 0xBF ) error( "bad byte order mark" );
+  }
+}
+
+void xml_reader::error( char const* msg ) const
+{
+  throw runtime_error( string("XML parse error: ") + msg );
+}
+
+// Going straight to the streambuf is much faster than istream::get
+int xml_reader::get()
+{
+  return buf->sbumpc();
+}
+
+int xml_reader::peek()
+{
+  return buf->sgetc();
+}
+
+void xml_reader::expect( char c )
+{
+  if ( get() != c ) {
+    char msg[] = "expected 'x'";
+    msg[10] = c;
+    error(msg);
+  }
+}
+
+static inline bool is_space( int c )
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_name_char( int c )
+{
+  // Anything outside ASCII is assumed to be part of a UTF-8 name
+  return c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+    || (c >= '0' && c <= '9') || c == '_' || c == ':' || c == '-'
+    || c == '.';
+}
+
+void xml_reader::skip_space()
+{
+  while ( is_space( peek() ) ) get();
+}
+
+void xml_reader::skip_until( char const* terminator )
+{
+  size_t len = strlen(terminator);
+  string last;
+  while ( last.size() < len || last.compare( last.size()-len, len, 
+                                             terminator ) != 0 ) {
+    int c = get();
+    if ( c == EOF ) error( "unterminated markup" );
+    last += char(c);
+    if ( last.size() > 2*len ) last.erase( 0, last.size()-len );
+  }
+}
+
+string xml_reader::read_name()
+{
+  string name;
+  while ( is_name_char( peek() ) )
+    name += char( get() );
+  if ( name.empty() ) error( "expected a name" );
+  return name;
+}
+
+void xml_reader::read_reference( string& out )
+{
+  string ref;
+  for ( int c = get(); c != ';'; c = get() ) {
+    if ( c == EOF || ref.size() > 10 ) error( "bad entity reference" );
+    ref += char(c);
+  }
+
+  if ( ref == "lt" )        out += '<';
+  else if ( ref == "gt" )   out += '>';
+  else if ( ref == "amp" )  out += '&';
+  else if ( ref == "quot" ) out += '"';
+  else if ( ref == "apos" ) out += '\'';
+  else if ( ref.size() > 1 && ref[0] == '#' ) {
+    char* end;
+    unsigned long u = ref[1] == 'x'
+      ? strtoul( ref.c_str() + 2, &end, 16 )
+      : strtoul( ref.c_str() + 1, &end, 10 );
+    if ( *end || u == 0 || u > 0x10FFFF )
+      error( "bad character reference" );
+
+    // Encode as UTF-8
+    if ( u < 0x80 )
+      out += char(u);
+    else if ( u < 0x800 ) {
+      out += char( 0xC0 | (u >> 6) );
+      out += char( 0x80 | (u & 0x3F) );
+    }
+    else if ( u < 0x10000 ) {
+      out += char( 0xE0 | (u >> 12) );
+      out += char( 0x80 | ((u >> 6) & 0x3F) );
+      out += char( 0x80 | (u & 0x3F) );
+    }
+    else {
+      out += char( 0xF0 | (u >> 18) );
+      out += char( 0x80 | ((u >> 12) & 0x3F) );
+      out += char( 0x80 | ((u >> 6) & 0x3F) );
+      out += char( 0x80 | (u & 0x3F) );
+    }
+  }
+  else
+    error( "unknown entity reference" );
+}
+
+// Called after the '<' of a "<?" or "<!".  Returns true if it read
+// a CDATA section into val.
+bool xml_reader::read_markup()
+{
+  if ( get() == '?' ) {
+    skip_until( "?>" );
+    return false;
+  }
+
+  if ( peek() == '-' ) {
+    get(); expect('-');
+    skip_until( "-->" );
+    return false;
+  }
+
+  if ( peek() == '[' ) {
+    for ( char const* p = "[CDATA["; *p; ++p ) expect(*p);
+    if ( open.empty() ) error( "CDATA outside the document element" );
+
+    val.clear();
+    size_t brackets = 0;
+    while (true) {
+      int c = get();
+      if ( c == EOF ) error( "unterminated CDATA section" );
+      if ( c == '>' && brackets >= 2 ) {
+        val.append( brackets-2, ']' );
+        return true;
+      }
+      if ( c == ']' ) { ++brackets; continue; }
+      val.append( brackets, ']' ); brackets = 0;
+      val += char(c);
+    }
+  }
+
+  // A <!DOCTYPE ...>, possibly with an internal subset in brackets.
+  if ( seen_root ) error( "unexpected markup declaration" );
+  int depth = 0; char quote = 0;
+  while (true) {
+    int c = get();
+    if ( c == EOF ) error( "unterminated DOCTYPE" );
+    if ( quote ) { if ( c == quote ) quote = 0; }
+    else if ( c == '"' || c == '\'' ) quote = char(c);
+    else if ( c == '[' ) ++depth;
+    else if ( c == ']' ) --depth;
+    else if ( c == '>' && depth == 0 ) return false;
+  }
+}
+
+void xml_reader::read_start_tag()
+{
+  nm = read_name();
+  atts.clear();
+
+  while (true) {
+    bool space = is_space( peek() );
+    skip_space();
+    int c = peek();
+    if ( c == '/' ) {
+      get(); expect('>');
+      pending_end = true;
+      break;
+    }
+    else if ( c == '>' ) {
+      get();
+      break;
+    }
+    else if ( !space )
+      error( "expected whitespace between attributes" );
+
+    atts.push_back( make_pair( read_name(), string() ) );
+    skip_space(); expect('='); skip_space();
+    int q = get();
+    if ( q != '"' && q != '\'' ) error( "unquoted attribute value" );
+    string& v = atts.back().second;
+    for ( c = get(); c != q; c = get() ) {
+      if ( c == EOF || c == '<' ) error( "bad attribute value" );
+      if ( c == '&' ) read_reference(v);
+      else v += char(c);
+    }
+  }
+
+  if ( open.empty() && seen_root ) error( "more than one document element" );
+  seen_root = true;
+  open.push_back(nm);
+}
+
+void xml_reader::read_end_tag()
+{
+  nm = read_name();
+  skip_space(); expect('>');
+  if ( open.empty() || open.back() != nm ) error( "mismatched end tag" );
+}
+
+xml_reader::token_type xml_reader::next()
+{
+  // The element stays open until after its end_element has been seen
+  if ( tok == end_element ) open.pop_back();
+
+  if ( pending_end ) {
+    pending_end = false;
+    return tok = end_element;
+  }
+
+  while (true) {
+    int c = peek();
+
+    if ( c == EOF ) {
+      if ( !open.empty() ) error( "unexpected end of document" );
+      if ( !seen_root ) error( "no document element" );
+      return tok = end_of_document;
+    }
+
+    else if ( c == '<' ) {
+      get(); c = peek();
+      if ( c == '/' ) {
+        get(); read_end_tag();
+        return tok = end_element;
+      }
+      else if ( c == '?' || c == '!' ) {
+        if ( read_markup() ) return tok = text;
+      }
+      else {
+        read_start_tag();
+        return tok = start_element;
+      }
+    }
+
+    else if ( open.empty() ) {
+      // Fail early, so that non-XML files are rejected quickly
+      if ( !is_space(c) ) error( "text outside the document element" );
+      skip_space();
+    }
+
+    else {
+      val.clear();
+      while ( (c = peek()) != EOF && c != '<' ) {
+        get();
+        if ( c == '&' ) read_reference(val);
+        else if ( c == '\r' ) {
+          // Normalise line endings as the XML specification requires
+          if ( peek() != '\n' ) val += '\n';
+        }
+        else val += char(c);
+      }
+
+      return tok = text;
+    }
+  }
+}
+
+RINGING_END_NAMESPACE
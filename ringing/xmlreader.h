@@ -0,0 +1,107 @@
+// -*- C++ -*- xmlreader.h - A minimal streaming XML pull parser
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#ifndef RINGING_XMLREADER_H
+#define RINGING_XMLREADER_H
+
+#include <ringing/common.h>
+
+#if RINGING_HAS_PRAGMA_ONCE
+#pragma once
+#endif
+
+#if RINGING_HAS_PRAGMA_INTERFACE
+#pragma interface
+#endif
+
+#if RINGING_OLD_INCLUDES
+#include <istream.h>
+#include <vector.h>
+#include <utility.h>
+#else
+#include <istream>
+#include <vector>
+#include <utility>
+#endif
+#include <string>
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+// xml_reader : Reads an XML document from a stream one token at a time,
+// without building a tree.  This is not a validating parser: it
+// understands elements, attributes, character data, CDATA sections
+// and the predefined and numeric character references, and skips
+// comments, processing instructions and the DOCTYPE.  Names are
+// returned as they appear in the document, including any prefix.
+// Malformed documents cause a runtime_error to be thrown.
+class RINGING_API xml_reader
+{
+public:
+  enum token_type { start_element, end_element, text, end_of_document };
+
+  typedef vector< pair<string, string> > attributes;
+
+  explicit xml_reader( istream& in );
+
+  // Read the next token.  An empty element such as <foo/> is returned
+  // as a start_element followed by an end_element.  Text is returned
+  // in one token for each run of character data between tags.
+  token_type next();
+
+  token_type type() const { return tok; }
+
+  // The element name for start_element and end_element tokens
+  string const& name() const { return nm; }
+
+  // The (unescaped) character data for text tokens
+  string const& value() const { return val; }
+
+  // The attributes of a start_element token
+  attributes const& attrs() const { return atts; }
+
+  // How deeply nested the current token is; the document element
+  // is at depth 1.
+  size_t depth() const { return open.size(); }
+
+private:
+  int get();
+  int peek();
+  void expect( char c );
+  void skip_space();
+  void skip_until( char const* terminator );
+  string read_name();
+  void read_reference( string& out );
+  bool read_markup();
+  void read_start_tag();
+  void read_end_tag();
+  void error( char const* msg ) const;
+
+  streambuf* buf;
+  token_type tok;
+  string nm, val;
+  attributes atts;
+  vector<string> open;
+  bool pending_end, seen_root;
+};
+
+RINGING_END_NAMESPACE
+
+#endif // RINGING_XMLREADER_H
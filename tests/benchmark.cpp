@@ -0,0 +1,555 @@
+// -*- C++ -*- benchmark.cpp - Benchmarks for the library and applications
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Usage: benchmark [--min-time=SECS] [--apps=DIR] [--output=FILE]
+//
+// Each benchmark is run repeatedly for at least --min-time seconds,
+// and the results are written as JSON.  If --apps is given, it should
+// be the apps directory of a build tree, and methsearch, gsiril and
+// spliceplan are run from there too.
+
+#include <ringing/common.h>
+
+#include <ringing/row.h>
+#include <ringing/change.h>
+#include <ringing/method.h>
+#include <ringing/extent.h>
+#include <ringing/proof.h>
+#include <ringing/multtab.h>
+#include <ringing/falseness.h>
+#include <ringing/music.h>
+#include <ringing/library.h>
+#include <ringing/mslib.h>
+#include <ringing/group.h>
+#include <ringing/table_search.h>
+#include <ringing/exact_cover.h>
+#include <ringing/timing.h>
+#include <ringing/streamutils.h>
+
+#if RINGING_OLD_INCLUDES
+#include <vector.h>
+#include <algorithm.h>
+#include <stdexcept.h>
+#else
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#endif
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#include <stdlib.h>
+#else
+#include <cstdio>
+#include <cstdlib>
+#endif
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "exec.h"
+
+RINGING_USING_NAMESPACE
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+struct result {
+  string name, unit;
+  RINGING_ULLONG count;
+  double seconds;
+};
+
+vector<result> results;
+double min_time = 1.0;
+
+// Stops the compiler discarding the work done by a benchmark
+size_t volatile sink = 0;
+
+void record( string const& name, string const& unit,
+             RINGING_ULLONG count, double seconds )
+{
+  result r = { name, unit, count, seconds };
+  results.push_back(r);
+  cerr << setw(24) << left << name << " " << setw(14) << right;
+  // A run too quick for the clock to measure has no rate
+  if ( seconds > 0 ) cerr << size_t( count / seconds );
+  else cerr << "-";
+  cerr << " " << unit << "/s" << endl;
+}
+
+// Calls FN until at least min_time seconds have passed.  Each call
+// returns the number of operations it did.
+void run( char const* name, char const* unit, RINGING_ULLONG (*fn)() )
+{
+  RINGING_ULLONG n = 0;
+  double const start = clock_seconds();
+  double t;
+  do n += fn(); while ( ( t = clock_seconds() - start ) < min_time );
+  record( name, unit, n, t );
+}
+
+// ---------------------------------------------------------------------
+// Data shared between the benchmarks
+
+vector<row> extent8;   // The extent on 8 bells
+vector<change> lead12; // A lead of Plain Bob Maximus
+method cambridge8;
+multtab* table8 = 0;   // Lead heads of major, with the treble fixed
+vector<multtab::post_col_t> cols8;
+string library_file;
+vector<string> library_names;
+vector<method> library_methods;
+
+void init_data()
+{
+  extent8.assign( extent_iterator(8), extent_iterator() );
+
+  method m( "&-1T-1T-1T-1T-1T-1T,12", 12 );
+  lead12.assign( m.begin(), m.end() );
+
+  cambridge8 = method( "&-38-14-1258-36-14-58-16-78,12", 8, "Cambridge" );
+}
+
+// ---------------------------------------------------------------------
+// Rows and changes
+
+RINGING_ULLONG bench_row_multiply()
+{
+  row r( extent8[1] );
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    r *= *i;
+  sink += r[0].to_char();
+  return extent8.size();
+}
+
+RINGING_ULLONG bench_row_inverse()
+{
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    sink += i->inverse()[0].to_char();
+  return extent8.size();
+}
+
+RINGING_ULLONG bench_row_hash()
+{
+  size_t h = 0;
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    h ^= i->hash();
+  sink += h;
+  return extent8.size();
+}
+
+RINGING_ULLONG bench_change_apply()
+{
+  row r( 12 );
+  for ( int i = 0; i < 1000; ++i )
+    for ( vector<change>::const_iterator j = lead12.begin(),
+            e = lead12.end(); j != e; ++j )
+      r *= *j;
+  sink += r[0].to_char();
+  return 1000 * lead12.size();
+}
+
+RINGING_ULLONG bench_extent_rank()
+{
+  static extent_ranker const rk(8);
+  RINGING_ULLONG x = 0;
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    x += rk.rank(*i);
+  sink += x;
+  return extent8.size();
+}
+
+RINGING_ULLONG bench_extent_unrank()
+{
+  extent_ranker const rk(12);
+  bell r[12];
+  RINGING_ULLONG const step = rk.size() / 40320u;
+  for ( RINGING_ULLONG n = 0; n < rk.size(); n += step ) {
+    rk.unrank( n, r );
+    sink += r[0];
+  }
+  return 40320u;
+}
+
+// ---------------------------------------------------------------------
+// Proving
+
+RINGING_ULLONG bench_prover()
+{
+  prover p;
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    p.add_row(*i);
+  sink += p.truth();
+  for ( vector<row>::const_iterator i = extent8.begin(), e = extent8.end();
+        i != e; ++i )
+    p.remove_row(*i);
+  return 2 * extent8.size();
+}
+
+// ---------------------------------------------------------------------
+// Multiplication tables
+
+void init_multtab()
+{
+  if ( table8 ) return;
+  table8 = new multtab( extent_iterator(7, 1), extent_iterator() );
+
+  // The lead heads of plain, bobbed and singled leads
+  row le( 8 );
+  for ( method::const_iterator i = cambridge8.begin(), e = cambridge8.end()-1;
+        i != e; ++i )
+    le *= *i;
+  char const* const calls[] = { "12", "14", "1234" };
+  for ( int i = 0; i < 3; ++i )
+    cols8.push_back( table8->compute_post_mult( le * change(8, calls[i]) ) );
+}
+
+RINGING_ULLONG bench_multtab_build()
+{
+  multtab t( extent_iterator(7, 1), extent_iterator() );
+  t.compute_post_mult( cambridge8.lh() );
+  sink += t.size();
+  return 1;
+}
+
+RINGING_ULLONG bench_multtab_lookup()
+{
+  init_multtab();
+  multtab::row_t r;
+  size_t n = 0;
+  for ( int i = 0; i < 1000; ++i )
+    for ( vector<multtab::post_col_t>::const_iterator j = cols8.begin(),
+            e = cols8.end(); j != e; ++j, ++n )
+      r = r * *j;
+  sink += r.index();
+  return n;
+}
+
+RINGING_ULLONG bench_falseness_table()
+{
+  falseness_table ft( cambridge8 );
+  sink += ft.size();
+  return 1;
+}
+
+// ---------------------------------------------------------------------
+// Music
+
+RINGING_ULLONG bench_music()
+{
+  static music* mu = 0;
+  if ( !mu ) {
+    mu = new music(8);
+    mu->push_back( music_details("5678*") );
+    mu->push_back( music_details("*5678") );
+    mu->push_back( music_details("*[4567][4567][4567]8") );
+    mu->push_back( music_details("13572468") );
+    mu->push_back( music_details("*6578") );
+  }
+  mu->process_rows( extent8.begin(), extent8.end() );
+  sink += mu->get_score();
+  return extent8.size();
+}
+
+// ---------------------------------------------------------------------
+// Libraries
+
+// Writes a MicroSIRIL library of 2000 symmetric methods on 8 bells
+void init_library()
+{
+  if ( !library_file.empty() ) return;
+
+  vector<change> changes;
+  changes.assign( changes_iterator(8), changes_iterator() );
+
+  library_file = "bench-lib8.txt";
+  ofstream os( library_file.c_str() );
+  if ( !os ) throw runtime_error( "Unable to write " + library_file );
+
+  os << "* 8\n";
+
+  unsigned long seed = 1;
+  for ( int i = 0; i < 2000; ++i ) {
+    string name = make_string() << "Bench" << i;
+    string pn = "&";
+    for ( int j = 0; j < 8; ++j ) {
+      seed = ( seed * 1103515245ul + 12345ul ) & 0xFFFFFFFFul;
+      if ( j ) pn += '.';
+      pn += changes[ (seed >> 16) % changes.size() ].print();
+    }
+    os << name << " b " << pn << "\n";
+    library_names.push_back(name);
+    library_methods.push_back( method( pn + ",2", 8 ) );
+  }
+}
+
+RINGING_ULLONG bench_library_load()
+{
+  init_library();
+  library l( library_file );
+  if ( !l.good() ) throw runtime_error( "Unable to read " + library_file );
+  size_t n = 0;
+  for ( library::const_iterator i = l.begin(), e = l.end(); i != e; ++i, ++n )
+    sink += i->meth().length();
+  return n;
+}
+
+RINGING_ULLONG bench_library_find()
+{
+  init_library();
+  library l( library_file );
+  size_t n = 0;
+  for ( size_t i = 0; i < library_names.size(); i += 97, n += 2 ) {
+    sink += l.find( library_names[i] ).null();
+    sink += l.find( library_methods[i] ).null();
+  }
+  return n;
+}
+
+// ---------------------------------------------------------------------
+// Searches
+
+class count_touches : public search_base::outputer
+{
+public:
+  count_touches() : n(0) {}
+  virtual bool operator()( const touch& ) { ++n; return false; }
+  size_t n;
+};
+
+RINGING_ULLONG bench_table_search()
+{
+  vector<change> calls;
+  calls.push_back( change( 6, "14" ) );
+  calls.push_back( change( 6, "1234" ) );
+
+  table_search s( method( "&-16-16-16,12", 6 ), calls, group(),
+                  make_pair( size_t(0), size_t(18) ),
+                  table_search::ignore_rotations );
+  count_touches o;
+  search_stats stats;
+  s.run( o, stats );
+  sink += o.n;
+  return stats.nodes();
+}
+
+// Counts the solutions of the eight queens problem.  The ranks and
+// files are primary items, and the diagonals are secondary.
+class count_covers : public exact_cover::outputer
+{
+public:
+  count_covers() : n(0) {}
+  virtual bool operator()( vector<size_t> const& ) { ++n; return false; }
+  size_t n;
+};
+
+RINGING_ULLONG bench_exact_cover()
+{
+  exact_cover ec( 16, 30 );
+  for ( size_t r = 0; r < 8; ++r )
+    for ( size_t f = 0; f < 8; ++f ) {
+      size_t const items[4] = { r, 8 + f, 16 + r + f, 31 + r + 7 - f };
+      ec.add_option( items, items + 4 );
+    }
+
+  count_covers o;
+  ec.solve(o);
+  if ( o.n != 92 ) throw runtime_error( "Wrong number of queens solutions" );
+  return ec.node_count();
+}
+
+// ---------------------------------------------------------------------
+// Applications
+
+// Twenty treble dodging minor methods, for timing spliceplan's recurse
+// against its exact cover solver
+char const* const splice_methods[] = {
+  "X.34.X.14.X.12.X.1236.X.12.X.36.X.12.X.1236.X.12.X.14.X.34.X.12",
+  "X.34.X.14.X.56.X.1236.X.12.X.16.X.12.X.1236.X.56.X.14.X.34.X.12",
+  "X.34.X.14.56.X.12.36.X.14.X.16.X.14.X.36.12.X.56.14.X.34.X.16",
+  "X.34.X.1456.X.12.X.36.X.14.X.16.X.14.X.36.X.12.X.1456.X.34.X.16",
+  "X.34.X.1456.X.56.X.36.12.X.14.36.14.X.12.36.X.56.X.1456.X.34.X.16",
+  "X.34.56.14.X.1256.X.1236.X.14.X.56.X.14.X.1236.X.1256.X.14.56.34.X.16",
+  "X.34.56.14.56.X.12.36.X.14.X.36.X.14.X.36.12.X.56.14.56.34.X.16",
+  "X.3456.X.14.X.56.12.36.12.X.14.56.14.X.12.36.12.56.X.14.X.3456.X.16",
+  "X.36.X.14.X.12.X.36.X.14.X.16.X.14.X.36.X.12.X.14.X.36.X.12",
+  "X.36.X.14.X.56.X.36.X.14.X.16.X.14.X.36.X.56.X.14.X.36.X.12",
+  "X.36.X.14.56.12.X.1236.X.14.X.16.X.14.X.1236.X.12.56.14.X.36.X.12",
+  "X.36.X.1456.X.1256.X.36.X.14.X.56.X.14.X.36.X.1256.X.1456.X.36.X.16",
+  "X.36.X.1456.X.56.12.36.14.X.12.56.12.X.14.36.12.56.X.1456.X.36.X.12",
+  "X.56.X.14.X.1256.X.36.X.12.X.56.X.12.X.36.X.1256.X.14.X.56.X.12",
+  "X.56.X.14.X.56.X.36.12.X.34.56.34.X.12.36.X.56.X.14.X.56.X.16",
+  "X.56.X.14.56.12.X.1236.X.12.X.56.X.12.X.1236.X.12.56.14.X.56.X.12",
+  "X.56.X.1456.X.12.X.36.X.12.X.56.X.12.X.36.X.12.X.1456.X.56.X.16",
+  "X.56.X.1456.X.56.X.1236.X.34.X.16.X.34.X.1236.X.56.X.1456.X.56.X.16",
+  "34.X.36.14.X.12.X.36.X.1234.X.36.X.1234.X.36.X.12.X.14.36.X.34.16",
+  "34.X.36.14.X.56.X.36.X.1234.X.36.X.1234.X.36.X.56.X.14.36.X.34.16"
+};
+
+string splice_file;
+
+// Runs CMD once, and returns its output and how long it took.  Without
+// threads, clock_seconds is processor time and excludes the command's.
+string time_app( string const& cmd, double& t )
+{
+  double const start = clock_seconds();
+  int status = 0;
+  string out = exec_command( cmd, &status );
+  t = clock_seconds() - start;
+  if ( status )
+    throw runtime_error( "Unable to run " + cmd );
+  return out;
+}
+
+// Runs CMD once, and reads the number before the text AFTER in its output
+void run_app( char const* name, char const* unit,
+              string const& cmd, string const& before )
+{
+  double t;
+  string out = time_app( cmd, t );
+
+  string::size_type i = out.find(before);
+  if ( i == string::npos )
+    throw runtime_error( "Unable to run " + cmd );
+  i = out.rfind( ' ', i ? i-1 : 0 );
+  RINGING_ULLONG n = 0;
+  istringstream( out.substr( i == string::npos ? 0 : i+1 ) ) >> n;
+  record( name, unit, n, t );
+}
+
+// Runs CMD once, and counts the lines in its output
+void run_app_lines( char const* name, char const* unit, string const& cmd )
+{
+  double t;
+  string out = time_app( cmd, t );
+  record( name, unit, count( out.begin(), out.end(), '\n' ), t );
+}
+
+void run_apps( string const& dir )
+{
+  run_app( "methsearch", "nodes",
+           dir + "/methsearch/methsearch -b6 -S -p3 --node-count -C -q",
+           " nodes" );
+  run_app( "gsiril", "rows",
+           dir + "/gsiril/gsiril -b8 -n200 "
+           "-e 'm=&-1-1-1-1,+2; prove 200(7m)' </dev/null",
+           " rows ending" );
+
+  // Each plan found is one line of output
+  splice_file = "bench-splice6.txt";
+  {
+    ofstream os( splice_file.c_str() );
+    for ( size_t i = 0; i < sizeof(splice_methods)/sizeof(char const*); ++i )
+      os << splice_methods[i] << " m" << i << "\n";
+    if ( !os ) throw runtime_error( "Unable to write " + splice_file );
+  }
+  run_app_lines( "spliceplan", "plans",
+                 dir + "/spliceplan/spliceplan -b6 -i <" + splice_file );
+  run_app_lines( "spliceplan_exact_cover", "plans",
+                 dir + "/spliceplan/spliceplan -b6 -i -x <" + splice_file );
+}
+
+void write_json( ostream& os )
+{
+  os << "{\n  \"benchmarks\": [\n";
+  for ( vector<result>::const_iterator i = results.begin(),
+          e = results.end(); i != e; ++i ) {
+    os << "    { \"name\": \"" << i->name << "\", "
+       << "\"unit\": \"" << i->unit << "\", "
+       << "\"count\": " << i->count << ", "
+       << "\"seconds\": " << setprecision(6) << fixed << i->seconds << ", "
+       << "\"rate\": ";
+    // JSON has no inf or nan
+    if ( i->seconds > 0 )
+      os << setprecision(1) << i->count / i->seconds;
+    else
+      os << "null";
+    os << " }" << ( i+1 == e ? "" : "," ) << "\n";
+  }
+  os << "  ]\n}\n";
+}
+
+RINGING_END_ANON_NAMESPACE
+
+int main( int argc, char** argv )
+{
+  string apps, output;
+  for ( int i = 1; i < argc; ++i ) {
+    string a( argv[i] );
+    if ( a.compare( 0, 11, "--min-time=" ) == 0 )
+      min_time = atof( a.c_str() + 11 );
+    else if ( a.compare( 0, 7, "--apps=" ) == 0 )
+      apps = a.substr(7);
+    else if ( a.compare( 0, 9, "--output=" ) == 0 )
+      output = a.substr(9);
+    else {
+      cerr << "Usage: benchmark [--min-time=SECS] [--apps=DIR] "
+        "[--output=FILE]\n";
+      return 1;
+    }
+  }
+
+  try {
+    mslib::registerlib();
+    init_data();
+
+    run( "row_multiply",     "rows",    &bench_row_multiply );
+    run( "row_inverse",      "rows",    &bench_row_inverse );
+    run( "row_hash",         "rows",    &bench_row_hash );
+    run( "change_apply",     "changes", &bench_change_apply );
+    run( "extent_rank",      "rows",    &bench_extent_rank );
+    run( "extent_unrank",    "rows",    &bench_extent_unrank );
+    run( "prover_add_remove","rows",    &bench_prover );
+    run( "multtab_build",    "tables",  &bench_multtab_build );
+    run( "multtab_lookup",   "lookups", &bench_multtab_lookup );
+    run( "falseness_table",  "tables",  &bench_falseness_table );
+    run( "music_process_row","rows",    &bench_music );
+    run( "library_load",     "methods", &bench_library_load );
+    run( "library_find",     "lookups", &bench_library_find );
+    run( "table_search",     "nodes",   &bench_table_search );
+    run( "exact_cover",      "nodes",   &bench_exact_cover );
+
+    if ( !apps.empty() ) run_apps( apps );
+  }
+  catch ( exception const& e ) {
+    cerr << "benchmark: " << e.what() << endl;
+    return 1;
+  }
+
+  if ( !library_file.empty() ) remove( library_file.c_str() );
+  if ( !splice_file.empty() ) remove( splice_file.c_str() );
+
+  if ( output.empty() )
+    write_json( cout );
+  else {
+    ofstream os( output.c_str() );
+    write_json( os );
+    if ( !os ) {
+      cerr << "benchmark: Unable to write " << output << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
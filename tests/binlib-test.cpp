@@ -0,0 +1,128 @@
+// -*- C++ -*- binlib-test.cpp - Tests for the binary method library
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/binlib.h>
+#include <ringing/methodset.h>
+#include <ringing/method.h>
+#include "test-base.h"
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#else
+#include <cstdio>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+char const* const filename = "binlib-test.tmp";
+
+// Some methods, including one on the most bells a binlib can store
+void add_methods( methodset& ms )
+{
+  ms.append( method( "&-36-14-12-36-14-56,12", 6, "Cambridge" ) );
+  ms.append( method( "&x18x18x18x18,12", 8, "Plain Bob" ) );
+  ms.append( method( "3,&1.7.1.7.1.7.1", 7, "Grandsire" ) );
+  ms.append( method( "&-5-4.5-5.36.4-4.5-4-1,8", 8, "Bristol" ) );
+  ms.append( method( "3.1", 33, "Big" ) );
+  ms.append( method( "&-1-1,2", 32 ) );
+}
+
+void write_library( methodset const& ms )
+{
+  binout out( filename );
+  out.append( ms.begin(), ms.end() );
+  out.flush();
+}
+
+void test_binlib_round_trip(void)
+{
+  methodset ms; add_methods(ms);
+  write_library(ms);
+
+  binlib lib( filename );
+  RINGING_TEST( lib.good() );
+
+  library::const_iterator i = lib.begin(), e = lib.end();
+  for ( library::const_iterator j = ms.begin(), je = ms.end(); j != je;
+        ++i, ++j ) {
+    RINGING_TEST( i != e );
+    if ( i == e ) break;
+    RINGING_TEST( i->meth() == j->meth() );
+    RINGING_TEST( i->bells() == j->bells() );
+    RINGING_TEST( i->name() == j->name() );
+    RINGING_TEST( i->base_name() == j->base_name() );
+    RINGING_TEST( i->fullname() == j->fullname() );
+  }
+  RINGING_TEST( i == e );
+
+  remove( filename );
+}
+
+void test_binlib_find(void)
+{
+  methodset ms; add_methods(ms);
+  write_library(ms);
+
+  binlib lib( filename );
+  for ( library::const_iterator j = ms.begin(), je = ms.end(); j != je; ++j )
+  {
+    library_entry le( lib.find( j->fullname() ) );
+    RINGING_TEST( !le.null() && le.meth() == j->meth() );
+
+    le = lib.find( j->meth() );
+    RINGING_TEST( !le.null() && le.fullname() == j->fullname() );
+  }
+
+  library_entry le( lib.find( method( "3.1", 33 ) ) );
+  RINGING_TEST( !le.null() && le.name() == "Big" && le.bells() == 33 );
+
+  RINGING_TEST( lib.find( "Yorkshire Surprise Major" ).null() );
+  RINGING_TEST( lib.find( method( "&-1-1,2", 34 ) ).null() );
+
+  remove( filename );
+}
+
+// Methods on more than 33 bells cannot be written
+void test_binlib_too_many_bells(void)
+{
+  methodset ms;
+  ms.append( method( "&-1-1,2", 34, "Huge" ) );
+
+  {
+    binout out( filename );
+    RINGING_TEST_THROWS( out.append( *ms.begin() ), runtime_error );
+  }
+
+  remove( filename );
+}
+
+RINGING_END_ANON_NAMESPACE
+
+RINGING_START_TEST_FILE( binlib )
+
+  RINGING_REGISTER_TEST( test_binlib_round_trip )
+  RINGING_REGISTER_TEST( test_binlib_find )
+  RINGING_REGISTER_TEST( test_binlib_too_many_bells )
+
+RINGING_END_TEST_FILE
+
+RINGING_END_NAMESPACE
@@ -0,0 +1,139 @@
+// -*- C++ -*- cclib-test.cpp - Tests for the cclib index
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/cclib.h>
+#include <ringing/method.h>
+#include "test-base.h"
+#if RINGING_OLD_INCLUDES
+#include <fstream.h>
+#else
+#include <fstream>
+#endif
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#else
+#include <cstdio>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+char const* const filename = "cclib-test.tmp";
+
+// A library in the layout of the Central Council's text collections
+void write_library()
+{
+  ofstream out( filename );
+  out << "Copyright Central Council of Church Bell Ringers\n"
+      << "\n"
+      << "Surprise Minor methods\n"
+      << "\n"
+      << "No.  Name          Notation              hl  le  lh\n"
+      << "  1  Beverley      -36-14-12-36-12-      56  12  b \n"
+      << "  2  Cambridge     -36-14-12-36-14-      56  12  b \n"
+      << "  3  Surfleet      -36-14-12-36-34-      56  12  b \n"
+      << "\n"
+      << "Treble Bob Minor methods\n"
+      << "\n"
+      << "No.  Name          Notation              hl  le  lh\n"
+      << "  1  Kent          34-34.16-12-16-12-    16  12  a \n";
+}
+
+void remove_library()
+{
+  remove( filename );
+  remove( ( string(filename) + ".idx" ).c_str() );
+}
+
+void test_cclib_find_title(void)
+{
+  remove_library();
+  write_library();
+
+  cclib lib( filename );
+  RINGING_TEST( lib.good() );
+
+  library_entry le( lib.find( "Cambridge Surprise Minor" ) );
+  RINGING_TEST( !le.null() );
+  RINGING_TEST( le.meth() == method( "&-36-14-12-36-14-56,12", 6 ) );
+  RINGING_TEST( le.fullname() == "Cambridge Surprise Minor" );
+
+  le = lib.find( "Kent Treble Bob Minor" );
+  RINGING_TEST( !le.null() && le.bells() == 6 );
+  RINGING_TEST( le.meth() == method( "&34-34.16-12-16-12-16,12", 6 ) );
+
+  // The title must match exactly
+  RINGING_TEST( lib.find( "cambridge surprise minor" ).null() );
+  RINGING_TEST( lib.find( "Cambridge Surprise Major" ).null() );
+  RINGING_TEST( lib.find( "York Surprise Minor" ).null() );
+
+  remove_library();
+}
+
+void test_cclib_find_pn(void)
+{
+  remove_library();
+  write_library();
+
+  cclib lib( filename );
+  library_entry le
+    ( lib.find( method( "-36-14-12-36-34-56-34-36-12-14-36-12", 6 ) ) );
+  RINGING_TEST( !le.null() && le.fullname() == "Surfleet Surprise Minor" );
+  RINGING_TEST( lib.find( method( "&-1-1-1,2", 6 ) ).null() );
+
+  remove_library();
+}
+
+// The index written by the first lookup is used by the next library
+void test_cclib_index(void)
+{
+  remove_library();
+  write_library();
+
+  {
+    cclib lib( filename );
+    RINGING_TEST( !lib.find( "Beverley Surprise Minor" ).null() );
+  }
+  RINGING_TEST( ifstream( ( string(filename) + ".idx" ).c_str() ).good() );
+
+  cclib lib( filename );
+  for ( library::const_iterator i = lib.begin(), e = lib.end(); i != e; ++i )
+  {
+    library_entry le( lib.find( i->fullname() ) );
+    RINGING_TEST( !le.null() && le.meth() == i->meth()
+                  && le.name() == i->name() );
+  }
+
+  remove_library();
+}
+
+RINGING_END_ANON_NAMESPACE
+
+RINGING_START_TEST_FILE( cclib )
+
+  RINGING_REGISTER_TEST( test_cclib_find_title )
+  RINGING_REGISTER_TEST( test_cclib_find_pn )
+  RINGING_REGISTER_TEST( test_cclib_index )
+
+RINGING_END_TEST_FILE
+
+RINGING_END_NAMESPACE
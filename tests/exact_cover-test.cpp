@@ -0,0 +1,156 @@
+// -*- C++ -*- exact_cover-test.cpp - Tests for the exact cover solver
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/exact_cover.h>
+#include "test-base.h"
+#if RINGING_OLD_INCLUDES
+#include <algorithm.h>
+#else
+#include <algorithm>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+// Keeps each solution, sorted, and halts after LIMIT of them if non-zero
+class keep_solutions : public exact_cover::outputer
+{
+public:
+  explicit keep_solutions( size_t limit = 0 ) : limit(limit) {}
+
+  virtual bool operator()( vector<size_t> const& soln ) {
+    solns.push_back( soln );
+    sort( solns.back().begin(), solns.back().end() );
+    return solns.size() == limit;
+  }
+
+  size_t limit;
+  vector< vector<size_t> > solns;
+};
+
+void add( exact_cover& ec, char const* items )
+{
+  vector<size_t> v;
+  for ( ; *items; ++items ) v.push_back( *items - 'a' );
+  ec.add_option(v);
+}
+
+// The example in TAOCP 7.2.2.1, which has one solution
+void test_exact_cover_knuth(void)
+{
+  exact_cover ec(7);
+  add( ec, "ce" );  add( ec, "adg" );  add( ec, "bcf" );
+  add( ec, "adf" ); add( ec, "bg" );   add( ec, "deg" );
+  RINGING_TEST( ec.options() == 6 );
+
+  keep_solutions o;
+  RINGING_TEST( ec.solve(o) );
+
+  size_t const expected[3] = { 0, 3, 4 };
+  RINGING_TEST( o.solns.size() == 1
+                && o.solns[0] == vector<size_t>( expected, expected+3 ) );
+  RINGING_TEST( ec.node_count() > 0 );
+}
+
+// An item that is in no option can never be covered
+void test_exact_cover_none(void)
+{
+  exact_cover ec(3);
+  add( ec, "a" );  add( ec, "ab" );
+
+  keep_solutions o;
+  RINGING_TEST( ec.solve(o) );
+  RINGING_TEST( o.solns.empty() );
+}
+
+// Secondary items are covered at most once, but need not be covered
+void test_exact_cover_secondary(void)
+{
+  exact_cover ec(2, 1);
+  add( ec, "ac" );  add( ec, "bc" );  add( ec, "a" );  add( ec, "b" );
+
+  keep_solutions o;
+  RINGING_TEST( ec.solve(o) );
+  sort( o.solns.begin(), o.solns.end() );
+
+  // Not options 0 and 1 together, which both cover c
+  size_t const expected[3][2] = { { 0, 3 }, { 1, 2 }, { 2, 3 } };
+  RINGING_TEST( o.solns.size() == 3 );
+  for ( size_t i = 0; i < 3 && i < o.solns.size(); ++i )
+    RINGING_TEST( o.solns[i] 
+                  == vector<size_t>( expected[i], expected[i]+2 ) );
+
+  // The n queens problems, with the diagonals as secondary items
+  size_t const counts[7] = { 1, 0, 0, 2, 10, 4, 40 };
+  for ( size_t n = 1; n <= 7; ++n ) {
+    exact_cover q( 2*n, 4*n-2 );
+    for ( size_t r = 0; r < n; ++r )
+      for ( size_t f = 0; f < n; ++f ) {
+        size_t const items[4]
+          = { r, n + f, 2*n + r + f, 4*n-1 + r + n-1 - f };
+        q.add_option( items, items + 4 );
+      }
+
+    keep_solutions qo;
+    RINGING_TEST( q.solve(qo) );
+    RINGING_TEST( qo.solns.size() == counts[n-1] );
+  }
+}
+
+// The outputer can halt the search, and solve can be called again
+void test_exact_cover_halt(void)
+{
+  exact_cover ec(12, 22);
+  for ( size_t r = 0; r < 6; ++r )
+    for ( size_t f = 0; f < 6; ++f ) {
+      size_t const items[4] = { r, 6 + f, 12 + r + f, 23 + r + 5 - f };
+      ec.add_option( items, items + 4 );
+    }
+
+  keep_solutions all;
+  RINGING_TEST( ec.solve(all) );
+  RINGING_TEST( all.solns.size() == 4 );
+  RINGING_ULLONG const nodes = ec.node_count();
+
+  keep_solutions one(1);
+  RINGING_TEST( !ec.solve(one) );
+  RINGING_TEST( one.solns.size() == 1 );
+  RINGING_TEST( ec.node_count() <= nodes );
+
+  keep_solutions again;
+  RINGING_TEST( ec.solve(again) );
+  RINGING_TEST( again.solns == all.solns );
+  RINGING_TEST( ec.node_count() == nodes );
+}
+
+RINGING_END_ANON_NAMESPACE
+
+RINGING_START_TEST_FILE( exact_cover )
+
+  RINGING_REGISTER_TEST( test_exact_cover_knuth )
+  RINGING_REGISTER_TEST( test_exact_cover_none )
+  RINGING_REGISTER_TEST( test_exact_cover_secondary )
+  RINGING_REGISTER_TEST( test_exact_cover_halt )
+
+RINGING_END_TEST_FILE
+
+RINGING_END_NAMESPACE
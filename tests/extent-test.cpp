@@ -81,6 +81,48 @@ void test_extent_index(void)
       }
 }
 
+void test_extent_ranker(void)
+{
+  for ( unsigned nh=0; nh<3; ++nh )
+    for ( unsigned nw=0; nw<6; ++nw )
+      for ( unsigned nt=nh+nw; nt<nh+nw+3; ++nt )
+      {
+        extent_ranker rk(nw, nh, nt);
+        RINGING_TEST( rk.size() == factorial(nw) );
+
+        size_t n = 0;
+        vector<bell> v(nt);
+        for ( extent_iterator i(nw, nh, nt), e; i != e; ++i, ++n ) {
+          RINGING_TEST( rk.rank(*i) == n );
+          RINGING_TEST( rk.unrank(n) == *i );
+          RINGING_TEST( rk.unrank(n, &v[0]) == i->sign() );
+          RINGING_TEST( row(v) == *i );
+        }
+
+        vector<row> rows;
+        rk.unrank( 0, rk.size(), back_inserter(rows) );
+        RINGING_TEST( equal( rows.begin(), rows.end(), 
+                             extent_iterator(nw, nh, nt) ) );
+
+        vector<RINGING_ULLONG> ranks;
+        rk.rank( rows.begin(), rows.end(), back_inserter(ranks) );
+        for ( n = 0; n < ranks.size(); ++n )
+          RINGING_TEST( ranks[n] == n );
+
+        n = 0;
+        for ( incourse_extent_iterator i(nw, nh, nt), e; i != e; ++i, ++n ) {
+          RINGING_TEST( rk.rank_incourse(*i) == n );
+          RINGING_TEST( rk.unrank_incourse(n) == *i );
+        }
+      }
+
+  // Rows of more than 12 bells, whose ranks don't fit in 32 bits
+  extent_ranker rk(20);
+  row r( "0987654321ETABCDFGHJ" );
+  RINGING_TEST( rk.unrank( rk.rank(r) ) == r );
+  RINGING_TEST( rk.rank( row::rounds(20) ) == 0 );
+  RINGING_TEST( rk.rank( row::reverse_rounds(20) ) == rk.size() - 1 );
+}
 
 RINGING_END_ANON_NAMESPACE
   
@@ -89,6 +131,7 @@ RINGING_START_TEST_FILE( extent )
   RINGING_REGISTER_TEST( test_extent_length )
   RINGING_REGISTER_TEST( test_extent_fixed_bells )
   RINGING_REGISTER_TEST( test_extent_index )
+  RINGING_REGISTER_TEST( test_extent_ranker )
 
 RINGING_END_TEST_FILE
 
@@ -0,0 +1,140 @@
+// -*- C++ -*- methodset-test.cpp - Tests for the methodset class
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/methodset.h>
+#include <ringing/method.h>
+#include "test-base.h"
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+// The lookups methodset did before it had hash tables
+library_entry linear_find( methodset const& ms, method const& m )
+{
+  for ( library::const_iterator i = ms.begin(), e = ms.end(); i != e; ++i )
+    if ( i->meth() == m ) return *i;
+  return library_entry();
+}
+
+library_entry linear_find( methodset const& ms, string const& title )
+{
+  for ( library::const_iterator i = ms.begin(), e = ms.end(); i != e; ++i )
+    if ( i->fullname() == title ) return *i;
+  return library_entry();
+}
+
+bool same_entry( library_entry const& a, library_entry const& b )
+{
+  return a.null() ? b.null()
+    : !b.null() && a.meth() == b.meth() && a.name() == b.name();
+}
+
+// Methods that are equal however their place notation is written are
+// only stored once, keeping the first
+void test_methodset_dedup(void)
+{
+  methodset ms;
+  ms.append( method( "&-36-14-12-36-14-56,12", 6, "Cambridge" ) );
+  ms.append( method( "x36x14x12x36x14x56x14x36x12x14x36x12", 6, "Full" ) );
+  ms.append( method( "&x3x4x2x3x4x5,2", 6, "Implicit" ) );
+  ms.append( method( "-36-14-12-36-14-56-14-36-12-14-36-12", 6 ) );
+  RINGING_TEST( ms.size() == 1 );
+  RINGING_TEST( ms.begin()->name() == "Cambridge" );
+
+  // The same changes on a different number of bells are different
+  ms.append( method( "&-36-14-12-36-14-56,12", 8, "Cambridge" ) );
+  ms.append( method( "&-36-14-12-36-14-56,12", 8, "Again" ) );
+  RINGING_TEST( ms.size() == 2 );
+
+  // As are different methods with the same name
+  ms.append( method( "&-36-14-12-36-14-56,12", 6, "Cambridge" ) );
+  ms.append( method( "&-34-14-12-36-14-56,12", 6, "Cambridge" ) );
+  RINGING_TEST( ms.size() == 3 );
+
+  // Appending a library entry does the same
+  methodset ms2;
+  ms2.append( ms.begin(), ms.end() );
+  ms2.append( ms.begin(), ms.end() );
+  RINGING_TEST( ms2.size() == 3 );
+}
+
+void test_methodset_find_pn(void)
+{
+  methodset ms;
+  ms.append( method( "&-36-14-12-36-14-56,12", 6, "Cambridge" ) );
+  ms.append( method( "&x16x16x16,12", 6, "Plain" ) );
+  ms.append( method( "&-5-4.5-5.36.4-4.5-4-1,8", 8, "Bristol" ) );
+
+  char const* const pns[] = {
+    "x36x14x12x36x14x56x14x36x12x14x36x12", "&x3x4x2x3x4x5,2",
+    "-16-16-16-16-16-12", "&-1-1-1,2", "&x16x16x16,16",
+    "&x58x14.58x58.36.14x14.58x14x18,18", "&-5-4.5-5.36.4-4.5-4-1,8", NULL };
+  int const bells[] = { 6, 6, 6, 6, 6, 8, 8 };
+
+  for ( int i = 0; pns[i]; ++i ) {
+    method const m( pns[i], bells[i] );
+    RINGING_TEST( same_entry( ms.find(m), linear_find(ms, m) ) );
+  }
+  RINGING_TEST( ms.find( method( "&x3x4x2x3x4x5,2", 6 ) ).name()
+                == "Cambridge" );
+  RINGING_TEST( ms.find( method( "&-1-1-1,2", 8 ) ).null() );
+}
+
+// Several methods can have the same title; the first in the set is found
+void test_methodset_find_title(void)
+{
+  methodset ms;
+  ms.append( method( "&x14x16x16,12", 6, "Foo" ) );
+  RINGING_TEST( ms.find( string("Foo Bob Minor") ).meth()
+                == method( "&x14x16x16,12", 6 ) );
+
+  ms.append( method( "&x16x16x16,12", 6, "Foo" ) );
+  ms.append( method( "&-36-14-12-36-14-56,12", 6, "Cambridge" ) );
+
+  char const* const titles[] = { "Foo Bob Minor", "Cambridge Surprise Minor",
+    "Cambridge Surprise Major", "foo bob minor", "Foo", NULL };
+  for ( int i = 0; titles[i]; ++i )
+    RINGING_TEST( same_entry( ms.find( string(titles[i]) ),
+                              linear_find( ms, string(titles[i]) ) ) );
+
+  RINGING_TEST( ms.find( string("Foo Bob Minor") ).meth()
+                == method( "&x16x16x16,12", 6 ) );
+  RINGING_TEST( ms.find( string("Cambridge Surprise Major") ).null() );
+
+  // The tables are emptied with the set
+  ms.clear();
+  RINGING_TEST( ms.size() == 0 );
+  RINGING_TEST( ms.find( string("Foo Bob Minor") ).null() );
+  RINGING_TEST( ms.find( method( "&x16x16x16,12", 6 ) ).null() );
+}
+
+RINGING_END_ANON_NAMESPACE
+
+RINGING_START_TEST_FILE( methodset )
+
+  RINGING_REGISTER_TEST( test_methodset_dedup )
+  RINGING_REGISTER_TEST( test_methodset_find_pn )
+  RINGING_REGISTER_TEST( test_methodset_find_title )
+
+RINGING_END_TEST_FILE
+
+RINGING_END_NAMESPACE
@@ -31,6 +31,11 @@ int test_main()
   RINGING_RUN_TEST_FILE( method )
   RINGING_RUN_TEST_FILE( music )
   RINGING_RUN_TEST_FILE( extent )
+  RINGING_RUN_TEST_FILE( exact_cover )
+  RINGING_RUN_TEST_FILE( cclib )
+  RINGING_RUN_TEST_FILE( binlib )
+  RINGING_RUN_TEST_FILE( methodset )
+  RINGING_RUN_TEST_FILE( xmlreader )
 
   RINGING_USING_TEST
   if ( run_tests( true ) ) 
@@ -0,0 +1,228 @@
+// -*- C++ -*- xmlreader-test.cpp - Tests for the XML pull parser
+// Copyright (C) 2026 The Ringing Class Library authors
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// $Id$
+
+#include <ringing/xmlreader.h>
+#include <ringing/xmllib.h>
+#include <ringing/method.h>
+#include "test-base.h"
+#if RINGING_OLD_INCLUDES
+#include <fstream.h>
+#else
+#include <fstream>
+#endif
+#if RINGING_USE_STRINGSTREAM
+#if RINGING_OLD_INCLUDES
+#include <sstream.h>
+#else
+#include <sstream>
+#endif
+#else
+#if RINGING_OLD_INCLUDES
+#include <strstream.h>
+#else
+#include <strstream>
+#endif
+#endif
+#if RINGING_OLD_C_INCLUDES
+#include <stdio.h>
+#else
+#include <cstdio>
+#endif
+
+RINGING_START_NAMESPACE
+
+RINGING_USING_STD
+
+RINGING_START_ANON_NAMESPACE
+
+// Reads a whole document, writing each token in a compact form:
+// <name a=v ...> for start elements, </name> for end elements, and
+// [text] for text, each followed by its depth if DEPTHS is set.
+string tokens( string const& doc, bool depths = false )
+{
+#if RINGING_USE_STRINGSTREAM
+  istringstream in( doc );
+#else
+  istrstream in( doc.c_str(), doc.size() );
+#endif
+  xml_reader r( in );
+
+  string out;
+  while (true) {
+    xml_reader::token_type t = r.next();
+    if ( depths ) out += char( '0' + r.depth() );
+
+    switch ( t ) {
+    case xml_reader::start_element:
+      out += '<'; out += r.name();
+      for ( xml_reader::attributes::const_iterator
+              i = r.attrs().begin(), e = r.attrs().end(); i != e; ++i )
+        out += ' ' + i->first + '=' + i->second;
+      out += '>';
+      break;
+
+    case xml_reader::end_element:
+      out += "</" + r.name() + '>';
+      break;
+
+    case xml_reader::text:
+      out += '[' + r.value() + ']';
+      break;
+
+    case xml_reader::end_of_document:
+      return out;
+    }
+  }
+}
+
+void test_xmlreader_elements(void)
+{
+  RINGING_TEST( tokens( "<a/>" ) == "<a></a>" );
+  RINGING_TEST( tokens( "<a>x</a>" ) == "<a>[x]</a>" );
+  RINGING_TEST( tokens( "<?xml version='1.0'?>\n<!-- c -->\n<a>x</a>\n" )
+                == "<a>[x]</a>" );
+  RINGING_TEST( tokens( "\xEF\xBB\xBF<a/>" ) == "<a></a>" );
+  RINGING_TEST( tokens( "<!DOCTYPE a [ <!ENTITY e '>'> ]><a/>" )
+                == "<a></a>" );
+  RINGING_TEST( tokens( "<ns:a>x<!-- y -->z<?pi?></ns:a>" )
+                == "<ns:a>[x][z]</ns:a>" );
+  RINGING_TEST( tokens( "<a>x\r\ny\rz</a>" ) == "<a>[x\ny\nz]</a>" );
+}
+
+void test_xmlreader_nesting(void)
+{
+  RINGING_TEST( tokens( "<a><b><c/>x</b><b>y</b></a>" )
+                == "<a><b><c></c>[x]</b><b>[y]</b></a>" );
+
+  // The depth of an end element is that of its start element
+  RINGING_TEST( tokens( "<a><b><c/></b> </a>", true )
+                == "1<a>2<b>3<c>3</c>2</b>1[ ]1</a>0" );
+}
+
+void test_xmlreader_attributes(void)
+{
+  RINGING_TEST( tokens( "<a x=\"1\" y='2'/>" ) == "<a x=1 y=2></a>" );
+  RINGING_TEST( tokens( "<a  x = '1'\n\ty=\"it's\" ></a>" )
+                == "<a x=1 y=it's></a>" );
+  RINGING_TEST( tokens( "<a x='&lt;&amp;&gt;' y=\"&quot;&apos;\"/>" )
+                == "<a x=<&> y=\"'></a>" );
+  RINGING_TEST( tokens( "<a x=''/>" ) == "<a x=></a>" );
+}
+
+void test_xmlreader_entities(void)
+{
+  RINGING_TEST( tokens( "<a>&lt;&gt;&amp;&quot;&apos;</a>" )
+                == "<a>[<>&\"']</a>" );
+  RINGING_TEST( tokens( "<a>&#65;&#x42;&#x3b1;&#x20AC;&#x1F514;</a>" )
+                == "<a>[AB\xCE\xB1\xE2\x82\xAC\xF0\x9F\x94\x94]</a>" );
+}
+
+void test_xmlreader_cdata(void)
+{
+  RINGING_TEST( tokens( "<a><![CDATA[<b>&amp;</b>]]></a>" )
+                == "<a>[<b>&amp;</b>]</a>" );
+  RINGING_TEST( tokens( "<a>x<![CDATA[]]]]><![CDATA[>]]>y</a>" )
+                == "<a>[x][]]][>][y]</a>" );
+  RINGING_TEST( tokens( "<a><![CDATA[]] ] ]]></a>" ) == "<a>[]] ] ]</a>" );
+}
+
+// Malformed documents throw rather than crash or loop
+void test_xmlreader_malformed(void)
+{
+  char const* const docs[] = {
+    "", "  ", "text", "<a>", "<a>x", "<a></b>", "<a><b></a></b>",
+    "</a>", "<a/><b/>", "<a/>x", "<a x=1/>", "<a x='1'y='2'/>",
+    "<a x='1/>", "<a x='<'/>", "<a x/>", "<a>&foo;</a>", "<a>&lt</a>",
+    "<a>&#0;</a>", "<a>&#x110000;</a>", "<a>&#12x;</a>", "<a>&</a>",
+    "<a><![CDATA[x</a>", "<a><![CDAT[x]]></a>", "<![CDATA[x]]><a/>",
+    "<a><!-- x</a>", "<?xml", "<!DOCTYPE a", "<a/><!DOCTYPE a>",
+    "<a><!DOCTYPE a></a>", "\xEF\xBB<a/>", "<>", "<a/ >", "<a></ >",
+    NULL };
+
+  for ( int i = 0; docs[i]; ++i )
+    RINGING_TEST_THROWS( tokens( docs[i] ), runtime_error );
+}
+
+char const* const filename = "xmlreader-test.tmp";
+
+void write_library()
+{
+  ofstream out( filename );
+  out << "<?xml version='1.0'?>\n"
+      << "<methods>\n"
+      << "  <method><name>Cambridge</name>\n"
+      << "    <title>Cambridge Surprise Minor</title><stage>6</stage>\n"
+      << "    <pn><block>&amp;-36-14-12-36-14-56,12</block></pn></method>\n"
+      << "  <method><name>Plain</name>\n"
+      << "    <title>Plain Bob Minor</title><stage>6</stage>\n"
+      << "    <pn><block>&amp;x16x16x16,12</block></pn></method>\n"
+      << "  <method><name>Bristol</name>\n"
+      << "    <title>Bristol Surprise Major</title><stage>8</stage>\n"
+      << "    <pn><block>&amp;-5-4.5-5.36.4-4.5-4-1,8</block></pn></method>\n"
+      << "</methods>\n";
+}
+
+// Each iterator over a file has its own parser, so one does not move
+// another
+void test_xmlreader_xmllib_iterators(void)
+{
+  write_library();
+
+  xmllib lib( xmllib::filename, filename );
+  RINGING_TEST( lib.good() );
+
+  library::const_iterator i = lib.begin(), e = lib.end();
+  RINGING_TEST( i != e && i->name() == "Cambridge Surprise Minor" );
+  ++i;
+  RINGING_TEST( i != e && i->name() == "Plain Bob Minor" );
+
+  library::const_iterator j = lib.begin();
+  RINGING_TEST( j != e && j->name() == "Cambridge Surprise Minor" );
+  RINGING_TEST( j->meth() == method( "&-36-14-12-36-14-56,12", 6 ) );
+  RINGING_TEST( i->name() == "Plain Bob Minor" );
+
+  // Nor does a lookup, which iterates over the library
+  library_entry le( lib.find( method( "&-5-4.5-5.36.4-4.5-4-1,8", 8 ) ) );
+  RINGING_TEST( !le.null() && le.name() == "Bristol Surprise Major" );
+  RINGING_TEST( i->meth() == method( "&x16x16x16,12", 6 ) );
+
+  ++i; ++j;
+  RINGING_TEST( i != e && i->name() == "Bristol Surprise Major" );
+  RINGING_TEST( j != e && j->name() == "Plain Bob Minor" );
+  ++i; ++j; ++j;
+  RINGING_TEST( i == e && j == e );
+
+  remove( filename );
+}
+
+RINGING_END_ANON_NAMESPACE
+
+RINGING_START_TEST_FILE( xmlreader )
+
+  RINGING_REGISTER_TEST( test_xmlreader_elements )
+  RINGING_REGISTER_TEST( test_xmlreader_nesting )
+  RINGING_REGISTER_TEST( test_xmlreader_attributes )
+  RINGING_REGISTER_TEST( test_xmlreader_entities )
+  RINGING_REGISTER_TEST( test_xmlreader_cdata )
+  RINGING_REGISTER_TEST( test_xmlreader_malformed )
+  RINGING_REGISTER_TEST( test_xmlreader_xmllib_iterators )
+
+RINGING_END_TEST_FILE
+
+RINGING_END_NAMESPACE